@@ -24,46 +24,77 @@
 #include "annotation.hpp"
 
 namespace ecglib {
-	void get_annotations(const ecgdata::annotationset &pm, const ecglib::annotation_type &typ, std::vector<annotation> &out) {
-		typedef ecglib::ecgdata::const_pointiterator piter;
-		piter pend = pm.end();
-		for(piter pi = pm.begin(); pi != pend; ++pi) {
-			if(pi->second.type() == typ) {
-				out.push_back(pi->second);
+	std::shared_ptr<const annotationset::typeindex> annotationset::index() const {
+		std::shared_ptr<const typeindex> idx = std::atomic_load(&_index);
+		if(idx) {
+			return idx;
+		}
+
+		// counting sort of the positions by type, the positions of a type stay in location order
+		std::shared_ptr<typeindex> built = std::make_shared<typeindex>();
+		built->mask = 0;
+		built->start.fill(0);
+		for(auto &v : _annset) {
+			int t = static_cast<int>(v.second.type().index);
+			if(t >= 0 && t < ntypes) {
+				++built->start[t+1];
+				built->mask |= typemask(1) << t;
 			}
 		}
-	}
+		for(int t = 0; t < ntypes; ++t) {
+			built->start[t+1] += built->start[t];
+		}
 
-	void get_annotations(const ecgdata::pointmap &pm, const ecglib::annotation_type &typ, std::vector<annotation> &out) {
-		typedef ecglib::ecgdata::const_pointmapiterator pmiter;
+		built->pos.resize(built->start[ntypes]);
+		std::array<std::uint32_t, ntypes + 1> next = built->start;
+		for(std::size_t i = 0; i < _annset.size(); ++i) {
+			int t = static_cast<int>(_annset[i].second.type().index);
+			if(t >= 0 && t < ntypes) {
+				built->pos[next[t]++] = static_cast<std::uint32_t>(i);
+			}
+		}
 
-		pmiter pmend = pm.end();
+		// concurrent callers may build it at the same time, they build the same index
+		idx = built;
+		std::atomic_store(&_index, idx);
 
-		for(pmiter pmi = pm.begin(); pmi != pmend; ++pmi) {
-			typedef ecglib::ecgdata::const_pointiterator piter;
+		return idx;
+	}
 
-			piter pend = pmi->second.end();
-			for(piter pi = pmi->second.begin(); pi != pend; ++pi) {
-				if(pi->second.type() == typ) {
-					out.push_back(pi->second);
+	void annotationset::get(const annotation_type &typ, std::vector<annotation> &out) const {
+		int t = static_cast<int>(typ.index);
+		if(t < 0 || t >= ntypes) {
+			for(auto &v : _annset) {
+				if(v.second.type() == typ) {
+					out.push_back(v.second);
 				}
 			}
+			return;
 		}
-	}
 
-	ecgdata::annotationset rebase(const ecgdata::annotationset &ann, const int newstart) {
-		typedef ecgdata::const_pointiterator piter;
+		std::shared_ptr<const typeindex> idx = index();
+		for(std::uint32_t k = idx->start[t]; k < idx->start[t+1]; ++k) {
+			out.push_back(_annset[idx->pos[k]].second);
+		}
+	}
 
-		piter pend = ann.end();
+	void get_annotations(const ecgdata::annotationset &pm, const ecglib::annotation_type &typ, std::vector<annotation> &out) {
+		pm.get(typ, out);
+	}
 
-		ecgdata::annotationset rebased;
+	void get_annotations(const ecgdata::pointmap &pm, const ecglib::annotation_type &typ, std::vector<annotation> &out) {
+		typedef ecglib::ecgdata::const_pointmapiterator pmiter;
 
-		for(piter pi = ann.begin(); pi != pend; ++pi) {
-			ecglib::annotation newann = pi->second;
-			newann.location(newann.location()-newstart);
+		pmiter pmend = pm.end();
 
-			rebased[newann.location()] = newann;
+		for(pmiter pmi = pm.begin(); pmi != pmend; ++pmi) {
+			pmi->second.get(typ, out);
 		}
+	}
+
+	ecgdata::annotationset rebase(const ecgdata::annotationset &ann, const int newstart) {
+		ecgdata::annotationset rebased(ann);
+		rebased.rebase(newstart);
 
 		return rebased;
 	}
@@ -73,7 +104,7 @@ namespace ecglib {
 	
 		pmiter pmend = pm.end();
 		for(pmiter pmi = pm.begin(); pmi != pmend; ++pmi) {
-			pmi->second = rebase(pmi->second, newstart);
+			pmi->second.rebase(newstart);
 		}
 	}
 
@@ -81,10 +112,6 @@ namespace ecglib {
 		auto pmi = pm.find(l);
 		if (pmi == pm.end()) return;
 
-		for(auto &anniter : pmi->second) {
-			if(anniter.second.type() == typ) {
-				anns.push_back(anniter.second);
-			}
-		}
+		pmi->second.get(typ, anns);
 	}
 }
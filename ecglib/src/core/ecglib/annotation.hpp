@@ -27,9 +27,16 @@
 #include <ecglib/ecglib.hpp>
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
 #include <vector>
 #include <string>
 #include <map>
+#include <sstream>
+#include <utility>
 
 #include <armadillo>
 
@@ -250,11 +257,21 @@ namespace ecglib {
 
 	/**
 	 * @brief Annotationset class - contains annotations for a lead
+	 *
+	 * The annotations are kept in one contiguous vector of (location, annotation) pairs sorted by location, with at most
+	 * one annotation per location. Iteration, lower_bound/upper_bound and find work as for a std::map<timems, annotation>,
+	 * but without a heap node per annotation. Appending after the last annotation is amortized O(1), inserting in the middle
+	 * is O(n) (use insert(first, last) for many annotations). As for a vector, inserting or erasing invalidates iterators
+	 * at and after the position. The location (first) of an element must not be changed through an iterator.
+	 * Type queries (hastype, count, get, types) use an index that every non-const access drops, so the type of an annotation must
+	 * not be changed through a reference or iterator taken before the last type query; use type(idx, typ) for that.
 	 */
 	class annotationset {
 		public:
-			typedef std::map<timems, annotation>::iterator iterator;			/** @brief iterator for annotationset */
-			typedef std::map<timems, annotation>::const_iterator const_iterator;		/** @brief constant iterator for annotationset */
+			typedef std::pair<timems, annotation> value_type;				/**< @brief location and annotation */
+			typedef std::vector<value_type>::iterator iterator;				/**< @brief iterator for annotationset */
+			typedef std::vector<value_type>::const_iterator const_iterator;			/**< @brief constant iterator for annotationset */
+			typedef std::uint32_t typemask;							/**< @brief set of annotation types, bit i for annotation_type index i */
 
 		public:
 			/**
@@ -263,16 +280,68 @@ namespace ecglib {
 			annotationset() {
 			}
 
+			/**
+			* @brief Copies a range of another annotationset
+			*
+			* @param first First annotation
+			* @param last One past the last annotation
+			*/
+			annotationset(const_iterator first, const_iterator last) : _annset(first, last) {
+			}
+
+			/**
+			* @brief Copy constructor
+			*
+			* @param other Annotation set to copy
+			*/
+			annotationset(const annotationset &other) = default;
+
+			/**
+			* @brief Move constructor
+			*
+			* @param other Annotation set to move from, empty afterwards
+			*/
+			annotationset(annotationset &&other) noexcept = default;
+
+			/**
+			* @brief Copy assignment
+			*
+			* @param other Annotation set to copy
+			*
+			* @return This annotationset
+			*/
+			annotationset& operator=(const annotationset &other) = default;
+
+			/**
+			* @brief Move assignment
+			*
+			* @param other Annotation set to move from, empty afterwards
+			*
+			* @return This annotationset
+			*/
+			annotationset& operator=(annotationset &&other) noexcept = default;
+
 		public:
 			/**
-			* @brief Retrieve annotation at location idx
+			* @brief Retrieve annotation at location idx, an empty annotation is inserted if there is none
 			*
 			* @param idx Time location in ms
 			*
-			* @return Annotation copy
+			* @return Reference to the annotation, valid until the next insert or erase
 			*/
 			annotation& operator[](const timems idx) {
-				return _annset[idx];
+				invalidate();
+				if(_annset.empty() || _annset.back().first < idx) {
+					_annset.push_back(value_type(idx, annotation()));
+					return _annset.back().second;
+				}
+
+				iterator it = lower_bound(idx);
+				if(it == _annset.end() || it->first != idx) {
+					it = _annset.insert(it, value_type(idx, annotation()));
+				}
+
+				return it->second;
 			}
 
 			/**
@@ -283,7 +352,7 @@ namespace ecglib {
 			* @return Constant reference to annotation 
 			*/
 			const annotation& operator[](const timems idx) const {
-				const_iterator iter = _annset.find(idx);
+				const_iterator iter = find(idx);
 
 				if(iter == _annset.end()) {
 					std::stringstream ss;
@@ -301,6 +370,7 @@ namespace ecglib {
 			* @return Iterator to start of map
 			*/
 			iterator begin() {
+				invalidate();
 				return _annset.begin();
 			}
 
@@ -310,6 +380,7 @@ namespace ecglib {
 			* @return Iterator to end of map
 			*/
 			iterator end() {
+				invalidate();
 				return _annset.end();
 			}
 
@@ -321,7 +392,8 @@ namespace ecglib {
 			* @return iterator pointing to first element including idx
 			*/
 			iterator lower_bound(const timems idx) {
-				return _annset.lower_bound(idx);
+				invalidate();
+				return std::lower_bound(_annset.begin(), _annset.end(), idx, before);
 			}
 
 			/**
@@ -332,7 +404,27 @@ namespace ecglib {
 			* @return iterator pointing to second element including idx
 			*/
 			iterator upper_bound(const timems idx) {
-				return _annset.upper_bound(idx);
+				invalidate();
+				return std::upper_bound(_annset.begin(), _annset.end(), idx, after);
+			}
+
+			/**
+			* @brief Changes the type of the annotation at location idx, the type index is rebuilt on the next type query
+			*
+			* @param idx Time location in ms, there has to be an annotation
+			* @param typ New type
+			*/
+			void type(const timems idx, const annotation_type &typ) {
+				iterator it = find(idx);
+
+				if(it == _annset.end()) {
+					std::stringstream ss;
+					ss << "No annotation at: " << idx;
+					std::cerr << ss.str();
+					throw std::logic_error(ss.str());
+				}
+
+				it->second.type(typ);
 			}
 
 			/**
@@ -361,7 +453,7 @@ namespace ecglib {
 			* @return Lower bound const iterator
 			*/
 			const_iterator lower_bound(const timems idx) const {
-				return _annset.lower_bound(idx);
+				return std::lower_bound(_annset.begin(), _annset.end(), idx, before);
 			}
 
 			/**
@@ -372,7 +464,7 @@ namespace ecglib {
 			* @return Upper bound const iterator
 			*/
 			const_iterator upper_bound(const timems idx) const {
-				return _annset.upper_bound(idx);
+				return std::upper_bound(_annset.begin(), _annset.end(), idx, after);
 			}
 
 			/**
@@ -383,7 +475,10 @@ namespace ecglib {
 			* @return Iterator pointing to element
 			*/
 			iterator find(timems idx) {
-				return _annset.find(idx);
+				invalidate();
+				iterator it = lower_bound(idx);
+
+				return (it != _annset.end() && it->first == idx) ? it : _annset.end();
 			}
 
 			/**
@@ -394,7 +489,9 @@ namespace ecglib {
 			* @return Const iterator to annotation
 			*/
 			const_iterator find(timems idx) const {
-				return _annset.find(idx);
+				const_iterator it = lower_bound(idx);
+
+				return (it != _annset.end() && it->first == idx) ? it : _annset.end();
 			}
 
 			/**
@@ -406,10 +503,29 @@ namespace ecglib {
 				return _annset.size();
 			}
 
+			/**
+			* @brief True if there are no annotations
+			*
+			* @return Empty
+			*/
+			bool empty() const {
+				return _annset.empty();
+			}
+
+			/**
+			* @brief Reserves space for n annotations
+			*
+			* @param n Number of annotations
+			*/
+			void reserve(const std::size_t n) {
+				_annset.reserve(n);
+			}
+
 			/**
 			* @brief Clear map
 			*/
 			void clear() {
+				invalidate();
 				_annset.clear();
 			}
 
@@ -421,7 +537,8 @@ namespace ecglib {
 			* @return 1 if successful, otherwise 0
 			*/
 			std::size_t erase(timems idx) {
-				iterator it = _annset.find(idx);
+				invalidate();
+				iterator it = find(idx);
 
 				if(it == _annset.end()) {
 					return 0;
@@ -440,89 +557,480 @@ namespace ecglib {
 			* @return True if successful
 			*/
 			bool erase(iterator it) {
+				invalidate();
 				_annset.erase(it);
 
 				return 1;
 			}
 
 			/**
-			* @brief Remove annotation if PRED is true
+			* @brief Erase the annotations in [first, last)
+			*
+			* @param first First annotation to erase
+			* @param last One past the last annotation to erase
+			*
+			* @return Iterator following the erased annotations
+			*/
+			iterator erase(iterator first, iterator last) {
+				invalidate();
+				return _annset.erase(first, last);
+			}
+
+			/**
+			* @brief Remove annotation if PRED is true, in one pass
 			*
 			* @tparam PRED Predicate function
-			* @param pred Predicate function
+			* @param pred Predicate function, called with a value_type
 			*
 			* @return Iterator pointing to new end
 			*/
 			template<typename PRED>
-			iterator remove_if(PRED &pred) {
-				iterator it = begin();
-				iterator endit = end();
-
-				while(it != endit) {
-					if(pred(*it)) {
-						erase(it++);
-					} else {
-						++it;
-					}
+			iterator remove_if(PRED &&pred) {
+				invalidate();
+				_annset.erase(std::remove_if(_annset.begin(), _annset.end(), std::forward<PRED>(pred)), _annset.end());
+
+				return _annset.end();
+			}
+
+			/**
+			* @brief Subtracts newstart from every location in place, e.g. after chopping an ECG
+			*
+			* One linear pass, the order is kept without re-sorting. Locations are unsigned, so locations before newstart wrap around
+			* as in rebase(const annotationset&, int); the wrapped run is rotated into place. The type index stays valid.
+			*
+			* @param newstart New start in ms
+			*/
+			void rebase(const int newstart) {
+				const timems d = static_cast<timems>(newstart);
+				for(auto &v : _annset) {
+					v.first -= d;
+					v.second.location(v.second.location() - d);
+				}
+
+				std::vector<value_type>::iterator split = std::is_sorted_until(_annset.begin(), _annset.end(), ordered);
+				if(split != _annset.end()) {
+					std::rotate(_annset.begin(), split, _annset.end());
+					invalidate();
+				}
+			}
+
+			/**
+			* @brief Keeps only the annotations in [first, last], in place
+			*
+			* @param first First location kept
+			* @param last Last location kept
+			*/
+			void clip(const timems first, const timems last) {
+				invalidate();
+				if(first > last) {
+					_annset.clear();
+					return;
 				}
 
-				return it;
+				_annset.erase(std::upper_bound(_annset.begin(), _annset.end(), last, after), _annset.end());
+				_annset.erase(_annset.begin(), std::lower_bound(_annset.begin(), _annset.end(), first, before));
 			}
 
 			/**
-			* @brief Insert from another map container of annotations
+			* @brief Insert from another map container of annotations, annotations at locations that are already set are not inserted
 			*
-			* @tparam INPUT_ITER Iterator type for other container
+			* The new annotations are sorted and merged with the existing ones in O(n log n) instead of being inserted one by one.
+			*
+			* @tparam INPUT_ITER Iterator type for other container, the value has to be convertible to value_type
 			* @param a1 Start iterator
 			* @param a2 Stop iterator
 			*
-			* @return Iterator pointing at the inserted item
+			* @return Iterator pointing at the last item of the range
 			*/
 			template<typename INPUT_ITER>
 			iterator insert(INPUT_ITER a1, INPUT_ITER a2) {
-				iterator ret;
+				invalidate();
+				if(a1 == a2) {
+					return _annset.end();
+				}
 
+				const std::size_t old = _annset.size();
+				timems lastidx = 0;
 				while(a1 != a2) {
-					ret = _annset.insert(*a1).first;
+					_annset.push_back(value_type(*a1));
+					lastidx = _annset.back().first;
 
 					++a1;
 				}
 
-				return ret;
+				// sort the new part (first of equal locations wins) and merge it after the existing annotations of equal location
+				iterator mid = _annset.begin() + old;
+				std::stable_sort(mid, _annset.end(), ordered);
+				std::inplace_merge(_annset.begin(), mid, _annset.end(), ordered);
+				_annset.erase(std::unique(_annset.begin(), _annset.end(), same), _annset.end());
+
+				return find(lastidx);
 			}
 
+			/**
+			* @brief Types of the annotations in the set
+			*
+			* @return Bitmask, bit i set if there is an annotation of type index i
+			*/
+			typemask types() const {
+				return index()->mask;
+			}
+
+			/**
+			* @brief True if the set has an annotation of a type, O(1) once the index is built
+			*
+			* @param typ Annotation type
+			*
+			* @return Has the type
+			*/
+			bool hastype(const annotation_type &typ) const {
+				int t = static_cast<int>(typ.index);
+				return t >= 0 && t < ntypes ? (types() >> t) & 1u : std::any_of(_annset.begin(), _annset.end(), [&typ](const value_type &v) { return v.second.type() == typ; });
+			}
+
+			/**
+			* @brief Number of annotations of a type
+			*
+			* @param typ Annotation type
+			*
+			* @return Count
+			*/
+			std::size_t count(const annotation_type &typ) const {
+				int t = static_cast<int>(typ.index);
+				if(t < 0 || t >= ntypes) {
+					return std::count_if(_annset.begin(), _annset.end(), [&typ](const value_type &v) { return v.second.type() == typ; });
+				}
+
+				std::shared_ptr<const typeindex> idx = index();
+				return idx->start[t+1] - idx->start[t];
+			}
+
+			/**
+			* @brief Appends the annotations of a type in location order, O(k) in the number of results once the index is built
+			*
+			* @param typ Annotation type
+			* @param[out] out Annotations are appended
+			*/
+			void get(const annotation_type &typ, std::vector<annotation> &out) const;
+
 		private:
 			/**
-			* @brief Annotation map
+			* @brief Number of annotation type indices covered by the index (0..annotation_type::UNKNOWN)
 			*/
-			std::map<timems, annotation> _annset;
+			static const int ntypes = annotation_type::UNKNOWN + 1;
+
+			/**
+			* @brief Positions of the annotations grouped by type
+			*/
+			struct typeindex {
+				typemask mask;					/**< @brief types present */
+				std::array<std::uint32_t, ntypes + 1> start;	/**< @brief positions of type t are pos[start[t]..start[t+1]) */
+				std::vector<std::uint32_t> pos;			/**< @brief positions in _annset, in location order per type */
+			};
+
+			/**
+			* @brief Index of the set, built if needed (safe for concurrent const callers)
+			*
+			* @return Index
+			*/
+			std::shared_ptr<const typeindex> index() const;
+
+			/**
+			* @brief Drops the index, called by every non-const access
+			*/
+			void invalidate() {
+				_index.reset();
+			}
+
+			/**
+			* @brief Orders elements by location
+			*/
+			static bool ordered(const value_type &a, const value_type &b) {
+				return a.first < b.first;
+			}
+
+			/**
+			* @brief Elements at the same location
+			*/
+			static bool same(const value_type &a, const value_type &b) {
+				return a.first == b.first;
+			}
+
+			/**
+			* @brief Element before a location (lower_bound)
+			*/
+			static bool before(const value_type &a, const timems idx) {
+				return a.first < idx;
+			}
+
+			/**
+			* @brief Location before an element (upper_bound)
+			*/
+			static bool after(const timems idx, const value_type &a) {
+				return idx < a.first;
+			}
+
+			/**
+			* @brief Annotations sorted by location
+			*/
+			std::vector<value_type> _annset;
+
+			/**
+			* @brief Type index, nullptr until the first type query after a change
+			*/
+			mutable std::shared_ptr<const typeindex> _index;
 	};
 
 	/**
 	 * @brief Pointmap, links annotationsets with ecgleads
+	 *
+	 * Lead numbers are a small dense range starting at GLOBAL_LEAD, so the annotationsets are kept in a vector of slots indexed by
+	 * lead+1, instead of a tree. Each slot owns its set through a pointer, nullptr if the lead is not present. operator[], find and
+	 * erase are O(1), iteration visits the present leads in ascending order as for a std::map<leadnumber, annotationset>.
+	 * The vector grows to the largest lead number used; the sets do not move when it grows, so references stay valid as for a map,
+	 * and moving a pointmap does not allocate.
+	 * The lead number (first) of an element must not be changed through an iterator.
 	 */
 	class pointmap {
 		public:
-			typedef std::map<leadnumber, annotationset>::iterator iterator;			/**< @brief iterator for pointmap */
-			typedef std::map<leadnumber, annotationset>::const_iterator const_iterator;	/**< @brief const iterator for pointmap */
+			typedef std::pair<leadnumber, annotationset> value_type;			/**< @brief lead number and annotations */
+
+		private:
+			/**
+			* @brief Iterator over the present slots of a pointmap
+			*
+			* @tparam PM Pointmap, const for a const iterator
+			* @tparam V Value, const for a const iterator
+			*/
+			template<class PM, class V>
+			class slotiterator {
+				public:
+					typedef std::bidirectional_iterator_tag iterator_category;	/**< @brief bidirectional as a map iterator */
+					typedef V value_type;						/**< @brief lead number and annotations */
+					typedef std::ptrdiff_t difference_type;				/**< @brief difference */
+					typedef V* pointer;						/**< @brief pointer */
+					typedef V& reference;						/**< @brief reference */
+
+					/**
+					* @brief Singular iterator
+					*/
+					slotiterator() : _pm(nullptr), _slot(0) {
+					}
+
+					/**
+					* @brief Iterator at the first present slot at or after slot
+					*
+					* @param pm Pointmap
+					* @param slot Slot
+					*/
+					slotiterator(PM *pm, std::size_t slot) : _pm(pm), _slot(slot) {
+						while(_slot < _pm->_sets.size() && !_pm->_sets[_slot]) {
+							++_slot;
+						}
+					}
+
+					/**
+					* @brief Converts an iterator into a const iterator
+					*
+					* @param other Iterator
+					*/
+					template<class Q, class W, class = typename std::enable_if<std::is_convertible<W*, V*>::value>::type>
+					slotiterator(const slotiterator<Q, W> &other) : _pm(other._pm), _slot(other._slot) {
+					}
+
+					/**
+					* @brief Current lead and annotations
+					*
+					* @return Reference to the element
+					*/
+					V& operator*() const {
+						return *_pm->_sets[_slot];
+					}
+
+					/**
+					* @brief Member access of the current element
+					*
+					* @return Pointer to the element
+					*/
+					V* operator->() const {
+						return _pm->_sets[_slot].get();
+					}
+
+					/**
+					* @brief Moves to the next present lead
+					*
+					* @return This iterator
+					*/
+					slotiterator& operator++() {
+						do {
+							++_slot;
+						} while(_slot < _pm->_sets.size() && !_pm->_sets[_slot]);
+
+						return *this;
+					}
+
+					/**
+					* @brief Moves to the next present lead
+					*
+					* @return Iterator before moving
+					*/
+					slotiterator operator++(int) {
+						slotiterator it(*this);
+						++(*this);
+						return it;
+					}
+
+					/**
+					* @brief Moves to the previous present lead
+					*
+					* @return This iterator
+					*/
+					slotiterator& operator--() {
+						do {
+							--_slot;
+						} while(!_pm->_sets[_slot]);
+
+						return *this;
+					}
+
+					/**
+					* @brief Moves to the previous present lead
+					*
+					* @return Iterator before moving
+					*/
+					slotiterator operator--(int) {
+						slotiterator it(*this);
+						--(*this);
+						return it;
+					}
+
+					/**
+					* @brief Same position
+					*
+					* @param other Other iterator
+					*
+					* @return True if equal
+					*/
+					bool operator==(const slotiterator &other) const {
+						return _slot == other._slot && _pm == other._pm;
+					}
+
+					/**
+					* @brief Different position
+					*
+					* @param other Other iterator
+					*
+					* @return True if not equal
+					*/
+					bool operator!=(const slotiterator &other) const {
+						return !(*this == other);
+					}
+
+				private:
+					template<class Q, class W> friend class slotiterator;
+					friend class pointmap;
+
+					/**
+					* @brief Pointmap
+					*/
+					PM *_pm;
+
+					/**
+					* @brief Slot (lead+1)
+					*/
+					std::size_t _slot;
+			};
+
+		public:
+			typedef slotiterator<pointmap, value_type> iterator;				/**< @brief iterator for pointmap */
+			typedef slotiterator<const pointmap, const value_type> const_iterator;		/**< @brief const iterator for pointmap */
 
 		public:
 			/**
 			* @brief empty constructor for pointmap
 			*/
-			pointmap() {
+			pointmap() : _size(0) {
+			}
+
+			/**
+			* @brief Copy constructor
+			*
+			* @param other Pointmap to copy
+			*/
+			pointmap(const pointmap &other) : _size(0) {
+				*this = other;
+			}
+
+			/**
+			* @brief Move constructor
+			*
+			* @param other Pointmap to move from, empty afterwards
+			*/
+			pointmap(pointmap &&other) noexcept : _sets(std::move(other._sets)), _size(other._size) {
+				other._sets.clear();
+				other._size = 0;
+			}
+
+			/**
+			* @brief Copy assignment
+			*
+			* @param other Pointmap to copy
+			*
+			* @return This pointmap
+			*/
+			pointmap& operator=(const pointmap &other) {
+				if(this == &other) {
+					return *this;
+				}
+
+				std::vector<std::unique_ptr<value_type> > sets(other._sets.size());
+				for(std::size_t i = 0; i < sets.size(); ++i) {
+					if(other._sets[i]) {
+						sets[i].reset(new value_type(*other._sets[i]));
+					}
+				}
+
+				_sets.swap(sets);
+				_size = other._size;
+
+				return *this;
+			}
+
+			/**
+			* @brief Move assignment
+			*
+			* @param other Pointmap to move from, empty afterwards
+			*
+			* @return This pointmap
+			*/
+			pointmap& operator=(pointmap &&other) noexcept {
+				_sets = std::move(other._sets);
+				_size = other._size;
+				other._sets.clear();
+				other._size = 0;
+
+				return *this;
 			}
 
 		public:
 			/**
-			* @brief Retrieve annotation set for lead l
+			* @brief Retrieve annotation set for lead l, an empty set is added if there is none
 			*
-			* @param l Leadnumber l
+			* @param l Leadnumber l, at least GLOBAL_LEAD
 			*
-			* @return Annotationset reference
+			* @return Annotationset reference, valid until the lead is erased or the pointmap is cleared or assigned
 			*/
 			annotationset& operator[](const leadnumber l) {
-				return _pm[l];
+				std::size_t slot = slotof(l);
+				if(slot >= _sets.size()) {
+					_sets.resize(slot + 1);
+				}
+				if(!_sets[slot]) {
+					_sets[slot].reset(new value_type(l, annotationset()));
+					++_size;
+				}
+
+				return _sets[slot]->second;
 			}
 
 			/**
@@ -533,9 +1041,9 @@ namespace ecglib {
 			* @return Annotationset reference
 			*/
 			const annotationset& operator[](const leadnumber l) const {
-				const_iterator iter = _pm.find(l);
+				const_iterator iter = find(l);
 
-				if(iter == _pm.end()) {
+				if(iter == end()) {
 					std::stringstream ss;
 					ss << "No such lead number: " << l;
 					std::cerr << ss.str();
@@ -551,7 +1059,7 @@ namespace ecglib {
 			* @return Iterator for beginning
 			*/
 			iterator begin() {
-				return _pm.begin();
+				return iterator(this, 0);
 			}
 
 			/**
@@ -560,7 +1068,7 @@ namespace ecglib {
 			* @return Iterator for end
 			*/
 			iterator end() {
-				return _pm.end();
+				return iterator(this, _sets.size());
 			}
 
 			/**
@@ -569,7 +1077,7 @@ namespace ecglib {
 			* @return Iterator for beginning
 			*/
 			const_iterator begin() const {
-				return _pm.begin();
+				return const_iterator(this, 0);
 			}
 
 			/**
@@ -578,7 +1086,7 @@ namespace ecglib {
 			* @return Iterator for end
 			*/
 			const_iterator end() const {
-				return _pm.end();
+				return const_iterator(this, _sets.size());
 			}
 
 			/**
@@ -587,7 +1095,18 @@ namespace ecglib {
 			* @return Number of leads
 			*/
 			std::size_t size() const {
-				return _pm.size();
+				return _size;
+			}
+
+			/**
+			* @brief True if the pointmap has the lead l, O(1)
+			*
+			* @param l Lead l
+			*
+			* @return Lead present
+			*/
+			bool has(const leadnumber l) const {
+				return l >= GLOBAL_LEAD && static_cast<std::size_t>(l - GLOBAL_LEAD) < _sets.size() && _sets[l - GLOBAL_LEAD];
 			}
 
 			/**
@@ -598,7 +1117,7 @@ namespace ecglib {
 			* @return Iterator for lead l
 			*/
 			iterator find(ecglib::leadnumber l) {
-				return _pm.find(l);
+				return has(l) ? iterator(this, l - GLOBAL_LEAD) : end();
 			}
 
 			/**
@@ -609,14 +1128,15 @@ namespace ecglib {
 			 * @return Iterator for lead l
 			 */
 			const_iterator find(ecglib::leadnumber l) const {
-				return _pm.find(l);
+				return has(l) ? const_iterator(this, l - GLOBAL_LEAD) : end();
 			}
 
 			/**
 			* @brief Clear pointmap
 			*/
 			void clear() {
-				_pm.clear();
+				_sets.clear();
+				_size = 0;
 			}
 
 			/**
@@ -625,13 +1145,14 @@ namespace ecglib {
 			* @param it Iterator pointing to leads to remove annotations from
 			*/
 			void erase(iterator it) {
-				_pm.erase(it);
+				_sets[it._slot].reset();
+				--_size;
 			}
 
 			/**
-			* @brief Insert annotationsets from other leads into this pointmap
+			* @brief Insert annotationsets from other leads into this pointmap, leads that are already present are not replaced
 			*
-			* @tparam INPUT_ITER Iterator type
+			* @tparam INPUT_ITER Iterator type, the value has first (lead number) and second (annotationset)
 			* @param a1 Start iterator
 			* @param a2 Stop iterator
 			*
@@ -639,10 +1160,13 @@ namespace ecglib {
 			*/
 			template<typename INPUT_ITER>
 			iterator insert(INPUT_ITER a1, INPUT_ITER a2) {
-				iterator ret;
+				iterator ret = end();
 
 				while(a1 != a2) {
-					ret = _pm.insert(*a1);
+					if(!has((*a1).first)) {
+						(*this)[(*a1).first] = (*a1).second;
+					}
+					ret = find((*a1).first);
 
 					++a1;
 				}
@@ -658,15 +1182,56 @@ namespace ecglib {
 			std::size_t nanns() const {
 				std::size_t n = 0;
 
-				for(auto &r : _pm) {
+				for(auto &r : *this) {
 					n += r.second.size();
 				}
 
 				return n;
 			}
 
+			/**
+			* @brief Types of the annotations of all leads
+			*
+			* @return Bitmask, bit i set if there is an annotation of type index i
+			*/
+			annotationset::typemask types() const {
+				annotationset::typemask m = 0;
+
+				for(auto &r : *this) {
+					m |= r.second.types();
+				}
+
+				return m;
+			}
+
 		private:
-			std::map<leadnumber, annotationset> _pm;
+			/**
+			* @brief Slot of a lead number
+			*
+			* @param l Lead number
+			*
+			* @return l+1
+			*/
+			static std::size_t slotof(const leadnumber l) {
+				if(l < GLOBAL_LEAD) {
+					std::stringstream ss;
+					ss << "No such lead number: " << l;
+					std::cerr << ss.str();
+					throw std::logic_error(ss.str());
+				}
+
+				return static_cast<std::size_t>(l - GLOBAL_LEAD);
+			}
+
+			/**
+			* @brief Lead number and annotations of every slot (lead+1), nullptr if the lead is not present
+			*/
+			std::vector<std::unique_ptr<value_type> > _sets;
+
+			/**
+			* @brief Number of present leads
+			*/
+			std::size_t _size;
 	};
 
 	/**
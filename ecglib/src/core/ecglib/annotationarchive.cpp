@@ -0,0 +1,351 @@
+/**
+ * @file core/ecglib/annotationarchive.cpp
+ * @author Lars Johannesen <lars.johannesen@fda.hhs.gov>
+ * @author Jose Vicente <jose.vicenteruiz@fda.hhs.gov>
+ * @author Meisam Hosseini <meisam.hosseini@fda.hhs.gov>
+ * @author Dustin C McAfee <dustin.mcafee@fda.hhs.gov
+ *
+ * @version 1.0.0
+ *
+ * @section LICENSE
+ * ecglib is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as published by the Free Software Foundation, either version 3 of the License (GNU LGPL3), or (at your option) any later version.
+ * ecglib is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ * @section DISCLAIMER
+ * ecglib software and documentation were developed by the authors in their capacities as  Oak Ridge Institute for Science and Education (ORISE) research fellows at the U.S. Food and Drug Administration (FDA). .
+ * FDA assumes no responsibility whatsoever for use by other parties of the Software, its source code, documentation or compiled executables, and makes no guarantees, expressed or implied, about its quality, reliability, or any other characteristic.  Further, FDA makes no representations that the use of the Software will not infringe any patent or proprietary rights of third parties.   The use of this code in no way implies endorsement by the FDA or confers any advantage in regulatory decisions.
+ *
+ * @section DESCRIPTION
+ * Packed, block-indexed archive of annotations for large corpora
+ */
+
+#include <ecglib/annotationarchive.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define ECGLIB_HAS_MMAP 1
+#endif
+
+namespace ecglib {
+	namespace {
+		const char archivemagic[8] = {'E','C','G','L','A','N','N','A'};
+
+		void archiveerror(const std::string &line) {
+			std::cerr << line;
+			throw ecglib::ecglib_exception(line);
+		}
+
+		void putvarint(std::vector<char> &buf, std::uint32_t v) {
+			while(v >= 0x80) {
+				buf.push_back(static_cast<char>((v & 0x7f) | 0x80));
+				v >>= 7;
+			}
+			buf.push_back(static_cast<char>(v));
+		}
+
+		// false if the varint runs past stop
+		bool getvarint(const unsigned char *&pos, const unsigned char *stop, std::uint32_t &v) {
+			v = 0;
+			for(int shift = 0; pos < stop; shift += 7) {
+				unsigned char c = *pos++;
+				v |= static_cast<std::uint32_t>(c & 0x7f) << shift;
+				if(!(c & 0x80) || shift >= 28) {
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		// type index of an annotation type, -1 if it has no bit in the block masks
+		int typebit(const annotation_type &typ) {
+			int t = static_cast<int>(typ.index);
+			return (t >= 0 && t < 32) ? t : -1;
+		}
+
+		// image held by a vector
+		std::shared_ptr<const char> ownedimage(std::vector<char> &&buf) {
+			std::shared_ptr<std::vector<char> > v = std::make_shared<std::vector<char> >(std::move(buf));
+			return std::shared_ptr<const char>(v, v->data());
+		}
+	}
+
+	annotationarchive::annotationarchive() : _length(0) {
+		std::vector<char> buf(sizeof(archiveheader), 0);
+		archiveheader h;
+		std::memset(&h, 0, sizeof(h));
+		std::memcpy(h.magic, archivemagic, sizeof(h.magic));
+		h.version = ARCHIVE_VERSION;
+		h.dataoffset = sizeof(archiveheader);
+		std::memcpy(&buf[0], &h, sizeof(h));
+
+		_length = buf.size();
+		_bytes = ownedimage(std::move(buf));
+	}
+
+	annotationarchive::annotationarchive(const pointmap &pm, const std::uint32_t blocksize) : _length(0) {
+		if(blocksize == 0) {
+			archiveerror("ecglib::annotationarchive: blocksize has to be positive");
+		}
+
+		std::vector<archiveblock> dir;
+		std::vector<char> data;
+		data.reserve(pm.nanns() * 5);
+
+		for(auto pmi = pm.begin(); pmi != pm.end(); ++pmi) {
+			const annotationset &as = pmi->second;
+			for(annotationset::const_iterator bstart = as.begin(); bstart != as.end(); ) {
+				annotationset::const_iterator bstop = bstart + std::min<std::size_t>(blocksize, as.end() - bstart);
+
+				archiveblock b;
+				std::memset(&b, 0, sizeof(b));
+				b.key = pmi->first;
+				b.count = static_cast<std::uint32_t>(bstop - bstart);
+				b.first = bstart->first;
+				b.last = (bstop - 1)->first;
+				b.offset = data.size();
+
+				// columns: location deltas, types, subtypes, leads
+				timems prev = b.first;
+				for(annotationset::const_iterator it = bstart; it != bstop; ++it) {
+					putvarint(data, it->first - prev);
+					prev = it->first;
+				}
+				for(annotationset::const_iterator it = bstart; it != bstop; ++it) {
+					int t = typebit(it->second.type());
+					if(t >= 0) {
+						b.types |= std::uint32_t(1) << t;
+					}
+					data.push_back(static_cast<char>(it->second.type().index));
+				}
+				for(annotationset::const_iterator it = bstart; it != bstop; ++it) {
+					data.push_back(static_cast<char>(it->second.subtype().index));
+				}
+				for(annotationset::const_iterator it = bstart; it != bstop; ++it) {
+					std::int16_t l = static_cast<std::int16_t>(it->second.lead());
+					data.insert(data.end(), reinterpret_cast<const char*>(&l), reinterpret_cast<const char*>(&l) + sizeof(l));
+				}
+
+				b.bytes = data.size() - b.offset;
+				dir.push_back(b);
+				bstart = bstop;
+			}
+		}
+
+		archiveheader h;
+		std::memset(&h, 0, sizeof(h));
+		std::memcpy(h.magic, archivemagic, sizeof(h.magic));
+		h.version = ARCHIVE_VERSION;
+		h.blocksize = blocksize;
+		h.nblocks = dir.size();
+		h.nannotations = pm.nanns();
+		h.dataoffset = sizeof(archiveheader) + dir.size() * sizeof(archiveblock);
+
+		std::vector<char> buf(h.dataoffset + data.size());
+		std::memcpy(&buf[0], &h, sizeof(h));
+		for(std::size_t i = 0; i < dir.size(); ++i) {
+			dir[i].offset += h.dataoffset;
+		}
+		if(!dir.empty()) {
+			std::memcpy(&buf[sizeof(h)], &dir[0], dir.size() * sizeof(archiveblock));
+		}
+		if(!data.empty()) {
+			std::memcpy(&buf[h.dataoffset], &data[0], data.size());
+		}
+
+		_length = buf.size();
+		_bytes = ownedimage(std::move(buf));
+	}
+
+	annotationarchive annotationarchive::open(const std::string &filename) {
+		annotationarchive a;
+
+#ifdef ECGLIB_HAS_MMAP
+		int fd = ::open(filename.c_str(), O_RDONLY);
+		if(fd < 0) {
+			archiveerror(std::string("ecglib::annotationarchive::open: could not open ") + filename);
+		}
+
+		struct stat st;
+		if(fstat(fd, &st) != 0 || static_cast<std::uint64_t>(st.st_size) < sizeof(archiveheader)) {
+			close(fd);
+			archiveerror(std::string("ecglib::annotationarchive::open: not an annotation archive ") + filename);
+		}
+
+		std::size_t length = static_cast<std::size_t>(st.st_size);
+		void *base = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd); // the mapping keeps the file open
+		if(base == MAP_FAILED) {
+			archiveerror(std::string("ecglib::annotationarchive::open: could not map ") + filename);
+		}
+
+		a._bytes = std::shared_ptr<const char>(static_cast<const char*>(base), [length](const char *p) { munmap(const_cast<char*>(p), length); });
+		a._length = length;
+#else
+		std::ifstream in(filename.c_str(), std::ios::binary);
+		if(!in) {
+			archiveerror(std::string("ecglib::annotationarchive::open: could not open ") + filename);
+		}
+		std::vector<char> buf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		a._length = buf.size();
+		a._bytes = ownedimage(std::move(buf));
+#endif
+
+		a.check(filename);
+
+		return a;
+	}
+
+	void annotationarchive::write(const std::string &filename) const {
+		std::ofstream out(filename.c_str(), std::ios::binary | std::ios::trunc);
+		if(!out) {
+			archiveerror(std::string("ecglib::annotationarchive::write: could not open ") + filename);
+		}
+
+		out.write(_bytes.get(), _length);
+
+		if(!out) {
+			archiveerror(std::string("ecglib::annotationarchive::write: could not write ") + filename);
+		}
+	}
+
+	void annotationarchive::check(const std::string &what) const {
+		if(_length < sizeof(archiveheader)) {
+			archiveerror(std::string("ecglib::annotationarchive: not an annotation archive ") + what);
+		}
+
+		const archiveheader &h = header();
+		if(std::memcmp(h.magic, archivemagic, sizeof(archivemagic)) != 0 || h.version == 0 || h.version > ARCHIVE_VERSION) {
+			archiveerror(std::string("ecglib::annotationarchive: not an annotation archive or unsupported version ") + what);
+		}
+		if(h.nblocks > (_length - sizeof(archiveheader)) / sizeof(archiveblock) || h.dataoffset < sizeof(archiveheader) + h.nblocks * sizeof(archiveblock) || h.dataoffset > _length) {
+			archiveerror(std::string("ecglib::annotationarchive: corrupt directory in ") + what);
+		}
+
+		const archiveblock *b = blocks();
+		for(std::uint64_t i = 0; i < h.nblocks; ++i) {
+			// a block needs at least one byte per location, type and subtype and two per lead
+			if(b[i].offset < h.dataoffset || b[i].offset > _length || b[i].bytes > _length - b[i].offset || b[i].bytes < 5ull * b[i].count) {
+				archiveerror(std::string("ecglib::annotationarchive: corrupt block in ") + what);
+			}
+
+			// the lead lookup binary searches by key and stops at the first block after the range, so the order is part of the format
+			if(b[i].key < GLOBAL_LEAD || b[i].first > b[i].last || (i > 0 && (b[i].key < b[i-1].key || (b[i].key == b[i-1].key && b[i].first <= b[i-1].last)))) {
+				archiveerror(std::string("ecglib::annotationarchive: corrupt directory in ") + what);
+			}
+		}
+	}
+
+	template<class F>
+	void annotationarchive::decode(const archiveblock &b, const timems first, const timems last, const int typ, F out) const {
+		const unsigned char *pos = reinterpret_cast<const unsigned char*>(_bytes.get() + b.offset);
+		const unsigned char *stop = pos + b.bytes;
+
+		// the locations are decoded until last, the other columns are only read for the matching annotations
+		std::vector<timems> locs;
+		locs.reserve(b.count);
+		timems loc = b.first;
+		for(std::uint32_t i = 0; i < b.count; ++i) {
+			std::uint32_t d;
+			// the locations have to stay sorted within [b.first, b.last] for the lower_bound below
+			if(!getvarint(pos, stop, d) || d > b.last - loc) {
+				archiveerror("ecglib::annotationarchive: corrupt block");
+			}
+			loc += d;
+			locs.push_back(loc);
+		}
+		if(static_cast<std::size_t>(stop - pos) < 4ull * b.count) {
+			archiveerror("ecglib::annotationarchive: corrupt block");
+		}
+
+		const unsigned char *types = pos;
+		const unsigned char *subtypes = types + b.count;
+		const char *leads = reinterpret_cast<const char*>(subtypes + b.count);
+
+		std::uint32_t i = static_cast<std::uint32_t>(std::lower_bound(locs.begin(), locs.end(), first) - locs.begin());
+		for(; i < b.count && locs[i] <= last; ++i) {
+			if(typ >= 0 && types[i] != typ) {
+				continue;
+			}
+
+			std::int16_t l;
+			std::memcpy(&l, leads + i * sizeof(l), sizeof(l));
+			out(annotation(locs[i], annotation_type(types[i]), l, annotation_subtype(subtypes[i])));
+		}
+	}
+
+	pointmap annotationarchive::unpack() const {
+		return unpack(0, std::numeric_limits<timems>::max());
+	}
+
+	pointmap annotationarchive::unpack(const timems first, const timems last) const {
+		pointmap pm;
+
+		const archiveblock *b = blocks();
+		for(std::uint64_t i = 0; i < header().nblocks; ++i) {
+			if(b[i].last < first || b[i].first > last) {
+				continue;
+			}
+
+			annotationset &as = pm[b[i].key];
+			as.reserve(as.size() + b[i].count);
+			decode(b[i], first, last, -1, [&as](const annotation &a) { as[a.location()] = a; });
+		}
+
+		return pm;
+	}
+
+	void annotationarchive::get_annotations(const annotation_type &typ, const timems first, const timems last, std::vector<annotation> &out) const {
+		const int t = typebit(typ);
+		if(t < 0) {
+			return;
+		}
+
+		const archiveblock *b = blocks();
+		for(std::uint64_t i = 0; i < header().nblocks; ++i) {
+			if(b[i].last < first || b[i].first > last || !((b[i].types >> t) & 1u)) {
+				continue;
+			}
+
+			decode(b[i], first, last, t, [&out](const annotation &a) { out.push_back(a); });
+		}
+	}
+
+	void annotationarchive::get_annotations(const leadnumber l, const annotation_type &typ, const timems first, const timems last, std::vector<annotation> &out) const {
+		const int t = typebit(typ);
+		if(t < 0) {
+			return;
+		}
+
+		// the directory is sorted by lead, so the blocks of a lead are found by binary search
+		const archiveblock *b = blocks();
+		const archiveblock *bend = b + header().nblocks;
+		const archiveblock *bi = std::lower_bound(b, bend, l, [](const archiveblock &blk, const leadnumber key) { return blk.key < key; });
+		for(; bi != bend && bi->key == l && bi->first <= last; ++bi) {
+			if(bi->last < first || !((bi->types >> t) & 1u)) {
+				continue;
+			}
+
+			decode(*bi, first, last, t, [&out](const annotation &a) { out.push_back(a); });
+		}
+	}
+
+	std::size_t annotationarchive::nanns() const {
+		return static_cast<std::size_t>(header().nannotations);
+	}
+
+	std::size_t annotationarchive::nblocks() const {
+		return static_cast<std::size_t>(header().nblocks);
+	}
+}
@@ -0,0 +1,232 @@
+/**
+ * @file core/ecglib/annotationarchive.hpp
+ * @author Lars Johannesen <lars.johannesen@fda.hhs.gov>
+ * @author Jose Vicente <jose.vicenteruiz@fda.hhs.gov>
+ * @author Meisam Hosseini <meisam.hosseini@fda.hhs.gov>
+ * @author Dustin C McAfee <dustin.mcafee@fda.hhs.gov
+ *
+ * @version 1.0.0
+ *
+ * @section LICENSE
+ * ecglib is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as published by the Free Software Foundation, either version 3 of the License (GNU LGPL3), or (at your option) any later version.
+ * ecglib is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ * @section DISCLAIMER
+ * ecglib software and documentation were developed by the authors in their capacities as  Oak Ridge Institute for Science and Education (ORISE) research fellows at the U.S. Food and Drug Administration (FDA). .
+ * FDA assumes no responsibility whatsoever for use by other parties of the Software, its source code, documentation or compiled executables, and makes no guarantees, expressed or implied, about its quality, reliability, or any other characteristic.  Further, FDA makes no representations that the use of the Software will not infringe any patent or proprietary rights of third parties.   The use of this code in no way implies endorsement by the FDA or confers any advantage in regulatory decisions.
+ *
+ * @section DESCRIPTION
+ * Packed, block-indexed archive of annotations for large corpora
+ */
+
+#ifndef ECGLIB_CORE_ANNOTATIONARCHIVE_LJ_2015_12_09
+#define ECGLIB_CORE_ANNOTATIONARCHIVE_LJ_2015_12_09 1
+
+#include <ecglib/annotation.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace ecglib {
+	/*! \addtogroup core
+	 * Core ECGlib classes and functions
+	 * @{
+	 */
+
+	/**
+	* @brief Header of an annotation archive
+	*
+	* An archive is the header, followed by nblocks archiveblock records (the directory) and the block data. The directory is sorted
+	* by pointmap lead and location. The data of a block of count annotations is: the locations as LEB128 varints (the first
+	* relative to the block's first location, the others relative to the previous one), count annotation_type bytes,
+	* count annotation_subtype bytes and count int16 annotation leads. All values are in the byte order of the writer.
+	*/
+	struct archiveheader {
+		char magic[8];			/**< @brief "ECGLANNA" */
+		std::uint32_t version;		/**< @brief format version, see ARCHIVE_VERSION */
+		std::uint32_t blocksize;	/**< @brief maximum number of annotations of a block */
+		std::uint64_t nblocks;		/**< @brief number of blocks */
+		std::uint64_t nannotations;	/**< @brief number of annotations */
+		std::uint64_t dataoffset;	/**< @brief position of the first block in bytes */
+	};
+
+	/**
+	* @brief Directory record of a block of annotations of one lead
+	*/
+	struct archiveblock {
+		std::int32_t key;		/**< @brief lead of the annotationset in the pointmap */
+		std::uint32_t count;		/**< @brief number of annotations */
+		std::uint32_t first;		/**< @brief first location in ms */
+		std::uint32_t last;		/**< @brief last location in ms */
+		std::uint32_t types;		/**< @brief annotation types in the block, bit i for annotation_type index i */
+		std::uint32_t reserved;		/**< @brief padding, 0 */
+		std::uint64_t offset;		/**< @brief position of the data in bytes */
+		std::uint64_t bytes;		/**< @brief size of the data in bytes */
+	};
+
+	/**
+	* @brief Archive format version written by annotationarchive, older readers reject newer versions
+	*/
+	const std::uint32_t ARCHIVE_VERSION = 1;
+
+	/**
+	* @brief Immutable, packed archive of the annotations of a pointmap
+	*
+	* Annotations are stored per lead in blocks of at most blocksize annotations, with delta-encoded locations and one byte
+	* per type/subtype, i.e. about 5 bytes per annotation instead of a 16 byte annotation plus container overhead.
+	* The directory keeps the location range and the types of every block, so queries by lead, time and type only decode
+	* the blocks that can match. The archive is a single byte image: it is written to disk as is and open() maps it without
+	* reading it, so queries on a mapped archive only page in the directory and the matching blocks. Copies share the image.
+	*
+	* The location of an annotation is its location in the annotationset (the annotation's own location is not stored separately).
+	*/
+	class annotationarchive {
+		public:
+			/**
+			* @brief Empty archive
+			*/
+			annotationarchive();
+
+			/**
+			* @brief Packs a pointmap
+			*
+			* @param pm Pointmap
+			* @param blocksize Maximum number of annotations per block, smaller blocks skip more precisely, larger blocks pack better
+			*/
+			explicit annotationarchive(const pointmap &pm, const std::uint32_t blocksize = 256);
+
+			/**
+			* @brief Maps an archive file without reading it
+			*
+			* @param filename File name
+			*
+			* @return Archive over the mapping (read into memory on platforms without memory mapping)
+			*/
+			static annotationarchive open(const std::string &filename);
+
+			/**
+			* @brief Writes the archive to a file
+			*
+			* @param filename File name
+			*/
+			void write(const std::string &filename) const;
+
+			/**
+			* @brief Decodes all annotations
+			*
+			* @return Pointmap
+			*/
+			pointmap unpack() const;
+
+			/**
+			* @brief Decodes the annotations in a time range, only blocks overlapping the range are decoded
+			*
+			* @param first First location in ms
+			* @param last Last location in ms
+			*
+			* @return Pointmap with the annotations in [first, last]
+			*/
+			pointmap unpack(const timems first, const timems last) const;
+
+			/**
+			* @brief Get annotations of a type in a time range across leads, only blocks that overlap the range and have the type are decoded
+			*
+			* @param typ Annotation type
+			* @param first First location in ms
+			* @param last Last location in ms
+			* @param[out] out Annotations are appended, ordered by lead and location
+			*/
+			void get_annotations(const annotation_type &typ, const timems first, const timems last, std::vector<annotation> &out) const;
+
+			/**
+			* @brief Get annotations of a lead and a type in a time range
+			*
+			* @param l Lead number
+			* @param typ Annotation type
+			* @param first First location in ms
+			* @param last Last location in ms
+			* @param[out] out Annotations are appended, ordered by location
+			*/
+			void get_annotations(const leadnumber l, const annotation_type &typ, const timems first, const timems last, std::vector<annotation> &out) const;
+
+			/**
+			* @brief Number of annotations
+			*
+			* @return Nannotations
+			*/
+			std::size_t nanns() const;
+
+			/**
+			* @brief Number of blocks
+			*
+			* @return Nblocks
+			*/
+			std::size_t nblocks() const;
+
+			/**
+			* @brief Size of the byte image
+			*
+			* @return Bytes
+			*/
+			std::size_t bytes() const {
+				return _length;
+			}
+
+		private:
+			/**
+			* @brief Header of the image
+			*
+			* @return Header
+			*/
+			const archiveheader& header() const {
+				return *reinterpret_cast<const archiveheader*>(_bytes.get());
+			}
+
+			/**
+			* @brief Directory of the image
+			*
+			* @return First block record
+			*/
+			const archiveblock* blocks() const {
+				return reinterpret_cast<const archiveblock*>(_bytes.get() + sizeof(archiveheader));
+			}
+
+			/**
+			* @brief Decodes the annotations of a block that are in [first, last] and match a type
+			*
+			* @param b Block
+			* @param first First location in ms
+			* @param last Last location in ms
+			* @param typ Type index, -1 for all types
+			* @param out Function called with each matching annotation
+			*/
+			template<class F>
+			void decode(const archiveblock &b, const timems first, const timems last, const int typ, F out) const;
+
+			/**
+			* @brief Checks the header and the directory of the image: bounds of the blocks, first <= last and the order by (lead, location)
+			*
+			* @param what Name of the image for errors
+			*/
+			void check(const std::string &what) const;
+
+			/**
+			* @brief Byte image (header, directory, data), shared by copies
+			*/
+			std::shared_ptr<const char> _bytes;
+
+			/**
+			* @brief Size of the image in bytes
+			*/
+			std::size_t _length;
+	};
+
+	/*!
+	 *@}
+	 */
+}
+
+#endif
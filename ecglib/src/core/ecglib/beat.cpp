@@ -24,6 +24,7 @@
 #include <ecglib/beat.hpp>
 #include <ecglib/detail/detail.hpp>
 
+#include <algorithm>
 #include <cassert>
 
 namespace ecglib { 
@@ -59,13 +60,13 @@ namespace ecglib {
 
 	using namespace arma;
 
-	std::vector<beat> create_all_beats(ecglib::ecgdata::pointmap points, const std::vector<ecglib::annotation> &locs, int nsamples, double fs, bool keepall, int precutwin) {
+	std::vector<beat> create_all_beats(const ecglib::ecgdata::pointmap &points, const std::vector<ecglib::annotation> &locs, int nsamples, double fs, bool keepall, int precutwin) {
 		std::vector<beat> beats;
 
 		const unsigned int precut = static_cast<int>(round(precutwin*(fs/1000.0)));
 
-		typedef ecglib::ecgdata::pointmapiterator citer;
-		typedef ecglib::ecgdata::pointiterator piter;
+		typedef ecglib::ecgdata::const_pointmapiterator citer;
+		typedef ecglib::ecgdata::const_pointiterator piter;
 
 		if(locs.size() == 1) {
 			beat b;
@@ -126,20 +127,34 @@ namespace ecglib {
 			}
 		}
 
+		// Beats follow the beat locations, so if these are ordered only the beats from the first one that stops after an annotation
+		// up to the first one that starts at or after it can hold the annotation
+		bool ordered = true;
+		for(std::size_t i = 1; i < beats.size() && ordered; ++i) {
+			ordered = beats[i-1].start <= beats[i].start && beats[i-1].stop <= beats[i].stop;
+		}
+
 		// Foreach lead with annotations
 		citer endp = points.end();
 		for(citer iterp = points.begin(); iterp != endp; ++iterp) {
 			// Foreach annotation in a given lead
-			piter pi = iterp->second.begin();
 			piter pend = iterp->second.end();
-
-			while(pi != pend) {
+			for(piter pi = iterp->second.begin(); pi != pend; ++pi) {
 				int bnum = 0;
 				bool found = false;
 				unsigned int lowdiff = 0;
 
+				std::size_t first = 0;
+				if(ordered) {
+					first = std::partition_point(beats.begin(), beats.end(), [&pi](const beat &b) { return b.stop <= pi->first; }) - beats.begin();
+				}
+
 				// Foreach beat - find best suiter
-				for(std::size_t i = 0; i < beats.size(); ++i) {
+				for(std::size_t i = first; i < beats.size(); ++i) {
+					if(ordered && beats[i].start >= pi->first) {
+						break;
+					}
+
 					// Is annotation inside a given beat ?
 					if(pi->first > beats[i].start && pi->first < beats[i].stop) {
 						std::size_t rpeak = beats[i].rpeak;
@@ -162,7 +177,7 @@ namespace ecglib {
 								}
 							} else {
 								ok = true;
-								curdiff = abs(pi->first - beats[i].rpeak);
+								curdiff = pi->first > rpeak ? pi->first - rpeak : rpeak - pi->first;
 							}
 						}
 
@@ -181,11 +196,6 @@ namespace ecglib {
 				
 				if(found) {
 					beats[bnum].points[iterp->first][pi->first] = pi->second;
-					piter pio = pi;
-					++pi;
-					iterp->second.erase(pio->first);
-				} else {
-					++pi;
 				}
 			} // End foreach annotation for a given lead
 		} // End foreach lead with annotations
@@ -362,7 +362,29 @@ namespace ecglib {
 	 *
 	 * @return Vector of beats
 	 */
-	std::vector<beat> create_all_beats(ecglib::ecgdata::pointmap points, const std::vector<ecglib::annotation> &locs, int nsamples, double fs, bool keepall, int precutwin);
+	std::vector<beat> create_all_beats(const ecglib::ecgdata::pointmap &points, const std::vector<ecglib::annotation> &locs, int nsamples, double fs, bool keepall, int precutwin);
+
+	/**
+	 * @brief View of the samples of a beat, [start, stop) limited to the recording (no copy)
+	 *
+	 * @tparam T Sample type of the view
+	 * @param v View of the recording
+	 * @param b Beat
+	 *
+	 * @return View of the beat window, positions inside are relative to b.start
+	 */
+	template<class T>
+	EcgView<T> beat_view(const EcgView<T> &v, const beat &b) {
+		const std::size_t stop = std::min(b.stop, v.nsamples());
+
+		if(b.start >= stop) {
+			std::string line = std::string("Beat outside of the recording");
+			std::cerr << line;
+			throw std::logic_error(line);
+		}
+
+		return v.slice(b.start, stop-1);
+	}
 
 	/**
 	 * @brief Converts beats to a pointmap
@@ -0,0 +1,455 @@
+/**
+ * @file core/ecglib/ecgdatabuilder.hpp
+ * @author Lars Johannesen <lars.johannesen@fda.hhs.gov>
+ * @author Jose Vicente <jose.vicenteruiz@fda.hhs.gov>
+ * @author Meisam Hosseini <meisam.hosseini@fda.hhs.gov>
+ * @author Dustin C McAfee <dustin.mcafee@fda.hhs.gov
+ *
+ * @version 1.0.0
+ *
+ * @section LICENSE
+ * ecglib is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as published by the Free Software Foundation, either version 3 of the License (GNU LGPL3), or (at your option) any later version.
+ * ecglib is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ * @section DISCLAIMER
+ * ecglib software and documentation were developed by the authors in their capacities as  Oak Ridge Institute for Science and Education (ORISE) research fellows at the U.S. Food and Drug Administration (FDA). .
+ * FDA assumes no responsibility whatsoever for use by other parties of the Software, its source code, documentation or compiled executables, and makes no guarantees, expressed or implied, about its quality, reliability, or any other characteristic.  Further, FDA makes no representations that the use of the Software will not infringe any patent or proprietary rights of third parties.   The use of this code in no way implies endorsement by the FDA or confers any advantage in regulatory decisions.
+ *
+ * @section DESCRIPTION
+ * Batch of equal-length records in one contiguous block, e.g. the median beats of a study
+ */
+
+#ifndef ECGLIB_CORE_ECGBATCH_LJ_2015_12_09
+#define ECGLIB_CORE_ECGBATCH_LJ_2015_12_09 1
+
+#include <ecglib/ecgdata.hpp>
+#include <ecglib/ecgview.hpp>
+#include <ecglib/propertystore.hpp>
+
+#include <boost/optional.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace ecglib {
+	/*! \addtogroup core
+	 * Core ECGlib classes and functions
+	 * @{
+	 */
+
+	/**
+	* @brief Order of the leads of a batch in memory
+	*/
+	enum class batchlayout {
+		RECORD_MAJOR,	/**< @brief the leads of a record are next to each other, view(record) is contiguous */
+		LEAD_MAJOR	/**< @brief a lead of all records is next to each other, lanes(lead) is contiguous */
+	};
+
+	/**
+	* @brief Many records with the same number of samples and the same leads in one contiguous, aligned block
+	*
+	* The samples form a cube of padded samples x leads x records (RECORD_MAJOR) or padded samples x records x leads (LEAD_MAJOR).
+	* Every column starts on a SAMPLE_ALIGNMENT boundary as in Ecgdata. Lead names, fs and resolution are shared by all records.
+	* Properties are kept per property as a column with one entry per record, instead of one property store per record.
+	*
+	* view(record) is a view of one record with the ecgdata lead API, lanes(lead) a view of one lead of all records
+	* (records as columns), e.g. for filtering or delineating many records together.
+	*
+	* @tparam T Sample type
+	*/
+	template<class T>
+	class EcgBatch {
+		public:
+		typedef typename EcgView<T>::leadtable leadtable;					/**< @brief column of each lead name */
+		typedef std::vector<boost::optional<propertyvalue> > propertycolumn;			/**< @brief value of a property for every record, unset if the record does not have it */
+
+		public:
+			/**
+			* @brief Creates a batch of records with zero samples
+			*
+			* @param nrecords Number of records
+			* @param nsamples Number of samples of every record
+			* @param leadnames Lead names of every record
+			* @param fs Sampling frequency
+			* @param res Resolution
+			* @param layout Order of the leads in memory
+			*/
+			EcgBatch(const std::size_t nrecords, const std::size_t nsamples, const std::vector<ecglead> &leadnames, const double fs, const double res = 1, const batchlayout layout = batchlayout::RECORD_MAJOR) : _data(Ecgdata<T>::allocate(nsamples, leadnames.size() * nrecords)), _nrecords(nrecords), _nsamples(nsamples), _leadnames(leadnames), _fs(fs), _res(res), _layout(layout) {
+				_leadcol.fill(-1);
+				for(std::size_t i = 0; i < leadnames.size(); ++i) {
+					int id = static_cast<int>(leadnames[i].index) - ecglead::GLOBAL;
+					if(id < 0 || id >= static_cast<int>(_leadcol.size()) || _leadcol[id] != -1) {
+						std::cerr << "ecglib::EcgBatch::Unknown or duplicate lead name";
+						throw ecglib::ecglib_exception("ecglib::EcgBatch::Unknown or duplicate lead name");
+					}
+					_leadcol[id] = static_cast<int>(i);
+				}
+
+				std::fill(_data->memptr(), _data->memptr() + _data->n_elem, T(0));
+			}
+
+			EcgBatch(const EcgBatch &) = delete;			/**< @brief not copyable, views point into the storage */
+			EcgBatch& operator=(const EcgBatch &) = delete;		/**< @brief not copyable, views point into the storage */
+			EcgBatch(EcgBatch &&) = default;			/**< @brief move constructor, views stay valid */
+			EcgBatch& operator=(EcgBatch &&) = default;		/**< @brief move assignment, views stay valid */
+
+			/**
+			* @brief Number of records
+			*
+			* @return Nrecords
+			*/
+			std::size_t nrecords() const {
+				return _nrecords;
+			}
+
+			/**
+			* @brief Number of samples of every record
+			*
+			* @return Nsamples
+			*/
+			std::size_t nsamples() const {
+				return _nsamples;
+			}
+
+			/**
+			* @brief Number of leads of every record
+			*
+			* @return Nleads
+			*/
+			std::size_t nleads() const {
+				return _leadnames.size();
+			}
+
+			/**
+			* @brief Lead names of the columns of every record
+			*
+			* @return Lead names
+			*/
+			const std::vector<ecglead>& leadnames() const {
+				return _leadnames;
+			}
+
+			/**
+			* @brief Sampling frequency
+			*
+			* @return fs
+			*/
+			double fs() const {
+				return _fs;
+			}
+
+			/**
+			* @brief Resolution
+			*
+			* @return Resolution
+			*/
+			double resolution() const {
+				return _res;
+			}
+
+			/**
+			* @brief Order of the leads in memory
+			*
+			* @return Layout
+			*/
+			batchlayout layout() const {
+				return _layout;
+			}
+
+			/**
+			* @brief View of a record, with the lead names of the batch
+			*
+			* @param record Record number
+			*
+			* @return Samples x leads view
+			*/
+			EcgView<T> view(const std::size_t record) {
+				checkrecord(record);
+				return EcgView<T>(_data->colptr(storagecol(record, 0)), _nsamples, nleads(), leadstride(), _leadcol, _fs, _res, nullptr);
+			}
+
+			/**
+			* @brief Read-only view of a record, with the lead names of the batch
+			*
+			* @param record Record number
+			*
+			* @return Samples x leads view
+			*/
+			EcgView<const T> view(const std::size_t record) const {
+				checkrecord(record);
+				return EcgView<const T>(_data->colptr(storagecol(record, 0)), _nsamples, nleads(), leadstride(), _leadcol, _fs, _res, nullptr);
+			}
+
+			/**
+			* @brief View of one lead of all records, column r is record r (no lead names)
+			*
+			* @param lead Lead
+			*
+			* @return Samples x records view
+			*/
+			EcgView<T> lanes(const ecglead lead) {
+				int l = leadnum(lead);
+				return EcgView<T>(_data->colptr(storagecol(0, l)), _nsamples, _nrecords, recordstride(), _fs, _res);
+			}
+
+			/**
+			* @brief Read-only view of one lead of all records, column r is record r (no lead names)
+			*
+			* @param lead Lead
+			*
+			* @return Samples x records view
+			*/
+			EcgView<const T> lanes(const ecglead lead) const {
+				int l = leadnum(lead);
+				return EcgView<const T>(_data->colptr(storagecol(0, l)), _nsamples, _nrecords, recordstride(), _fs, _res);
+			}
+
+			/**
+			* @brief All samples as a cube of padded samples x leads x records (RECORD_MAJOR) or padded samples x records x leads (LEAD_MAJOR), without copying
+			*
+			* Rows from nsamples() to Ecgdata<T>::padded(nsamples()) are padding.
+			*
+			* @return Cube over the samples of the batch
+			*/
+			Cube<T> cube() {
+				std::size_t inner = _layout == batchlayout::RECORD_MAJOR ? nleads() : _nrecords;
+				std::size_t outer = _layout == batchlayout::RECORD_MAJOR ? _nrecords : nleads();
+				return Cube<T>(_data->memptr(), _data->n_rows, inner, outer, false, true);
+			}
+
+			/**
+			* @brief Copies the samples of a record into the batch, leads are matched by name
+			*
+			* @param record Record number
+			* @param v Samples of the record, has to have nsamples() samples and all leads of the batch
+			*/
+			void set(const std::size_t record, const EcgView<const T> &v) {
+				checkrecord(record);
+				if(v.nsamples() != _nsamples) {
+					std::cerr << "ecglib::EcgBatch::set: number of samples does not match";
+					throw ecglib::ecglib_exception("ecglib::EcgBatch::set: number of samples does not match");
+				}
+
+				for(std::size_t i = 0; i < nleads(); ++i) {
+					if(!v.hasleadnum(_leadnames[i])) {
+						std::cerr << "ecglib::EcgBatch::set: lead missing";
+						throw ecglib::ecglib_exception("ecglib::EcgBatch::set: lead missing");
+					}
+					std::copy(v.begin_lead(_leadnames[i]), v.end_lead(_leadnames[i]), _data->colptr(storagecol(record, i)));
+				}
+			}
+
+			/**
+			* @brief Copies the samples and properties of an ecgdata into the batch (annotations are not kept)
+			*
+			* @param record Record number
+			* @param e Ecgdata with nsamples() samples and all leads of the batch
+			*/
+			void set(const std::size_t record, const Ecgdata<T> &e) {
+				set(record, e.view());
+
+				for(auto &c : _columns) {
+					if(!c.empty()) {
+						c[record] = boost::none;
+					}
+				}
+				for(auto p : e.properties()) {
+					setproperty(record, propertykey(p.first), p.second);
+				}
+			}
+
+			/**
+			* @brief Copies a record into an ecgdata, with its properties
+			*
+			* @param num Record number
+			*
+			* @return Ecgdata of the record
+			*/
+			Ecgdata<T> record(const std::size_t num) const {
+				Ecgdata<T> e(view(num));
+
+				propertystore props;
+				for(std::size_t id = 0; id < _columns.size(); ++id) {
+					if(!_columns[id].empty() && _columns[id][num]) {
+						props.set(propertykey(propertykey::name(id)), *_columns[id][num]);
+					}
+				}
+				e.setproperties(std::move(props));
+
+				return e;
+			}
+
+			/**
+			* @brief Set a property of a record
+			*
+			* @param record Record number
+			* @param key Property key
+			* @param value Value
+			*/
+			void setproperty(const std::size_t record, const propertykey &key, const propertyvalue &value) {
+				checkrecord(record);
+				if(key.id() >= _columns.size()) {
+					_columns.resize(key.id() + 1);
+				}
+				if(_columns[key.id()].empty()) {
+					_columns[key.id()].resize(_nrecords);
+				}
+
+				_columns[key.id()][record] = value;
+			}
+
+			/**
+			* @brief Typed value of a property of a record
+			*
+			* @tparam V Value type (std::string, double, int, unsigned int)
+			* @param record Record number
+			* @param key Property key
+			*
+			* @return Pointer to the value, nullptr if the record does not have the property or it has another type
+			*/
+			template<class V>
+			const V* findproperty(const std::size_t record, const propertykey &key) const {
+				checkrecord(record);
+				if(key.id() >= _columns.size() || _columns[key.id()].empty() || !_columns[key.id()][record]) {
+					return nullptr;
+				}
+
+				return boost::get<V>(&*_columns[key.id()][record]);
+			}
+
+			/**
+			* @brief Values of a property for all records
+			*
+			* @param key Property key
+			*
+			* @return Column with one entry per record, nullptr if no record has the property
+			*/
+			const propertycolumn* column(const propertykey &key) const {
+				if(key.id() >= _columns.size() || _columns[key.id()].empty()) {
+					return nullptr;
+				}
+
+				return &_columns[key.id()];
+			}
+
+			/**
+			* @brief Column number of a lead within a record
+			*
+			* @param lead Lead
+			*
+			* @return Column number
+			*/
+			int leadnum(const ecglead lead) const {
+				int id = static_cast<int>(lead.index) - ecglead::GLOBAL;
+				if(id < 0 || id >= static_cast<int>(_leadcol.size()) || _leadcol[id] == -1) {
+					std::cerr << "ecglib::EcgBatch::leadnum: lead not in batch";
+					throw ecglib::ecglib_exception("ecglib::EcgBatch::leadnum: lead not in batch");
+				}
+
+				return _leadcol[id];
+			}
+
+		private:
+			/**
+			* @brief Column of a lead of a record in the storage
+			*
+			* @param record Record number
+			* @param lead Column number of the lead
+			*
+			* @return Storage column
+			*/
+			std::size_t storagecol(const std::size_t record, const std::size_t lead) const {
+				return _layout == batchlayout::RECORD_MAJOR ? record * nleads() + lead : lead * _nrecords + record;
+			}
+
+			/**
+			* @brief Distance between two leads of a record in samples
+			*
+			* @return Stride
+			*/
+			std::size_t leadstride() const {
+				return _data->n_rows * (_layout == batchlayout::RECORD_MAJOR ? 1 : _nrecords);
+			}
+
+			/**
+			* @brief Distance between a lead of two consecutive records in samples
+			*
+			* @return Stride
+			*/
+			std::size_t recordstride() const {
+				return _data->n_rows * (_layout == batchlayout::RECORD_MAJOR ? nleads() : 1);
+			}
+
+			/**
+			* @brief Throws if a record number is out of range
+			*
+			* @param record Record number
+			*/
+			void checkrecord(const std::size_t record) const {
+				if(record >= _nrecords) {
+					std::cerr << "ecglib::EcgBatch: no such record";
+					throw ecglib::ecglib_exception("ecglib::EcgBatch: no such record");
+				}
+			}
+
+		// Attributes
+		private:
+			/**
+			* @brief Padded samples x (leads * records), aligned columns
+			*/
+			std::shared_ptr<Mat<T> > _data;
+
+			/**
+			* @brief Number of records
+			*/
+			std::size_t _nrecords;
+
+			/**
+			* @brief Number of samples of every record
+			*/
+			std::size_t _nsamples;
+
+			/**
+			* @brief Lead names of the columns of a record
+			*/
+			std::vector<ecglead> _leadnames;
+
+			/**
+			* @brief Column of each lead name
+			*/
+			leadtable _leadcol;
+
+			/**
+			* @brief Sampling frequency
+			*/
+			double _fs;
+
+			/**
+			* @brief Resolution
+			*/
+			double _res;
+
+			/**
+			* @brief Order of the leads in memory
+			*/
+			batchlayout _layout;
+
+			/**
+			* @brief Property columns indexed by key id, empty if no record has the property
+			*/
+			std::vector<propertycolumn> _columns;
+	};
+
+	/**
+	* @brief Batch of double samples
+	*/
+	typedef EcgBatch<double> ecgbatch;
+
+	/*!
+	 *@}
+	 */
+}
+
+#endif
@@ -32,12 +32,19 @@
 #include <ecglib/util/util.hpp>
 #include <ecglib/annotation.hpp>
 #include <ecglib/ecglib.hpp>
+#include <ecglib/ecgview.hpp>
 
 
 #include <algorithm>
+#include <array>
+#include <iterator>
 #include <vector>
 #include <string>
 #include <map>
+#include <memory>
+#include <cstdint>
+#include <cmath>
+#include <type_traits>
 
 namespace ecglib {
 	/*! \addtogroup core
@@ -52,23 +59,28 @@ namespace ecglib {
 	*
 	* ECGdata consists of:
 	*  - Armadillo of type T to define samples per samples in units of uV (assumed for now) resolution defined in fs
+	*    (T can be int16_t/int32_t to keep raw ADU samples, physical() converts with the gain/baseline of each lead)
 	*    Samples x Leads
 	*  - Properties Auxilary properties, e.g. configuration used for earlier processing step, heart rate for a median beat, start of recording etc
 	*  - Annotations, Annotations for ECG
 	*  - Lead map, defines lead types for leads with known type
 	*
 	* Annotations are stored in a pointmap which links between columns (leads) and annotations.
+	* Copies share the samples and annotations until one of them is changed (copy-on-write), so read-only copies are cheap.
+	* Sub parts by time or leads (subpart()) share the samples of their ecgdata in the same way.
 	*/
 	template<class T>
 	class Ecgdata {
+		template<class U> friend class Ecgdata;
+
 		public:
 		// NOTE: Loops all samples for a leads - lj
-		typedef mat::col_iterator leaditerator;				/**< @brief iterator for ecgleads */
-		typedef mat::const_col_iterator const_leaditerator;		/**< @brief constant iterator for ecgleads */
+		typedef typename Mat<T>::col_iterator leaditerator;		/**< @brief iterator for ecgleads */
+		typedef typename Mat<T>::const_col_iterator const_leaditerator;	/**< @brief constant iterator for ecgleads */
 
 		// NOTE: Loops all samples for all leads - lj
-		typedef mat::row_iterator sampleiterator;			/**< @brief iterator for samples across leads */
-		typedef mat::const_row_iterator const_sampleiterator;		/**< @brief constant iterator for samples across leads */
+		typedef typename Mat<T>::row_iterator sampleiterator;		/**< @brief iterator for samples across leads */
+		typedef typename Mat<T>::const_row_iterator const_sampleiterator;	/**< @brief constant iterator for samples across leads */
 
 		typedef ecglib::annotationset annotationset;			/**< @brief annotation set */
 		typedef ecglib::pointmap pointmap;				/**< @brief pointmap */
@@ -80,45 +92,55 @@ namespace ecglib {
 
 		typedef boost::bimap<leadnumber, ecglead> leadmap;		/**< @brief bimap of leadnumber and ecglead is a leadmap */
 
+		static const int nleadids = EcgView<T>::nleadids;		/**< @brief number of lead names (GLOBAL..UNKNOWN2), size of the lead table */
+		typedef typename EcgView<T>::leadtable leadtable;		/**< @brief column of each lead name (indexed by lead+1, -1 if not in the data) */
+
 		// Constructors
 		public:
 
 			/**
 			* @brief Creates empty ecgdata
 			*/
-			Ecgdata() : _nsamples(0), _res(1), _nleads(0) {}
+			Ecgdata() : _sdata(std::make_shared<Mat<T> >()), _nsamples(0), _rowoffset(0), _leadmap(std::make_shared<leadmap>()), _res(1), _nleads(0), _spoints(std::make_shared<pointmap>()), _readonly(false) {
+				reindex();
+			}
 
 			/**
-			* @brief Creates an ecgdata object of length nsamples, but number of leads based on ecgheader information
+			* @brief Creates an ecgdata object of length nsamples, but number of leads based on ecgheader information. The samples are zero
 			*
 			* @param nsamples Number of samples (could be equal of bigger than nsample  from ecgheader
 			* @param ecgheader
 			*/
-            		Ecgdata(unsigned int nsamples, ecgheader eh) : _data(nsamples,eh.nleads), _nsamples(nsamples),_res(1) {
-
+            		Ecgdata(unsigned int nsamples, ecgheader eh) : _sdata(allocate(nsamples,eh.nleads)), _nsamples(nsamples), _rowoffset(0), _leadmap(std::make_shared<leadmap>()),_res(1), _nleads(eh.nleads), _spoints(std::make_shared<pointmap>()), _readonly(false) {
+				_sdata->zeros();
+				reindex();
 			}
 
 			/**
-			* @brief Creates an ecgdata object of length nsamples, number of columns/leads corresponding to leadnames size
+			* @brief Creates an ecgdata object of length nsamples, number of columns/leads corresponding to leadnames size. The samples are zero
 			*
 			* @param nsamples Number of samples
 			* @param leadnames Lead names of the leads
 			*/
-			Ecgdata(unsigned int nsamples, const std::vector<ecglead> &leadnames) : _data(nsamples,leadnames.size()), _nsamples(nsamples), _res(1), _nleads(leadnames.size()) { 
+			Ecgdata(unsigned int nsamples, const std::vector<ecglead> &leadnames) : _sdata(allocate(nsamples,leadnames.size())), _nsamples(nsamples), _rowoffset(0), _leadmap(std::make_shared<leadmap>()), _res(1), _nleads(leadnames.size()), _spoints(std::make_shared<pointmap>()), _readonly(false) {
+				_sdata->zeros();
 				typedef leadmap::value_type lval;
 
 				for(std::size_t i = 0; i < leadnames.size(); ++i) {
-					_leadmap.insert(lval(i, leadnames[i]));
+					_leadmap->insert(lval(i, leadnames[i]));
 				}
+				reindex();
 			}
 
 			/**
-			* @brief Prepare empty ECG data class
+			* @brief Prepare empty ECG data class, all samples zero
 			*
 			* @param nsamples Number of samples
 			* @param nleads Number of leads
 			*/
-			Ecgdata(unsigned int nsamples, unsigned int nleads) : _data(nsamples, nleads), _nsamples(nsamples), _res(1), _nleads(nleads) {
+			Ecgdata(unsigned int nsamples, unsigned int nleads) : _sdata(allocate(nsamples, nleads)), _nsamples(nsamples), _rowoffset(0), _leadmap(std::make_shared<leadmap>()), _res(1), _nleads(nleads), _spoints(std::make_shared<pointmap>()), _readonly(false) {
+				_sdata->zeros();
+				reindex();
 			}
 
 			/**
@@ -127,7 +149,8 @@ namespace ecglib {
 			* @param indata Input data
 			* @param lm Leadmap
 			*/
-			Ecgdata(const mat &indata, const leadmap &lm) : _data(indata), _nsamples(indata.n_rows), _leadmap(lm), _res(1), _nleads(indata.n_cols) {
+			Ecgdata(const Mat<T> &indata, const leadmap &lm) : _sdata(allocate(indata)), _nsamples(indata.n_rows), _rowoffset(0), _leadmap(std::make_shared<leadmap>(lm)), _res(1), _nleads(indata.n_cols), _spoints(std::make_shared<pointmap>()), _readonly(false) {
+				reindex();
 			}
 
 			/**
@@ -137,7 +160,8 @@ namespace ecglib {
 			* @param fs Sampling frequency
 			* @param res Resolution
 			*/
-			Ecgdata(const mat &indata, const double fs, const double res=1) : _data(indata), _nsamples(indata.n_rows), _fs(fs), _res(res), _nleads(indata.n_cols) {
+			Ecgdata(const Mat<T> &indata, const double fs, const double res=1) : _sdata(allocate(indata)), _nsamples(indata.n_rows), _rowoffset(0), _leadmap(std::make_shared<leadmap>()), _fs(fs), _res(res), _nleads(indata.n_cols), _spoints(std::make_shared<pointmap>()), _readonly(false) {
+				reindex();
 			}
 
 			/**
@@ -146,7 +170,7 @@ namespace ecglib {
 			* @param indata Matrix of data
 			* @param leadnames Lead names of the data
 			*/
-			Ecgdata(const mat &indata, const std::vector<ecglead> &leadnames) : _data(indata), _nsamples(indata.n_rows), _nleads(leadnames.size()) {
+			Ecgdata(const Mat<T> &indata, const std::vector<ecglead> &leadnames) : _sdata(allocate(indata)), _nsamples(indata.n_rows), _rowoffset(0), _leadmap(std::make_shared<leadmap>()), _nleads(leadnames.size()), _spoints(std::make_shared<pointmap>()), _readonly(false) {
 				if(indata.n_cols != _nleads) {
 					std::cerr << "ecglib::constructor::Length of leadnames does not match column count";
 					throw ecglib::ecglib_exception("ecglib::constructor::Length of leadnames does not match column count");
@@ -155,8 +179,83 @@ namespace ecglib {
 				typedef leadmap::value_type lval;
 
 				for(std::size_t i = 0; i < leadnames.size(); ++i) {
-					_leadmap.insert(lval(i, leadnames[i]));
+					_leadmap->insert(lval(i, leadnames[i]));
+				}
+				reindex();
+			}
+
+			/**
+			* @brief Creates an ecgdata class from a view, the samples are copied (columns without lead name are kept without name)
+			*
+			* @param v View of the data
+			*/
+			explicit Ecgdata(const EcgView<const T> &v) : _sdata(allocate(v.nsamples(), v.nleads())), _nsamples(v.nsamples()), _rowoffset(0), _leadmap(std::make_shared<leadmap>()), _fs(v.fs()), _res(v.resolution()), _nleads(v.nleads()), _spoints(std::make_shared<pointmap>()), _readonly(false) {
+				for(std::size_t i = 0; i < _nleads; ++i) {
+					std::copy(v.begin_lead(static_cast<int>(i)), v.end_lead(static_cast<int>(i)), _sdata->begin_col(i));
+				}
+
+				typedef leadmap::value_type lval;
+				for(int id = 0; id < nleadids; ++id) {
+					if(v.leadcols()[id] != -1) {
+						_leadmap->insert(lval(v.leadcols()[id], ecglead(id + ecglead::GLOBAL)));
+					}
+				}
+				reindex();
+
+				if(v.properties() != nullptr) {
+					_props = *v.properties();
+				}
+			}
+
+			/**
+			* @brief Copy constructor, shares samples, leads and annotations with other (copy-on-write)
+			*
+			* @param other Ecgdata
+			*/
+			Ecgdata(const Ecgdata &other) = default;
+
+			/**
+			* @brief Move constructor
+			*
+			* @param other Ecgdata, empty afterwards
+			*/
+			Ecgdata(Ecgdata &&other) noexcept = default;
+
+			/**
+			* @brief Copy assignment, shares samples, leads and annotations with other (copy-on-write)
+			*
+			* @param other Ecgdata
+			*
+			* @return This ecgdata
+			*/
+			Ecgdata& operator=(const Ecgdata &other) = default;
+
+			/**
+			* @brief Move assignment
+			*
+			* @param other Ecgdata, empty afterwards
+			*
+			* @return This ecgdata
+			*/
+			Ecgdata& operator=(Ecgdata &&other) noexcept = default;
+
+			/**
+			* @brief Creates an ecgdata over existing sample storage without copying it, e.g. a memory mapped file
+			*
+			* @param data Samples x leads, rows beyond nsamples are padding (leads can be aligned)
+			* @param nsamples Number of samples
+			* @param lm Leadmap
+			* @param fs Sampling frequency
+			* @param res Resolution
+			* @param readonly The storage must not be written, the first non-const access copies it
+			*/
+			Ecgdata(std::shared_ptr<Mat<T> > data, const std::size_t nsamples, const leadmap &lm, const double fs, const double res, const bool readonly) : _sdata(std::move(data)), _nsamples(nsamples), _rowoffset(0), _leadmap(std::make_shared<leadmap>(lm)), _fs(fs), _res(res), _nleads(_sdata ? _sdata->n_cols : 0), _spoints(std::make_shared<pointmap>()), _readonly(readonly) {
+				if(!_sdata || _sdata->n_rows < _nsamples) {
+					std::cerr << "ecglib::constructor::Storage does not match nsamples";
+					throw ecglib::ecglib_exception("ecglib::constructor::Storage does not match nsamples");
 				}
+
+				reindex();
 			}
 
 		// Public methods
@@ -170,13 +269,7 @@ namespace ecglib {
 			* @return bool true if has lead number
 			*/
 			bool hasleadnum(const ecglead lead) const {
-				leadmap::right_const_iterator rit = _leadmap.right.find(lead.index);
-
-				if(rit == _leadmap.right.end()) {
-					return false;
-				}
-
-				return true;
+				return leadcol(lead) != -1;
 			}
 
 
@@ -188,14 +281,14 @@ namespace ecglib {
 			* @return Column number
 			*/
 			int leadnum(const ecglead lead) const {
-				leadmap::right_const_iterator rit = _leadmap.right.find(lead.index);
+				int col = leadcol(lead);
 
-				if(rit == _leadmap.right.end()) {
+				if(col == -1) {
 					std::cerr << "No such lead";
 					throw ecglib::ecglib_exception("No such lead");
 				}
 
-				return rit->second;
+				return col;
 			}
 
 			/**
@@ -206,18 +299,16 @@ namespace ecglib {
 			* @return lead name
 			*/
 			ecglead leadname(int leadnum) const {
-				leadmap::left_const_iterator lit = _leadmap.left.find(leadnum);
-
-				if(lit == _leadmap.left.end()) {
+				if(leadnum < 0 || leadnum >= static_cast<int>(_collead.size()) || _collead[leadnum] == nolead) {
 					std::cerr << "Lead has no lead name";
 					throw ecglib::ecglib_exception("Lead has no lead name");
 				}
 
-				return lit->second;
+				return ecglead(_collead[leadnum]);
 			}
 
 			/**
-			* @brief Adds a lead to the container. Causes container to resize internal storage (not efficient)
+			* @brief Adds a lead to the container. Causes container to resize internal storage (not efficient, use EcgdataBuilder for loading many leads)
 			*
 			* @tparam ITER An iterator, must be usable by std::copy
 			* @param lead Lead name for the lead to add
@@ -235,21 +326,37 @@ namespace ecglib {
 					std::cerr << "ecglib::add_lead: _nsamples != length";
 					throw ecglib::ecglib_exception("ecglib::add_lead: _nsamples != length");
 				} else {
-					leadmap::right_iterator rit = _leadmap.right.find(lead.index);
-
-					if(rit != _leadmap.right.end()) {
+					if(hasleadnum(lead)) {
 						std::cerr << "ecglib::add_lead:lead is not new";
 						throw ecglib::ecglib_exception("ecglib::add_lead:lead is not new");
 					}
 				}
 
-				_data.reshape(_nsamples,_nleads+1);
+				std::shared_ptr<Mat<T> > d = allocate(_nsamples, _nleads+1);
+				for(std::size_t i = 0; i < _nleads; ++i) {
+					copycol(static_cast<int>(i), d->colptr(i));
+				}
+
+				std::copy(start,stop,d->begin_col(_nleads));
 
-				std::copy(start,stop,_data.begin_col(_nleads));
+				_sdata = d;
+				_rowoffset = 0;
+				_cols.clear();
+				_virtual.clear();
+				_layout.reset();
+				_readonly = false;
 
 				leadmap::value_type lval(newlead, lead.index);
-				_leadmap.insert(lval);
+				mutable_leadmap().insert(lval);
 				++_nleads;
+				reindex();
+
+				if(!_gain.empty()) {
+					_gain.push_back(_res);
+				}
+				if(!_baseline.empty()) {
+					_baseline.push_back(0);
+				}
 			}
 
 		// Setters / Getters
@@ -290,6 +397,66 @@ namespace ecglib {
 				_res = res2;
 			}
 
+			/**
+			* @brief Get gain of a lead
+			*
+			* @param lead Column number
+			*
+			* @return ADU per uV of the lead, resolution() if the lead has no own gain
+			*/
+			double gain(const int lead) const {
+				return (lead >= 0 && lead < static_cast<int>(_gain.size())) ? _gain[lead] : _res;
+			}
+
+			/**
+			* @brief Set gain of a lead
+			*
+			* @param lead Column number
+			* @param g ADU per uV
+			*/
+			void gain(const int lead, const double g) {
+				if(lead < 0 || lead >= static_cast<int>(_nleads) || g == 0) {
+					std::string line = std::string("ecglib::gain: invalid lead or gain");
+					std::cerr << line;
+					throw ecglib::ecglib_exception(line);
+				}
+				if(_gain.empty()) {
+					_gain.assign(_nleads, _res);
+				}
+
+				_gain[lead] = g;
+			}
+
+			/**
+			* @brief Get baseline of a lead
+			*
+			* @param lead Column number
+			*
+			* @return Sample value of 0 uV, 0 if the lead has no own baseline
+			*/
+			double baseline(const int lead) const {
+				return (lead >= 0 && lead < static_cast<int>(_baseline.size())) ? _baseline[lead] : 0;
+			}
+
+			/**
+			* @brief Set baseline of a lead
+			*
+			* @param lead Column number
+			* @param b Sample value of 0 uV
+			*/
+			void baseline(const int lead, const double b) {
+				if(lead < 0 || lead >= static_cast<int>(_nleads)) {
+					std::string line = std::string("ecglib::baseline: invalid lead");
+					std::cerr << line;
+					throw ecglib::ecglib_exception(line);
+				}
+				if(_baseline.empty()) {
+					_baseline.assign(_nleads, 0);
+				}
+
+				_baseline[lead] = b;
+			}
+
 			/**
 			* @brief Get number of samples
 			*
@@ -308,13 +475,22 @@ namespace ecglib {
 				return _nleads;
 			}
 
+			/**
+			* @brief Determine if the samples are read-only external storage, e.g. a memory mapped file
+			*
+			* @return True if the first write copies the samples
+			*/
+			bool readonly() const {
+				return _readonly;
+			}
+
 			/**
 			* @brief Get annotations for data
 			*
 			* @return annotations
 			*/
-			pointmap pointsmap() const {
-				return _points;
+			const pointmap& pointsmap() const {
+				return points();
 			}
 
 			/**
@@ -323,7 +499,16 @@ namespace ecglib {
 			* @param pts annotations
 			*/
 			void pointsmap(const pointmap &pts) {
-				_points = pts;
+				_spoints = std::make_shared<pointmap>(pts);
+			}
+
+			/**
+			* @brief Set annotaitons for data without copying them
+			*
+			* @param pts annotations
+			*/
+			void pointsmap(pointmap &&pts) {
+				_spoints = std::make_shared<pointmap>(std::move(pts));
 			}
 
 			/**
@@ -331,8 +516,8 @@ namespace ecglib {
 			*
 			* @return Vector leads
 			*/
-			leadmap leadnames() const {
-				return _leadmap;
+			const leadmap& leadnames() const {
+				return *_leadmap;
 			}
 
 			/**
@@ -341,7 +526,8 @@ namespace ecglib {
 			* @return Vector leads
 			*/
 			void leadnames(const leadmap &lm) {
-				_leadmap = lm;
+				_leadmap = std::make_shared<leadmap>(lm);
+				reindex();
 			}
 
 			/**
@@ -350,18 +536,34 @@ namespace ecglib {
 			* @param props Props
 			*/
 			void setproperties(const propertymap &props) {
+				_props = propertystore(props);
+			}
+
+			/**
+			* @brief Set all properties
+			*
+			* @param props Props
+			*/
+			void setproperties(const propertystore &props) {
 				_props = props;
 			}
 
+			/**
+			* @brief Set all properties without copying them
+			*
+			* @param props Props
+			*/
+			void setproperties(propertystore &&props) {
+				_props = std::move(props);
+			}
+
 			/**
 			* @brief Insert property map into internal map
 			*
 			* @param props
 			*/
 			void insertproperties(const propertymap &props) {
-				for(auto &r : props) {
-					_props.insert(std::pair<std::string, property>(r.first,r.second));
-				}
+				_props.insert(props);
 			}
 
 			/**
@@ -370,6 +572,15 @@ namespace ecglib {
 			* @return Property map
 			*/
 			propertymap getproperties() const {
+				return _props.map();
+			}
+
+			/**
+			* @brief Get the property store
+			*
+			* @return Properties
+			*/
+			const propertystore& properties() const {
 				return _props;
 			}
 
@@ -380,12 +591,27 @@ namespace ecglib {
 			* @param value Value
 			*/
 			void setproperty(const std::string &nam, const property &prop) {
-				auto propit = _props.find(nam);
-				if(propit != _props.end()) {
-					_props.erase(propit);
-				}
+				_props.set(nam, prop);
+			}
 
-				_props.insert(std::pair<std::string, property>(nam,prop));
+			/**
+			* @brief Set a property by key
+			*
+			* @param key Key
+			* @param value Value
+			*/
+			void setproperty(const propertykey &key, const propertyvalue &value) {
+				_props.set(key, value);
+			}
+
+			/**
+			* @brief Set a property by key without copying the value
+			*
+			* @param key Key
+			* @param value Value
+			*/
+			void setproperty(const propertykey &key, propertyvalue &&value) {
+				_props.set(key, std::move(value));
 			}
 
 			/**
@@ -396,9 +622,7 @@ namespace ecglib {
 			* @return True/false
 			*/
 			bool hasproperty(const std::string &prop) const {
-				auto it = _props.find(prop);
-
-				return !(it == _props.end());
+				return _props.has(prop);
 			}
 
 			/**
@@ -418,15 +642,20 @@ namespace ecglib {
 			* @return Value of property
 			*/
 			property getproperty(const std::string &prop) const {
-				if(!hasproperty(prop)) {
-					std::string line = std::string("No such property: ") + prop;
-					std::cerr << line;
-					throw std::logic_error(line);
-				}
-
-				auto it = _props.find(prop);
+				return _props.get(prop);
+			}
 
-				return it->second;
+			/**
+			* @brief Get a property value of a type without copying it
+			*
+			* @tparam V std::string, double, int or unsigned int
+			* @param key Key
+			*
+			* @return Pointer to the value, nullptr if not set or of another type
+			*/
+			template<class V>
+			const V* findproperty(const propertykey &key) const {
+				return _props.find<V>(key);
 			}
 
 			/**
@@ -434,7 +663,7 @@ namespace ecglib {
 			*
 			* @return Const iterator to start
 			*/
-			propertymap::const_iterator begin_properties() const {
+			propertystore::const_iterator begin_properties() const {
 				return _props.begin();
 			}
 
@@ -443,10 +672,259 @@ namespace ecglib {
 			*
 			* @return Const iterator to end
 			*/
-			propertymap::const_iterator end_properties() const {
+			propertystore::const_iterator end_properties() const {
 				return _props.end();
 			}
 
+		// Physical units
+		public:
+			/**
+			* @brief Get a sample in uV, i.e. (sample - baseline) / gain
+			*
+			* @param lead lead number
+			* @param sample Sample number
+			*
+			* @return Sample in uV
+			*/
+			double physical(const int lead, const int sample) const {
+				return (static_cast<double>(value(lead, sample)) - baseline(lead)) / gain(lead);
+			}
+
+			/**
+			* @brief Get a sample in uV by lead name
+			*
+			* @param lead lead
+			* @param sample Sample number
+			*
+			* @return Sample in uV
+			*/
+			double physical(const ecglead &lead, const int sample) const {
+				return physical(leadnum(lead), sample);
+			}
+
+			/**
+			* @brief Convert a lead to uV
+			*
+			* @param lead lead number
+			*
+			* @return Samples of the lead in uV
+			*/
+			Col<double> physical(const int lead) const {
+				Col<double> out = conv_to<Col<double> >::from(column(lead, 0, _nsamples));
+				out -= baseline(lead);
+				out /= gain(lead);
+
+				return out;
+			}
+
+			/**
+			* @brief Convert a lead to uV by lead name
+			*
+			* @param lead lead
+			*
+			* @return Samples of the lead in uV
+			*/
+			Col<double> physical(const ecglead &lead) const {
+				return physical(leadnum(lead));
+			}
+
+			/**
+			* @brief Convert all leads to uV
+			*
+			* @return Samples x leads in uV
+			*/
+			Mat<double> physical() const {
+				Mat<double> out(_nsamples, _nleads);
+
+				for(uword i = 0; i < out.n_cols; ++i) {
+					out.col(i) = physical(static_cast<int>(i));
+				}
+
+				return out;
+			}
+
+			/**
+			* @brief Convert to an ecgdata in uV with the same leads, annotations and properties (resolution 1)
+			*
+			* @return Ecgdata in uV
+			*/
+			Ecgdata<double> to_physical() const {
+				Ecgdata<double> e(physical(), _fs);
+
+				// leads, annotations and properties are shared, not copied
+				e._leadmap = _leadmap;
+				e.reindex();
+				e._spoints = _spoints;
+				e._props = _props;
+
+				return e;
+			}
+
+		// Virtual leads
+		public:
+			/**
+			* @brief Replaces the stored leads that are derived from others by virtual leads that are computed when they are read.
+			*
+			* III, aVR, aVL and aVF are dropped from storage if I and II are stored with the same gain and baseline 0
+			* (III = II - I, aVR = -(I + II)/2, aVL = I - II/2, aVF = II - I/2). With vcgmag, VCGMAG = sqrt(X^2 + Y^2 + Z^2) is made
+			* virtual as well (and added if it is not stored). The stored leads are assumed to follow these definitions, as recorded 12-lead ECGs do.
+			*
+			* Virtual leads are computed from the stored leads on every read and never kept: lead() returns them as a temporary vector
+			* and operator() computes single samples. begin_lead() has no memory to point to and throws for a virtual lead.
+			* The virtual leads move behind the stored leads, so column numbers change. Writing to the samples computes the virtual leads
+			* into storage first. The const data() and begin_sample() read a laid out copy (see whole()), the const view() a copy owned by the view.
+			*
+			* @param vcgmag Also derive VCGMAG from X, Y and Z
+			*
+			* @return Number of virtual leads
+			*/
+			std::size_t virtualize(const bool vcgmag = false) {
+				std::vector<ecglead> derivedleads;
+				std::vector<derivedlead> definitions;
+
+				auto linear = [&](const ecglead source1, const ecglead source2) {
+					return hasleadnum(source1) && hasleadnum(source2) && gain(leadnum(source1)) == gain(leadnum(source2))
+						&& baseline(leadnum(source1)) == 0 && baseline(leadnum(source2)) == 0;
+				};
+
+				if(linear(ecglead::I, ecglead::II)) {
+					const ecglead leads[4] = {ecglead::III, ecglead::AVR, ecglead::AVL, ecglead::AVF};
+					const double weights[4][2] = {{-1, 1}, {-0.5, -0.5}, {1, -0.5}, {-0.5, 1}};
+
+					for(int k = 0; k < 4; ++k) {
+						if(hasleadnum(leads[k])) {
+							derivedleads.push_back(leads[k]);
+							definitions.push_back(derivedlead{{0, 0, 0}, {weights[k][0], weights[k][1]}, false});
+						}
+					}
+				}
+				bool magnitude = vcgmag && linear(ecglead::X, ecglead::Y) && linear(ecglead::Y, ecglead::Z);
+				if(magnitude) {
+					derivedleads.push_back(ecglead::VCGMAG);
+					definitions.push_back(derivedlead{{0, 0, 0}, {0, 0}, true});
+				}
+				if(derivedleads.empty()) {
+					return _virtual.size();
+				}
+
+				// Stored leads keep their order, the derived leads follow
+				std::vector<int> order;
+				for(std::size_t i = 0; i < _nleads; ++i) {
+					if(_collead.size() <= i || std::find(derivedleads.begin(), derivedleads.end(), ecglead(_collead[i])) == derivedleads.end()) {
+						order.push_back(static_cast<int>(i));
+					}
+				}
+
+				std::shared_ptr<Mat<T> > d = allocate(_nsamples, order.size());
+				leadmap lm;
+				std::vector<double> g, b;
+				for(std::size_t i = 0; i < order.size(); ++i) {
+					copycol(order[i], d->colptr(i));
+					if(order[i] < static_cast<int>(_collead.size()) && _collead[order[i]] != nolead) {
+						lm.insert(typename leadmap::value_type(i, ecglead(_collead[order[i]])));
+					}
+					g.push_back(gain(order[i]));
+					b.push_back(baseline(order[i]));
+				}
+
+				for(std::size_t k = 0; k < derivedleads.size(); ++k) {
+					lm.insert(typename leadmap::value_type(order.size() + k, derivedleads[k]));
+					g.push_back(definitions[k].magnitude ? gain(leadnum(ecglead::X)) : gain(leadnum(ecglead::I)));
+					b.push_back(0);
+				}
+
+				_sdata = d;
+				_rowoffset = 0;
+				_cols.clear();
+				_layout.reset();
+				_readonly = false;
+				_nleads = order.size() + derivedleads.size();
+				_leadmap = std::make_shared<leadmap>(std::move(lm));
+				reindex();
+				if(!_gain.empty()) {
+					_gain = g;
+				}
+				if(!_baseline.empty()) {
+					_baseline = b;
+				}
+
+				// The sources are stored, so their storage columns are their new columns
+				for(std::size_t k = 0; k < definitions.size(); ++k) {
+					derivedlead &v = definitions[k];
+
+					if(v.magnitude) {
+						v.src[0] = leadnum(ecglead::X);
+						v.src[1] = leadnum(ecglead::Y);
+						v.src[2] = leadnum(ecglead::Z);
+					} else {
+						v.src[0] = leadnum(ecglead::I);
+						v.src[1] = leadnum(ecglead::II);
+						v.src[2] = v.src[0]; // unused
+					}
+				}
+				_virtual = definitions;
+
+				return _virtual.size();
+			}
+
+			/**
+			* @brief Determine if a lead is virtual, i.e. computed from other leads when read (see virtualize())
+			*
+			* @param lead Lead name
+			*
+			* @return True if the lead is virtual
+			*/
+			bool isvirtual(const ecglead lead) const {
+				return hasleadnum(lead) && storagecol(leadnum(lead)) >= samples().n_cols;
+			}
+
+		// Views
+		public:
+			/**
+			* @brief Writable view of all samples (no copy, but shared samples are detached first). The view is invalidated when the data is resized or destroyed
+			*
+			* @return View
+			*/
+			EcgView<T> view() {
+				Mat<T> &d = mutable_samples();
+
+				return EcgView<T>(d.memptr(), _nsamples, d.n_cols, d.n_rows, _leadcol, _fs, _res, &_props);
+			}
+
+			/**
+			* @brief Read-only view of all samples (no copy). The view is invalidated when the data is resized or destroyed.
+			* With virtual leads the leads are laid out into a copy that the view owns, see EcgView::owner()
+			*
+			* @return View
+			*/
+			EcgView<const T> view() const {
+				if(!uniformcols()) {
+					std::shared_ptr<const Mat<T> > d = layout();
+					EcgView<const T> v(d->memptr(), _nsamples, _nleads, d->n_rows, _leadcol, _fs, _res, &_props);
+					v.owner(d);
+
+					return v;
+				}
+
+				const Mat<T> &d = samples();
+				uword first = _cols.empty() ? 0 : _cols[0];
+				uword step = _cols.size() > 1 ? _cols[1] - _cols[0] : 1;
+
+				return EcgView<const T>(d.memptr() + first*d.n_rows + _rowoffset, _nsamples, _nleads, step*d.n_rows, _leadcol, _fs, _res, &_props);
+			}
+
+			/**
+			* @brief Read-only view of a range of samples (no copy), the view equivalent of subpart(starttime, stoptime) without annotations
+			*
+			* @param start First sample
+			* @param stop Last sample (inclusive)
+			*
+			* @return View of the range
+			*/
+			EcgView<const T> view(const std::size_t start, const std::size_t stop) const {
+				return view().slice(start, stop);
+			}
+
 		// Container methods
 		public:
 			/**
@@ -457,10 +935,8 @@ namespace ecglib {
 			*
 			* @return sample reference
 			*/
-			double& operator()(const ecglead &lead, const int sample) {
-				int leadn = leadnum(lead);		
-
-				return _data(sample,leadnum(leadn));
+			T& operator()(const ecglead &lead, const int sample) {
+				return mutable_samples()(sample,leadnum(lead));
 			}
 
 			/**
@@ -471,22 +947,20 @@ namespace ecglib {
 			*
 			* @return sample value
 			*/
-			double operator()(const ecglead &lead, const int sample) const {
-				int leadn = leadnum(lead);		
-
-				return _data(sample,leadnum(lead));
+			T operator()(const ecglead &lead, const int sample) const {
+				return value(leadnum(lead), sample);
 			}
 
 			/**
-			* @brief Get subview of ECG for a lead
+			* @brief Get part of a lead (no copy, except for virtual leads)
 			*
 			* @param rowspan Row span for samples
 			* @param colnum Column number
 			*
-			* @return col vec of subview of lead of ECG
+			* @return col vec of the lead of ECG
 			*/
-			const subview_col<T> operator()(const span& rowspan, const uword colnum) const {
-				return _data(rowspan, colnum);
+			const Col<T> operator()(const span& rowspan, const uword colnum) const {
+				return rowspan.whole ? lead(static_cast<int>(colnum)) : lead(static_cast<int>(colnum), static_cast<int>(rowspan.a), static_cast<int>(rowspan.b));
 			}
 
 			/**
@@ -497,8 +971,8 @@ namespace ecglib {
 			*
 			* @return sample reference
 			*/
-			double& operator()(const int lead, const int sample) {
-				return _data(sample,lead);
+			T& operator()(const int lead, const int sample) {
+				return mutable_samples()(sample,lead);
 			}
 
 			/**
@@ -509,8 +983,8 @@ namespace ecglib {
 			*
 			* @return sample value
 			*/
-			double operator()(const int lead, const int sample) const {
-				return _data(sample,lead);
+			T operator()(const int lead, const int sample) const {
+				return value(lead, sample);
 			}
 
 			/**
@@ -520,23 +994,24 @@ namespace ecglib {
 			*
 			* @return lead (subview)
 			*/
-			subview_col<double> lead(const ecglead lead) {
+			subview_col<T> lead(const ecglead lead) {
 				int leadn = leadnum(lead);		
 
-				return _data.col(leadn);
+				return mutable_samples().col(leadn).head(_nsamples);
 			}
 
 			/**
-			* @brief Const-correct get lead by number
+			* @brief Const-correct get lead by number, a vector over the samples (no copy) or the computed samples of a virtual lead.
+			* Like EcgView::lead() the vector uses the memory of the ecgdata, copy it before changing it
 			*
 			* @param lead lead number
 			*
-			* @return lead (subview) constant
+			* @return lead constant
 			*/
-			const subview_col<double> lead(const ecglead lead) const {
+			const Col<T> lead(const ecglead lead) const {
 				int leadn = leadnum(lead);		
 
-				return _data.col(leadn);
+				return column(leadn, 0, _nsamples);
 			}
 
 			/**
@@ -546,19 +1021,20 @@ namespace ecglib {
 			*
 			* @return lead (subview)
 			*/
-			subview_col<double> lead(const int lead) {
-				return _data.col(lead);
+			subview_col<T> lead(const int lead) {
+				return mutable_samples().col(lead).head(_nsamples);
 			}
 
 			/**
-			* @brief Const-correct get lead by number
+			* @brief Const-correct get lead by number, a vector over the samples (no copy) or the computed samples of a virtual lead.
+			* Like EcgView::lead() the vector uses the memory of the ecgdata, copy it before changing it
 			*
 			* @param lead lead number
 			*
-			* @return lead (subview) constant
+			* @return lead constant
 			*/
-			const subview_col<double> lead(const int lead) const {
-				return _data.col(lead);
+			const Col<T> lead(const int lead) const {
+				return column(lead, 0, _nsamples);
 			}
 
 			/**
@@ -570,8 +1046,8 @@ namespace ecglib {
 			*
 			* @return part of lead 
 			*/
-			subview_col<double> lead(const int lead, const int start, const int stop) {
-				return _data(span(start,stop),lead);
+			subview_col<T> lead(const int lead, const int start, const int stop) {
+				return mutable_samples()(span(start,stop),lead);
 			}
 
 			/**
@@ -583,8 +1059,14 @@ namespace ecglib {
 			*
 			* @return part of lead constant
 			*/
-			const subview_col<double> lead(const int lead, const int start, const int stop) const {
-				return _data(span(start,stop),lead);
+			const Col<T> lead(const int lead, const int start, const int stop) const {
+				if(start < 0 || start > stop || stop >= static_cast<int>(_nsamples)) {
+					std::string line = std::string("Start_or_stop_incorrect");
+					std::cerr << line;
+					throw ecglib::ecglib_exception(line);
+				}
+
+				return column(lead, start, stop - start + 1);
 			}
 
 			/**
@@ -596,10 +1078,10 @@ namespace ecglib {
 			*
 			* @return part of lead 
 			*/
-			subview_col<double> lead(const ecglead lead, const int start, const int stop) {
+			subview_col<T> lead(const ecglead lead, const int start, const int stop) {
 				int leadn = leadnum(lead);		
 
-				return _data(span(start,stop),leadn);
+				return mutable_samples()(span(start,stop),leadn);
 			}
 
 			/**
@@ -611,10 +1093,8 @@ namespace ecglib {
 			*
 			* @return part of lead constant
 			*/
-			const subview_col<double> lead(const ecglead lead, const int start, const int stop) const {
-				int leadn = leadnum(lead);
-
-				return _data(span(start,stop),leadn);
+			const Col<T> lead(const ecglead lead, const int start, const int stop) const {
+				return this->lead(leadnum(lead), start, stop);
 			}
 
 			/**
@@ -622,8 +1102,8 @@ namespace ecglib {
 			*
 			* @return data
 			*/
-			subview<double> data() {
-				return _data(span::all,span::all);
+			subview<T> data() {
+				return mutable_samples().head_rows(_nsamples);
 			}
 
 			/**
@@ -631,8 +1111,11 @@ namespace ecglib {
 			*
 			* @return data const
 			*/
-			subview<double> data() const {
-				return _data(span::all,span::all);
+			const subview<T> data() const {
+				std::size_t first;
+				const Mat<T> &d = whole(first);
+
+				return _nsamples == 0 ? d.head_rows(0) : d.rows(first, first + _nsamples - 1);
 			}
 
 			/**
@@ -643,7 +1126,7 @@ namespace ecglib {
 			* @return lead iterator
 			*/
 			leaditerator begin_lead(const ecglead &lead) {
-				return _data.begin_col(leadnum(lead));
+				return mutable_samples().begin_col(leadnum(lead));
 			}
 
 			/**
@@ -654,7 +1137,7 @@ namespace ecglib {
 			* @return lead iterator
 			*/
 			leaditerator end_lead(const ecglead &lead) {
-				return _data.end_col(leadnum(lead));
+				return mutable_samples().begin_col(leadnum(lead)) + _nsamples;
 			}
 
 			/**
@@ -665,7 +1148,7 @@ namespace ecglib {
 			* @return lead iterator const
 			*/
 			const_leaditerator begin_lead(const ecglead &lead) const {
-				return _data.begin_col(leadnum(lead));
+				return colbegin(leadnum(lead));
 			}
 
 			/**
@@ -676,7 +1159,7 @@ namespace ecglib {
 			* @return lead iterator const
 			*/
 			const_leaditerator end_lead(const ecglead &lead) const {
-				return _data.end_col(leadnum(lead));
+				return colbegin(leadnum(lead)) + _nsamples;
 			}
 
 			/**
@@ -687,7 +1170,7 @@ namespace ecglib {
 			* @return lead iterator
 			*/
 			leaditerator begin_lead(int num) {
-				return _data.begin_col(num);
+				return mutable_samples().begin_col(num);
 			}
 
 			/**
@@ -698,7 +1181,7 @@ namespace ecglib {
 			* @return lead iterator
 			*/
 			leaditerator end_lead(int num) {
-				return _data.end_col(num);
+				return mutable_samples().begin_col(num) + _nsamples;
 			}
 
 			/**
@@ -709,7 +1192,7 @@ namespace ecglib {
 			* @return lead iterator const
 			*/
 			const_leaditerator begin_lead(int num) const {
-				return _data.begin_col(num);
+				return colbegin(num);
 			}
 
 			/**
@@ -720,7 +1203,7 @@ namespace ecglib {
 			* @return lead iterator const
 			*/
 			const_leaditerator end_lead(int num) const {
-				return _data.end_col(num);
+				return colbegin(num) + _nsamples;
 			}
 
 			/**
@@ -731,7 +1214,7 @@ namespace ecglib {
 			* @return sample iterator
 			*/
 			sampleiterator begin_sample(int sample) {
-				return _data.begin_row(sample);
+				return mutable_samples().begin_row(sample);
 			}
 
 			/**
@@ -742,7 +1225,7 @@ namespace ecglib {
 			* @return sample iterator
 			*/
 			sampleiterator end_sample(int sample) {
-				return _data.end_row(sample);
+				return mutable_samples().end_row(sample);
 			}
 
 			/**
@@ -753,7 +1236,10 @@ namespace ecglib {
 			* @return sample iterator const
 			*/
 			const_sampleiterator begin_sample(int sample) const {
-				return _data.begin_row(sample);
+				std::size_t first;
+				const Mat<T> &d = whole(first);
+
+				return d.begin_row(first + sample);
 			}
 
 			/**
@@ -764,7 +1250,10 @@ namespace ecglib {
 			* @return sample iterator const
 			*/
 			const_sampleiterator end_sample(int sample) const {
-				return _data.end_row(sample);
+				std::size_t first;
+				const Mat<T> &d = whole(first);
+
+				return d.end_row(first + sample);
 			}
 
 			/**
@@ -775,7 +1264,7 @@ namespace ecglib {
 			* @return iterator to end
 			*/
 			pointmapiterator pointmap_begin() {
-				return _points.begin();
+				return mutable_points().begin();
 			}
 
 			/**
@@ -786,7 +1275,7 @@ namespace ecglib {
 			* @return iterator to end
 			*/
 			pointmapiterator pointmap_end() {
-				return _points.end();
+				return mutable_points().end();
 			}
 
 			/**
@@ -797,7 +1286,7 @@ namespace ecglib {
 			* @return iterator to begin
 			*/
 			const_pointmapiterator pointmap_begin() const {
-				return _points.begin();
+				return points().begin();
 			}
 
 			/**
@@ -808,7 +1297,7 @@ namespace ecglib {
 			* @return iterator to end
 			*/
 			const_pointmapiterator pointmap_end() const {
-				return _points.end();
+				return points().end();
 			}
 
 			/**
@@ -821,9 +1310,10 @@ namespace ecglib {
 			pointiterator points_begin(const ecglead &lead) {
 				int leadn = leadnum(lead);
 
-				pointmapiterator iter = _points.find(leadn);
+				pointmap &pts = mutable_points();
+				pointmapiterator iter = pts.find(leadn);
 
-				if(iter == _points.end()){
+				if(iter == pts.end()){
 					std::cerr << "Could not find annotations for lead";
 					throw std::runtime_error("Could not find annotations for lead");
 				}
@@ -839,9 +1329,10 @@ namespace ecglib {
 			* @return iterator to begin
 			*/
 			pointiterator points_begin(const leadnumber leadn) {
-				pointmapiterator iter = _points.find(leadn);
+				pointmap &pts = mutable_points();
+				pointmapiterator iter = pts.find(leadn);
 
-				if(iter == _points.end()){
+				if(iter == pts.end()){
 					std::cerr << "Could not find annotations for lead";
 					throw std::runtime_error("Could not find annotations for lead");
 				}
@@ -859,9 +1350,10 @@ namespace ecglib {
 			pointiterator points_end(const ecglead &lead) {
 				int leadn = leadnum(lead);
 
-				pointmapiterator iter = _points.find(leadn);
+				pointmap &pts = mutable_points();
+				pointmapiterator iter = pts.find(leadn);
 
-				if(iter == _points.end()){
+				if(iter == pts.end()){
 					std::cerr << "Could not find annotations for lead";
 					throw std::runtime_error("Could not find annotations for lead");
 				}
@@ -877,9 +1369,10 @@ namespace ecglib {
 			* @return iterator to begin
 			*/
 			pointiterator points_end(const leadnumber leadn) {
-				pointmapiterator iter = _points.find(leadn);
+				pointmap &pts = mutable_points();
+				pointmapiterator iter = pts.find(leadn);
 
-				if(iter == _points.end()){
+				if(iter == pts.end()){
 					std::cerr << "Could not find annotations for lead";
 					throw std::runtime_error("Could not find annotations for lead");
 				}
@@ -895,9 +1388,9 @@ namespace ecglib {
 			* @return const iterator to begin
 			*/
 			const_pointiterator points_begin(const leadnumber leadn) const {
-				const_pointmapiterator iter = _points.find(leadn);
+				const_pointmapiterator iter = points().find(leadn);
 
-				if(iter == _points.end()){
+				if(iter == points().end()){
 					std::cerr << "Could not find annotations for lead";
 					throw std::runtime_error("Could not find annotations for lead");
 				}
@@ -913,9 +1406,9 @@ namespace ecglib {
 			* @return const iterator to end
 			*/
 			const_pointiterator points_end(const leadnumber leadn) const {
-				const_pointmapiterator iter = _points.find(leadn);
+				const_pointmapiterator iter = points().find(leadn);
 
-				if(iter == _points.end()){
+				if(iter == points().end()){
 					std::cerr << "Could not find annotations for lead";
 					throw std::runtime_error("Could not find annotations for lead");
 				}
@@ -933,9 +1426,9 @@ namespace ecglib {
 			const_pointiterator points_begin(const ecglead &lead) const {
 				int leadn = leadnum(lead);
 
-				const_pointmapiterator iter = _points.find(leadn);
+				const_pointmapiterator iter = points().find(leadn);
 
-				if(iter == _points.end()){
+				if(iter == points().end()){
 					std::cerr << "Could not find annotations for lead";
 					throw std::runtime_error("Could not find annotations for lead");
 				}
@@ -952,9 +1445,9 @@ namespace ecglib {
 			const_pointiterator points_end(const ecglead &lead) const {
 				int leadn = leadnum(lead);
 
-				const_pointmapiterator iter = _points.find(leadn);
+				const_pointmapiterator iter = points().find(leadn);
 
-				if(iter == _points.end()){
+				if(iter == points().end()){
 					std::cerr << "Could not find annotations for lead";
 					throw std::runtime_error("Could not find annotations for lead");
 				}
@@ -963,7 +1456,8 @@ namespace ecglib {
 			}
 
 			/**
-			* @brief Extracts a sub-part of an ecgdata class
+			* @brief Extracts a sub-part of an ecgdata class. The sub part shares the samples with this ecgdata (no copy, see mutable_samples()),
+			* only the annotations of the window are copied and rebased
 			*
 			* @param start First sample
 			* @param stop Last sample
@@ -979,91 +1473,456 @@ namespace ecglib {
 				unsigned int start = static_cast<unsigned int>(round((starttime/1000.) * _fs)); 
 				unsigned int stop = static_cast<unsigned int>(round((stoptime/1000.) * _fs)); 
 
-				if(start < 0 || stop > _nsamples || start > stop) {
+				if(start < 0 || stop >= _nsamples || start > stop) {
 					std::string line = std::string("Start_or_stop_incorrect");
 					std::cerr << line;
 					throw ecglib::ecglib_exception(line);
 				}
 
-				Ecgdata<T> e(_data(span(start,stop),span::all), _leadmap);
-
-				e.fs( _fs);
-				e.resolution(_res);
+				Ecgdata<T> e(*this);
+				e._props.clear();
+				e._nsamples = stop - start + 1;
+				e._rowoffset = _rowoffset + start;
 
-				// Copy annotations
+				// O(window): the annotations in [starttime, stoptime] are copied by range and rebased in place
+				const timems first = static_cast<timems>(starttime);
+				const timems last = static_cast<timems>(stoptime);
 				pointmap pm;
+				for(const_pointmapiterator pmi = _spoints->begin(); pmi != _spoints->end(); ++pmi) {
+					const annotationset &src = pmi->second;
+					annotationset &as = pm[pmi->first];
 
-				const_pointmapiterator pmend = _points.end();
-				for(const_pointmapiterator pmi = _points.begin(); pmi != pmend; ++pmi) {
-					const_pointiterator pistart = pmi->second.lower_bound(starttime);
-					const_pointiterator pistop = pmi->second.upper_bound(stoptime);
-
-					annotationset as;
-
-					while(pistart != pistop) {
-						as[pistart->first-starttime] = pistart->second-static_cast<unsigned int>(starttime);
-
-						++pistart;
-					}
-
-					pm[pmi->first] = as;
+					as = annotationset(src.lower_bound(first), src.upper_bound(last));
+					as.rebase(starttime);
 				}
-
-				e.pointsmap(pm);
+				e._spoints = std::make_shared<pointmap>(std::move(pm));
 
 				return e; 
 			}
 
 			/**
-			 * @brief Extracts a sub-part of an ecgdata class
+			 * @brief Extracts a sub-part of an ecgdata class. The sub part shares the samples with this ecgdata (no copy, see mutable_samples())
+			 * if the leads are stored equally spaced in increasing order, otherwise they are copied once here.
+			 * The annotations of GLOBAL_LEAD and leads are copied, the others are dropped
 			 *
 			 * @param leads ECG leads
 			 *
 			 * @return ECGdata
 			 */
 			Ecgdata<T> subpart(const std::vector<ecglib::ecglead> &leads) const {
-				mat ecg = zeros<mat>(_nsamples+1, leads.size());
+				Ecgdata<T> e(*this);
+				e._props.clear();
+				e._cols.resize(leads.size());
+				e._leadmap = std::make_shared<leadmap>();
+				e._gain.clear();
+				e._baseline.clear();
 
 				for(std::size_t i = 0; i < leads.size(); ++i) {
-					std::copy(begin_lead(leads[i]),end_lead(leads[i]), ecg.begin_col(i));
+					int leadn = leadnum(leads[i]);
+
+					e._cols[i] = storagecol(leadn);
+					e._leadmap->insert(typename leadmap::value_type(i, leads[i]));
+					if(!_gain.empty()) {
+						e._gain.push_back(gain(leadn));
+					}
+					if(!_baseline.empty()) {
+						e._baseline.push_back(baseline(leadn));
+					}
 				}
+				e._nleads = leads.size();
+				e.reindex();
 
-				Ecgdata<T> e(ecg, leads);
-				e.fs( _fs);
-				e.resolution(_res);
-				Ecgdata<T>::pointmap pm;
-				typedef Ecgdata<T>::const_pointmapiterator pmiter;
-				pmiter pmend = _points.end();
+				// Only columns a view can address with a stride are shared, reads of the sub part never change its storage
+				bool stored = true;
+				for(std::size_t i = 0; i < e._cols.size(); ++i) {
+					stored = stored && e._cols[i] < samples().n_cols;
+				}
+				if(stored) {
+					e._virtual.clear();
+				}
+				if(!e.uniformcols()) {
+					e._sdata = e.layout();
+					e._rowoffset = 0;
+					e._cols.clear();
+					e._virtual.clear();
+					e._readonly = false;
+				}
 
-				typedef std::vector<ecglead>::const_iterator liter;
-				liter lend = leads.end();
+				pointmap pm;
+				if(_spoints->has(ecglib::GLOBAL_LEAD)) {
+					pm[ecglib::GLOBAL_LEAD] = (*_spoints)[ecglib::GLOBAL_LEAD];
+				}
+				for(std::size_t i = 0; i < leads.size(); ++i) {
+					leadnumber l = leads[i].index;
 
-				for(pmiter pmi = _points.begin(); pmi != pmend; ++pmi) {
-					if(pmi->first == ecglib::GLOBAL_LEAD) {
-						pm[pmi->first] = pmi->second;
-					} else {
-						for(liter li = leads.begin(); li != lend; ++li) {
-							if(*li == pmi->first) {
-								pm[pmi->first] = pmi->second;
-							}
-						}
+					if(_spoints->has(l)) {
+						pm[l] = (*_spoints)[l];
 					}
 				}
-
-				e.pointsmap(pm);
+				e._spoints = std::make_shared<pointmap>(std::move(pm));
 
 				return e;
 			}
 
+		// Storage
+		public:
+			/**
+			* @brief Number of rows allocated for a lead of nsamples, i.e. nsamples rounded up to SAMPLE_ALIGNMENT bytes
+			*
+			* @param nsamples Number of samples
+			*
+			* @return Stride of the leads
+			*/
+			static std::size_t padded(const std::size_t nsamples) {
+				return ((nsamples * sizeof(T) + SAMPLE_ALIGNMENT - 1) / SAMPLE_ALIGNMENT) * SAMPLE_ALIGNMENT / sizeof(T);
+			}
+
+			/**
+			* @brief Allocates samples x leads storage in which every lead starts on a SAMPLE_ALIGNMENT boundary and is padded
+			* to padded(nsamples) rows. The padding is zero, so kernels can process whole vectors up to the stride without a scalar tail.
+			* The samples are not initialized, constructors that do not copy samples into the storage zero it.
+			*
+			* @param nsamples Number of samples
+			* @param nleads Number of leads
+			*
+			* @return Storage with padded(nsamples) rows, for the shared storage constructor
+			*/
+			static std::shared_ptr<Mat<T> > allocate(const std::size_t nsamples, const std::size_t nleads) {
+				std::size_t stride = padded(nsamples);
+				std::size_t bytes = stride * nleads * sizeof(T);
+
+				if(bytes == 0) {
+					return std::make_shared<Mat<T> >(nsamples, nleads);
+				}
+
+				char *mem = new char[bytes + SAMPLE_ALIGNMENT];
+				void *ptr = mem;
+				std::size_t space = bytes + SAMPLE_ALIGNMENT;
+				std::align(SAMPLE_ALIGNMENT, bytes, ptr, space);
+
+				T *samples = static_cast<T*>(ptr);
+				for(std::size_t i = 0; i < nleads; ++i) {
+					std::fill(samples + i*stride + nsamples, samples + (i+1)*stride, T(0));
+				}
+
+				return std::shared_ptr<Mat<T> >(new Mat<T>(samples, stride, nleads, false, true), alignedstorage{mem});
+			}
+
+			/**
+			* @brief Copies a matrix into aligned storage
+			*
+			* @param m Samples x leads
+			*
+			* @return Storage with padded rows, see allocate()
+			*/
+			static std::shared_ptr<Mat<T> > allocate(const Mat<T> &m) {
+				std::shared_ptr<Mat<T> > d = allocate(m.n_rows, m.n_cols);
+
+				for(uword i = 0; i < m.n_cols; ++i) {
+					std::copy(m.begin_col(i), m.end_col(i), d->begin_col(i));
+				}
+
+				return d;
+			}
+
 		// Helpers
 		private:
+			/**
+			* @brief Samples for reading
+			*
+			* @return Sample matrix (possibly shared with other copies and larger than this ecgdata, see storagecol(), without virtual leads)
+			*/
+			const Mat<T>& samples() const {
+				return *_sdata;
+			}
+
+			/**
+			* @brief Samples for writing. Copies of an ecgdata share their samples until one of them is changed (copy-on-write),
+			* so the samples are deep copied first if they are shared, read-only (mapped) or a sub part of larger storage. Every non-const accessor goes through here.
+			*
+			* @return Sample matrix owned only by this ecgdata, padded(nsamples) x nleads
+			*/
+			Mat<T>& mutable_samples() {
+				if(_rowoffset != 0 || !_cols.empty() || !_virtual.empty() || _sdata.use_count() > 1 || _readonly) {
+					_sdata = layout();
+					_rowoffset = 0;
+					_cols.clear();
+					_virtual.clear();
+					_layout.reset();
+					_readonly = false;
+				}
+
+				return *_sdata;
+			}
+
+			/**
+			* @brief Storage column of a column
+			*
+			* @param col Column number
+			*
+			* @return Column number in the shared samples, virtual lead k is samples().n_cols + k
+			*/
+			uword storagecol(const int col) const {
+				return _cols.empty() ? static_cast<uword>(col) : _cols[col];
+			}
+
+			/**
+			* @brief Samples of a column, a vector over the shared samples (no copy) or the computed samples of a virtual lead
+			*
+			* @param col Column number
+			* @param start First sample
+			* @param n Number of samples
+			*
+			* @return Vector of n samples
+			*/
+			const Col<T> column(const int col, const std::size_t start, const std::size_t n) const {
+				uword sc = storagecol(col);
+
+				if(sc >= samples().n_cols) {
+					Col<T> out(n);
+					derive(sc - samples().n_cols, start, n, out.memptr());
+
+					return out;
+				}
+
+				return Col<T>(const_cast<T*>(samples().colptr(sc)) + _rowoffset + start, n, false, true);
+			}
+
+			/**
+			* @brief First sample of a column in the shared samples, virtual leads are not in memory
+			*
+			* @param col Column number
+			*
+			* @return Pointer to nsamples samples
+			*/
+			const T* colbegin(const int col) const {
+				uword sc = storagecol(col);
+
+				if(sc >= samples().n_cols) {
+					std::cerr << "ecglib::Ecgdata::begin_lead: virtual lead, read it with lead()";
+					throw ecglib::ecglib_exception("ecglib::Ecgdata::begin_lead: virtual lead, read it with lead()");
+				}
+
+				return samples().colptr(sc) + _rowoffset;
+			}
+
+			/**
+			* @brief Sample of a column in the shared samples or computed for a virtual lead
+			*
+			* @param col Column number
+			* @param sample Sample number
+			*
+			* @return Sample value
+			*/
+			T value(const int col, const std::size_t sample) const {
+				uword sc = storagecol(col);
+
+				if(sc >= samples().n_cols) {
+					T v;
+					derive(sc - samples().n_cols, sample, 1, &v);
+
+					return v;
+				}
+
+				return samples().colptr(sc)[_rowoffset + sample];
+			}
+
+			/**
+			* @brief Computes samples of a virtual lead from its source leads
+			*
+			* @param k Virtual lead
+			* @param start First sample
+			* @param n Number of samples
+			* @param[out] out Memory for n samples
+			*/
+			void derive(const std::size_t k, const std::size_t start, const std::size_t n, T *out) const {
+				const derivedlead &v = _virtual[k];
+				const T *a = samples().colptr(v.src[0]) + _rowoffset + start;
+				const T *b = samples().colptr(v.src[1]) + _rowoffset + start;
+				const T *c = samples().colptr(v.src[2]) + _rowoffset + start;
+
+				for(std::size_t i = 0; i < n; ++i) {
+					double x = v.magnitude ? std::sqrt(static_cast<double>(a[i])*a[i] + static_cast<double>(b[i])*b[i] + static_cast<double>(c[i])*c[i]) : v.w[0]*a[i] + v.w[1]*b[i];
+
+					out[i] = static_cast<T>(std::is_integral<T>::value ? std::floor(x + 0.5) : x);
+				}
+			}
+
+			/**
+			* @brief Copies the samples of a column, virtual leads are computed
+			*
+			* @param col Column number
+			* @param[out] out Memory for nsamples samples
+			*/
+			void copycol(const int col, T *out) const {
+				uword sc = storagecol(col);
+
+				if(sc >= samples().n_cols) {
+					derive(sc - samples().n_cols, 0, _nsamples, out);
+				} else {
+					const T *src = samples().colptr(sc) + _rowoffset;
+					std::copy(src, src + _nsamples, out);
+				}
+			}
+
+			/**
+			* @brief Determine if the columns are equally spaced in the shared samples, i.e. a view can address them with a stride
+			*
+			* @return True if the columns are equally spaced
+			*/
+			bool uniformcols() const {
+				if(!_virtual.empty()) {
+					return false;
+				}
+
+				for(std::size_t i = 2; i < _cols.size(); ++i) {
+					if(_cols[i] - _cols[i-1] != _cols[1] - _cols[0]) {
+						return false;
+					}
+				}
+
+				return _cols.size() < 2 || _cols[1] > _cols[0];
+			}
+
+			/**
+			* @brief Copies the samples of this ecgdata out of the shared samples into aligned storage
+			*
+			* @return Nsamples x nleads, see allocate()
+			*/
+			std::shared_ptr<Mat<T> > layout() const {
+				std::shared_ptr<Mat<T> > d = allocate(_nsamples, _nleads);
+
+				for(std::size_t i = 0; i < _nleads; ++i) {
+					copycol(static_cast<int>(i), d->colptr(i));
+				}
+
+				return d;
+			}
+
+			/**
+			* @brief Releases aligned storage together with the matrix wrapping it
+			*/
+			struct alignedstorage {
+				char *mem;
+
+				void operator()(Mat<T> *m) const {
+					delete m;
+					delete[] mem;
+				}
+			};
+
+			/**
+			* @brief Samples with the columns in order for whole-matrix reads (data(), begin_sample()). Columns of a sub part of leads
+			* or virtual leads are laid out into a copy on the first such read. The copy is published atomically and kept until
+			* the ecgdata is changed, so concurrent reads are safe and earlier subviews stay valid
+			*
+			* @param[out] first Row of the first sample
+			*
+			* @return Sample matrix with the columns of this ecgdata
+			*/
+			const Mat<T>& whole(std::size_t &first) const {
+				if(_cols.empty() && _virtual.empty()) {
+					first = _rowoffset;
+					return *_sdata;
+				}
+
+				std::shared_ptr<const Mat<T> > d = std::atomic_load(&_layout.samples);
+				if(!d) {
+					std::shared_ptr<const Mat<T> > fresh = layout();
+					if(std::atomic_compare_exchange_strong(&_layout.samples, &d, fresh)) {
+						d = fresh;
+					}
+				}
+
+				first = 0;
+				return *d;
+			}
+
+			/**
+			* @brief Lead map for writing, deep copied first if it is shared (copy-on-write)
+			*
+			* @return Lead map owned only by this ecgdata
+			*/
+			leadmap& mutable_leadmap() {
+				if(_leadmap.use_count() > 1) {
+					_leadmap = std::make_shared<leadmap>(*_leadmap);
+				}
+
+				return *_leadmap;
+			}
+
+			/**
+			* @brief Annotations for reading
+			*
+			* @return Pointmap (possibly shared with other copies)
+			*/
+			const pointmap& points() const {
+				return *_spoints;
+			}
+
+			/**
+			* @brief Annotations for writing, deep copied first if they are shared (copy-on-write)
+			*
+			* @return Pointmap owned only by this ecgdata
+			*/
+			pointmap& mutable_points() {
+				if(_spoints.use_count() > 1) {
+					_spoints = std::make_shared<pointmap>(*_spoints);
+				}
+
+				return *_spoints;
+			}
+
+			/**
+			* @brief Marks a column without lead name in the column table
+			*/
+			static const int nolead = ecglead::GLOBAL - 1;
+
+			/**
+			* @brief Column of a lead from the lead table
+			*
+			* @param lead Lead to get the column number for
+			*
+			* @return Column number, -1 if the lead is not in the data
+			*/
+			int leadcol(const ecglead lead) const {
+				int id = static_cast<int>(lead.index) - ecglead::GLOBAL;
+
+				if(id < 0 || id >= nleadids) {
+					return -1;
+				}
+
+				return _leadcol[id];
+			}
+
+			/**
+			* @brief Rebuilds the lead and column tables from the lead map, must be called whenever the lead map changes
+			*/
+			void reindex() {
+				_leadcol.fill(-1);
+				_collead.assign(_nleads, nolead);
+
+				for(leadmap::left_const_iterator lit = _leadmap->left.begin(); lit != _leadmap->left.end(); ++lit) {
+					int id = static_cast<int>(lit->second.index) - ecglead::GLOBAL;
+
+					if(lit->first < 0 || id < 0 || id >= nleadids) {
+						continue;
+					}
+					if(lit->first >= static_cast<int>(_collead.size())) {
+						_collead.resize(lit->first+1, nolead);
+					}
+
+					_leadcol[id] = lit->first;
+					_collead[lit->first] = lit->second.index;
+				}
+			}
 
 		// Attributes
 		protected:
 			/**
-			* @brief Data, stored as samples x leadsc
+			* @brief Data, stored as samples x leadsc with aligned and padded leads (see allocate()). Shared between copies and sub parts, see mutable_samples()
 			*/
-			Mat<T> _data;
+			std::shared_ptr<Mat<T> > _sdata;
 
 			/**
 			* @brief Number of samples
@@ -1071,9 +1930,70 @@ namespace ecglib {
 			std::size_t _nsamples;
 
 			/**
-			* @brief Lead map, maps column numbers with known lead names
+			* @brief First row of the samples in _sdata (sub parts by time)
+			*/
+			std::size_t _rowoffset;
+
+			/**
+			* @brief Column in _sdata of each column (sub parts by lead), empty if the columns are the same
+			*/
+			std::vector<uword> _cols;
+
+			/**
+			* @brief Virtual lead computed from stored leads, see virtualize()
 			*/
-			leadmap _leadmap;
+			struct derivedlead {
+				uword src[3];		/**< @brief columns in _sdata of the source leads */
+				double w[2];		/**< @brief weights of src[0] and src[1] of a linear lead */
+				bool magnitude;		/**< @brief the lead is the magnitude of src[0..2] instead */
+			};
+
+			/**
+			* @brief Virtual leads, column samples().n_cols + k of the storage columns is _virtual[k]
+			*/
+			std::vector<derivedlead> _virtual;
+
+			/**
+			* @brief Copy of the samples laid out for whole-matrix reads, see whole(). Copies of an ecgdata start without it
+			*/
+			struct layoutcopy {
+				std::shared_ptr<const Mat<T> > samples;		/**< @brief samples with the columns in order, nullptr until the first read */
+
+				layoutcopy() {
+				}
+
+				layoutcopy(const layoutcopy&) noexcept {
+				}
+
+				layoutcopy& operator=(const layoutcopy&) noexcept {
+					samples.reset();
+					return *this;
+				}
+
+				void reset() {
+					samples.reset();
+				}
+			};
+
+			/**
+			* @brief Laid out copy of the samples, see whole()
+			*/
+			mutable layoutcopy _layout;
+
+			/**
+			* @brief Lead map, maps column numbers with known lead names. Shared between copies, see mutable_leadmap()
+			*/
+			std::shared_ptr<leadmap> _leadmap;
+
+			/**
+			* @brief Lead table, column number of each lead name (indexed by lead+1, -1 if the lead is not in the data), kept in sync with _leadmap
+			*/
+			leadtable _leadcol;
+
+			/**
+			* @brief Column table, lead name of each column (nolead if the column has no name), kept in sync with _leadmap
+			*/
+			std::vector<int> _collead;
 
 			/**
 			* @brief Sampling frequency
@@ -1091,21 +2011,49 @@ namespace ecglib {
 			std::size_t _nleads;
 
 			/**
-			* @brief Pointmap
+			* @brief Gain of each lead in ADU per uV, empty if all leads use _res
 			*/
-			pointmap _points;
+			std::vector<double> _gain;
 
 			/**
-			* @brief Property map
+			* @brief Baseline of each lead in ADU, empty if all leads have baseline 0
 			*/
-			propertymap _props;
+			std::vector<double> _baseline;
+
+			/**
+			* @brief Pointmap. Shared between copies and sub parts, see mutable_points()
+			*/
+			std::shared_ptr<pointmap> _spoints;
+
+			/**
+			* @brief Samples are read-only external storage (e.g. a shared memory mapping) and are copied on the first write
+			*/
+			bool _readonly;
+
+			/**
+			* @brief Properties
+			*/
+			propertystore _props;
 	};
 
+	template<class T>
+	const int Ecgdata<T>::nolead;
+
 	/**
 	* @brief ECGdata of type double is the currently accepted input for all functions.
 	*/
 	typedef Ecgdata<double> ecgdata;
 
+	/**
+	* @brief ECGdata of 16-bit ADU samples, use gain/baseline and physical() or to_physical() for uV
+	*/
+	typedef Ecgdata<int16_t> ecgdata16;
+
+	/**
+	* @brief ECGdata of 32-bit ADU samples, use gain/baseline and physical() or to_physical() for uV
+	*/
+	typedef Ecgdata<int32_t> ecgdata32;
+
 	/*!
 	 *@}
 	 */
@@ -0,0 +1,245 @@
+/**
+ * @file core/ecglib/ecgdatabuilder.hpp
+ * @author Lars Johannesen <lars.johannesen@fda.hhs.gov>
+ * @author Jose Vicente <jose.vicenteruiz@fda.hhs.gov>
+ * @author Meisam Hosseini <meisam.hosseini@fda.hhs.gov>
+ * @author Dustin C McAfee <dustin.mcafee@fda.hhs.gov
+ *
+ * @version 1.0.0
+ *
+ * @section LICENSE
+ * ecglib is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as published by the Free Software Foundation, either version 3 of the License (GNU LGPL3), or (at your option) any later version.
+ * ecglib is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ * @section DISCLAIMER
+ * ecglib software and documentation were developed by the authors in their capacities as  Oak Ridge Institute for Science and Education (ORISE) research fellows at the U.S. Food and Drug Administration (FDA). .
+ * FDA assumes no responsibility whatsoever for use by other parties of the Software, its source code, documentation or compiled executables, and makes no guarantees, expressed or implied, about its quality, reliability, or any other characteristic.  Further, FDA makes no representations that the use of the Software will not infringe any patent or proprietary rights of third parties.   The use of this code in no way implies endorsement by the FDA or confers any advantage in regulatory decisions.
+ *
+ * @section DESCRIPTION
+ * Builder for filling an ecgdata lead by lead without reallocating
+ */
+
+#ifndef ECGLIB_CORE_ECGDATABUILDER_LJ_2015_12_09
+#define ECGLIB_CORE_ECGDATABUILDER_LJ_2015_12_09 1
+
+#include <ecglib/ecgdata.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace ecglib {
+	/*! \addtogroup core
+	 * Core ECGlib classes and functions
+	 * @{
+	 */
+
+	/**
+	* @brief Builds an ecgdata from leads that are loaded one by one
+	*
+	* The samples x leads matrix is allocated once. Loaders write each lead into its own column in place
+	* (distinct columns can be written from different threads) and build() hands the matrix over to the ecgdata without copying.
+	* Use this instead of repeated Ecgdata::add_lead, which reallocates the whole matrix for every lead.
+	*
+	* @tparam T Sample type
+	*/
+	template<class T>
+	class EcgdataBuilder {
+		public:
+			/**
+			* @brief Reserves the samples of a record
+			*
+			* @param nsamples Number of samples of every lead
+			* @param maxleads Maximum number of leads
+			* @param fs Sampling frequency
+			* @param res Resolution
+			*/
+			EcgdataBuilder(const std::size_t nsamples, const std::size_t maxleads, const double fs = 0, const double res = 1) : _data(Ecgdata<T>::allocate(nsamples, maxleads)), _nsamples(nsamples), _nleads(0), _names(maxleads, nolead), _gain(maxleads, res), _baseline(maxleads, 0), _fs(fs), _res(res) {
+			}
+
+			/**
+			* @brief Adds a lead (not thread-safe), the samples are written afterwards with copy_lead or begin_lead
+			*
+			* @param lead Lead name
+			*
+			* @return Column number of the lead
+			*/
+			int add_lead(const ecglead lead) {
+				if(_nleads >= _names.size()) {
+					std::cerr << "ecglib::EcgdataBuilder::add_lead: more leads than reserved";
+					throw ecglib::ecglib_exception("ecglib::EcgdataBuilder::add_lead: more leads than reserved");
+				}
+				for(std::size_t i = 0; i < _nleads; ++i) {
+					if(_names[i] == static_cast<int>(lead.index)) {
+						std::cerr << "ecglib::EcgdataBuilder::add_lead:lead is not new";
+						throw ecglib::ecglib_exception("ecglib::EcgdataBuilder::add_lead:lead is not new");
+					}
+				}
+
+				_names[_nleads] = lead.index;
+
+				return static_cast<int>(_nleads++);
+			}
+
+			/**
+			* @brief Copies the samples of a lead into its column (thread-safe for distinct columns)
+			*
+			* @tparam ITER An iterator, must be usable by std::copy
+			* @param col Column number from add_lead
+			* @param start Start of what to copy
+			* @param stop Stop of what to copy
+			*/
+			template<class ITER>
+			void copy_lead(const int col, ITER start, ITER stop) {
+				if(static_cast<std::size_t>(stop - start) != _nsamples) {
+					std::cerr << "ecglib::EcgdataBuilder::copy_lead: _nsamples != length";
+					throw ecglib::ecglib_exception("ecglib::EcgdataBuilder::copy_lead: _nsamples != length");
+				}
+
+				std::copy(start, stop, begin_lead(col));
+			}
+
+			/**
+			* @brief Start of the column of a lead for writing in place (thread-safe for distinct columns)
+			*
+			* The column starts on a SAMPLE_ALIGNMENT boundary and distinct columns do not share cache lines.
+			*
+			* @param col Column number from add_lead
+			*
+			* @return Pointer to the first of nsamples samples
+			*/
+			T* begin_lead(const int col) {
+				if(col < 0 || static_cast<std::size_t>(col) >= _nleads || !_data) {
+					std::cerr << "ecglib::EcgdataBuilder::begin_lead: no such column";
+					throw ecglib::ecglib_exception("ecglib::EcgdataBuilder::begin_lead: no such column");
+				}
+
+				return _data->colptr(col);
+			}
+
+			/**
+			* @brief Set gain of a lead
+			*
+			* @param col Column number
+			* @param g ADU per uV
+			*/
+			void gain(const int col, const double g) {
+				_gain.at(col) = g;
+			}
+
+			/**
+			* @brief Set baseline of a lead
+			*
+			* @param col Column number
+			* @param b ADU of 0 uV
+			*/
+			void baseline(const int col, const double b) {
+				_baseline.at(col) = b;
+			}
+
+			/**
+			* @brief Get number of leads added so far
+			*
+			* @return Nleads
+			*/
+			std::size_t nleads() const {
+				return _nleads;
+			}
+
+			/**
+			* @brief Finalizes the ecgdata, the builder is empty afterwards
+			*
+			* The samples are handed over without copying. Unused reserved leads are removed (this copies the used leads once).
+			*
+			* @return Ecgdata with the added leads
+			*/
+			Ecgdata<T> build() {
+				if(!_data) {
+					std::cerr << "ecglib::EcgdataBuilder::build: already built";
+					throw ecglib::ecglib_exception("ecglib::EcgdataBuilder::build: already built");
+				}
+
+				if(_nleads < _data->n_cols) {
+					std::shared_ptr<Mat<T> > d = Ecgdata<T>::allocate(_nsamples, _nleads);
+					for(std::size_t i = 0; i < _nleads; ++i) {
+						std::copy(_data->begin_col(i), _data->begin_col(i) + _nsamples, d->begin_col(i));
+					}
+					_data = d;
+				}
+
+				typename Ecgdata<T>::leadmap lm;
+				for(std::size_t i = 0; i < _nleads; ++i) {
+					lm.insert(typename Ecgdata<T>::leadmap::value_type(i, ecglead(_names[i])));
+				}
+
+				Ecgdata<T> e(std::move(_data), _nsamples, lm, _fs, _res, false);
+				_data.reset();
+
+				for(std::size_t i = 0; i < _nleads; ++i) {
+					if(_gain[i] != _res) {
+						e.gain(i, _gain[i]);
+					}
+					if(_baseline[i] != 0) {
+						e.baseline(i, _baseline[i]);
+					}
+				}
+
+				return e;
+			}
+
+		private:
+			/**
+			* @brief Marks a reserved column without lead
+			*/
+			static const int nolead = ecglead::GLOBAL - 1;
+
+			/**
+			* @brief Samples x reserved leads
+			*/
+			std::shared_ptr<Mat<T> > _data;
+
+			/**
+			* @brief Number of samples
+			*/
+			std::size_t _nsamples;
+
+			/**
+			* @brief Number of leads added
+			*/
+			std::size_t _nleads;
+
+			/**
+			* @brief Lead name of each column
+			*/
+			std::vector<int> _names;
+
+			/**
+			* @brief Gain of each column
+			*/
+			std::vector<double> _gain;
+
+			/**
+			* @brief Baseline of each column
+			*/
+			std::vector<double> _baseline;
+
+			/**
+			* @brief Sampling frequency
+			*/
+			double _fs;
+
+			/**
+			* @brief Resolution
+			*/
+			double _res;
+	};
+
+	template<class T>
+	const int EcgdataBuilder<T>::nolead;
+
+	/*!
+	 *@}
+	 */
+}
+
+#endif
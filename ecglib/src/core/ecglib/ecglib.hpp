@@ -56,6 +56,11 @@ namespace ecglib {
 	*/
 	const int GLOBAL_LEAD=-1;
 
+	/**
+	* @brief Alignment in bytes of the first sample of every lead allocated by ecgdata (one cache line, a multiple of any SIMD register)
+	*/
+	const std::size_t SAMPLE_ALIGNMENT=64;
+
 	typedef int leadnumber;						/**< @brief lead number */
 
 	/**
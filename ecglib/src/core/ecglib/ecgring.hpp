@@ -0,0 +1,414 @@
+/**
+ * @file core/ecglib/ecgdatabuilder.hpp
+ * @author Lars Johannesen <lars.johannesen@fda.hhs.gov>
+ * @author Jose Vicente <jose.vicenteruiz@fda.hhs.gov>
+ * @author Meisam Hosseini <meisam.hosseini@fda.hhs.gov>
+ * @author Dustin C McAfee <dustin.mcafee@fda.hhs.gov
+ *
+ * @version 1.0.0
+ *
+ * @section LICENSE
+ * ecglib is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as published by the Free Software Foundation, either version 3 of the License (GNU LGPL3), or (at your option) any later version.
+ * ecglib is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ * @section DISCLAIMER
+ * ecglib software and documentation were developed by the authors in their capacities as  Oak Ridge Institute for Science and Education (ORISE) research fellows at the U.S. Food and Drug Administration (FDA). .
+ * FDA assumes no responsibility whatsoever for use by other parties of the Software, its source code, documentation or compiled executables, and makes no guarantees, expressed or implied, about its quality, reliability, or any other characteristic.  Further, FDA makes no representations that the use of the Software will not infringe any patent or proprietary rights of third parties.   The use of this code in no way implies endorsement by the FDA or confers any advantage in regulatory decisions.
+ *
+ * @section DESCRIPTION
+ * Fixed capacity ring buffer of the most recent samples of a live recording
+ */
+
+#ifndef ECGLIB_CORE_ECGRING_LJ_2015_12_09
+#define ECGLIB_CORE_ECGRING_LJ_2015_12_09 1
+
+#include <ecglib/ecgdata.hpp>
+#include <ecglib/ecgview.hpp>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace ecglib {
+	/*! \addtogroup core
+	 * Core ECGlib classes and functions
+	 * @{
+	 */
+
+	/**
+	* @brief Sliding window of the last capacity samples of every lead, e.g. for bedside monitoring
+	*
+	* Blocks of samples are appended in O(block) without moving the samples already stored; once the ring is full the oldest samples
+	* are overwritten. The current window is exposed as at most two contiguous views (older part first), so no samples are copied to read it.
+	*
+	* Samples are numbered from the first sample ever appended (64 bit), and times are given in ms since the first sample (64 bit).
+	* Annotations are stored in ms since epoch(), which is advanced on append once the window is more than EPOCH_SPAN ms past it,
+	* so the 32 bit annotation locations never wrap however long the recording runs. Annotations that leave the window are dropped on append.
+	*
+	* @tparam T Sample type
+	*/
+	template<class T>
+	class EcgRing {
+		public:
+		typedef std::pair<EcgView<const T>, EcgView<const T> > window_type;		/**< @brief older and newer part of a window, the newer part is empty if the window does not wrap */
+
+		static const timems EPOCH_SPAN = 1u << 30;					/**< @brief ms the window may move past the epoch before the annotations are rebased (about 12 days) */
+
+		public:
+			/**
+			* @brief Creates an empty ring
+			*
+			* @param capacity Number of samples kept of every lead
+			* @param leadnames Lead names of the columns
+			* @param fs Sampling frequency
+			* @param res Resolution
+			*/
+			EcgRing(const std::size_t capacity, const std::vector<ecglead> &leadnames, const double fs, const double res = 1) : _data(Ecgdata<T>::allocate(capacity, leadnames.size())), _all(_data->memptr(), capacity, leadnames, _data->n_rows, fs, res), _leadnames(leadnames), _capacity(capacity), _count(0), _total(0), _epoch(0) {
+				if(capacity == 0 || fs <= 0) {
+					std::cerr << "ecglib::EcgRing::capacity and fs must be positive";
+					throw ecglib::ecglib_exception("ecglib::EcgRing::capacity and fs must be positive");
+				}
+			}
+
+			EcgRing(const EcgRing &) = delete;			/**< @brief not copyable, windows point into the storage */
+			EcgRing& operator=(const EcgRing &) = delete;		/**< @brief not copyable, windows point into the storage */
+			EcgRing(EcgRing &&) = default;				/**< @brief move constructor, windows stay valid */
+			EcgRing& operator=(EcgRing &&) = default;		/**< @brief move assignment, windows stay valid */
+
+		public:
+			/**
+			* @brief Appends a block of samples of all leads, only the last capacity samples are kept if the block is longer
+			*
+			* @param block Samples x leads in the column order of the ring
+			*/
+			void append(const EcgView<const T> &block) {
+				if(block.nleads() != _all.nleads()) {
+					std::cerr << "ecglib::EcgRing::append: number of leads does not match";
+					throw ecglib::ecglib_exception("ecglib::EcgRing::append: number of leads does not match");
+				}
+
+				std::size_t n = block.nsamples();
+				std::size_t skip = n > _capacity ? n - _capacity : 0;
+				std::size_t m = n - skip;
+				std::size_t head = static_cast<std::size_t>((_total + skip) % _capacity);
+				std::size_t first = std::min(m, _capacity - head);
+
+				for(std::size_t i = 0; i < _all.nleads(); ++i) {
+					const T *src = block.begin_lead(static_cast<int>(i)) + skip;
+					T *dst = _data->colptr(i);
+
+					std::copy(src, src + first, dst + head);
+					std::copy(src + first, src + m, dst);
+				}
+
+				_count = std::min(_count + n, _capacity);
+				_total += n;
+
+				if(first_time() - _epoch > EPOCH_SPAN) {
+					advance();
+				} else {
+					prune();
+				}
+			}
+
+			/**
+			* @brief Appends a block of samples of all leads
+			*
+			* @param block Samples x leads in the column order of the ring
+			*/
+			void append(const Mat<T> &block) {
+				append(EcgView<const T>(block.memptr(), block.n_rows, block.n_cols, block.n_rows));
+			}
+
+			/**
+			* @brief Adds an annotation located in ms since epoch(), annotations before the window are ignored
+			*
+			* @param lead Lead of the annotation (GLOBAL_LEAD or lead name)
+			* @param ann Annotation
+			*/
+			void annotate(const leadnumber lead, const annotation &ann) {
+				if(ann.location() >= first_time() - _epoch) {
+					_points[lead][ann.location()] = ann;
+				}
+			}
+
+			/**
+			* @brief Adds an annotation at a time in ms since the first sample, annotations before the window are ignored
+			*
+			* @param lead Lead of the annotation (GLOBAL_LEAD or lead name)
+			* @param time Time in ms since the first sample
+			* @param ann Annotation, its location is replaced
+			*/
+			void annotate(const leadnumber lead, const std::uint64_t time, annotation ann) {
+				if(time < first_time()) {
+					return;
+				}
+
+				if(time - _epoch > std::numeric_limits<timems>::max()) {
+					std::cerr << "ecglib::EcgRing::annotate: time too far after the window";
+					throw ecglib::ecglib_exception("ecglib::EcgRing::annotate: time too far after the window");
+				}
+
+				ann.location(static_cast<timems>(time - _epoch));
+				annotate(lead, ann);
+			}
+
+			/**
+			* @brief Current window, valid until the next append
+			*
+			* @return Views of the older and newer part
+			*/
+			window_type window() const {
+				return range(first_sample(), _total);
+			}
+
+			/**
+			* @brief Part of the current window by time, the equivalent of Ecgdata::subpart(starttime, stoptime) (no copy and no rebasing)
+			*
+			* @param starttime First time in ms since the first sample, clipped to the window
+			* @param stoptime Last time in ms since the first sample, clipped to the window
+			*
+			* @return Views of the older and newer part
+			*/
+			window_type window(const std::uint64_t starttime, const std::uint64_t stoptime) const {
+				std::uint64_t start = static_cast<std::uint64_t>(round((starttime/1000.) * _all.fs()));
+				std::uint64_t stop = static_cast<std::uint64_t>(round((stoptime/1000.) * _all.fs())) + 1;
+
+				return range(std::max(start, first_sample()), std::min(stop, _total));
+			}
+
+			/**
+			* @brief Copies the current window into an ecgdata, annotations are rebased to its first sample
+			*
+			* @return Ecgdata of the window
+			*/
+			Ecgdata<T> snapshot() const {
+				window_type w = window();
+				std::shared_ptr<Mat<T> > d = Ecgdata<T>::allocate(_count, _all.nleads());
+
+				for(std::size_t i = 0; i < _all.nleads(); ++i) {
+					int col = static_cast<int>(i);
+					T *dst = d->colptr(i);
+
+					dst = std::copy(w.first.begin_lead(col), w.first.end_lead(col), dst);
+					if(w.second.nsamples() > 0) {
+						std::copy(w.second.begin_lead(col), w.second.end_lead(col), dst);
+					}
+				}
+
+				typename Ecgdata<T>::leadmap lm;
+				for(std::size_t i = 0; i < _leadnames.size(); ++i) {
+					lm.insert(typename Ecgdata<T>::leadmap::value_type(i, _leadnames[i]));
+				}
+
+				Ecgdata<T> e(std::move(d), _count, lm, _all.fs(), _all.resolution(), false);
+
+				// at most EPOCH_SPAN, and every annotation is at or after it
+				timems offset = static_cast<timems>(first_time() - _epoch);
+				pointmap pm;
+				for(pointmap::const_iterator pmi = _points.begin(); pmi != _points.end(); ++pmi) {
+					annotationset as(pmi->second);
+					as.rebase(static_cast<int>(offset));
+
+					pm[pmi->first] = std::move(as);
+				}
+				e.pointsmap(std::move(pm));
+
+				return e;
+			}
+
+		// Setters / Getters
+		public:
+			/**
+			* @brief Get annotations of the window, in ms since epoch()
+			*
+			* @return annotations
+			*/
+			const pointmap& pointsmap() const {
+				return _points;
+			}
+
+			/**
+			* @brief Get number of samples kept of every lead
+			*
+			* @return Capacity
+			*/
+			std::size_t capacity() const {
+				return _capacity;
+			}
+
+			/**
+			* @brief Get number of samples in the window
+			*
+			* @return Nsamples, at most capacity
+			*/
+			std::size_t nsamples() const {
+				return _count;
+			}
+
+			/**
+			* @brief Get number of leads
+			*
+			* @return Nleads
+			*/
+			std::size_t nleads() const {
+				return _all.nleads();
+			}
+
+			/**
+			* @brief Get sampling frequency
+			*
+			* @return Sampling frequency
+			*/
+			double fs() const {
+				return _all.fs();
+			}
+
+			/**
+			* @brief Get number of the first sample of the window, counted from the first sample appended
+			*
+			* @return Sample number
+			*/
+			std::uint64_t first_sample() const {
+				return _total - _count;
+			}
+
+			/**
+			* @brief Get time of the first sample of the window
+			*
+			* @return ms since the first sample appended
+			*/
+			std::uint64_t first_time() const {
+				return static_cast<std::uint64_t>(std::ceil((first_sample() / _all.fs()) * 1000.));
+			}
+
+			/**
+			* @brief Get time the annotation locations are relative to, at most EPOCH_SPAN ms before first_time()
+			*
+			* @return ms since the first sample appended
+			*/
+			std::uint64_t epoch() const {
+				return _epoch;
+			}
+
+		// Helpers
+		private:
+			/**
+			* @brief Views of samples [start, stop) of the stream, which have to be in the window
+			*
+			* @param start First sample number
+			* @param stop One past the last sample number
+			*
+			* @return Views of the older and newer part
+			*/
+			window_type range(const std::uint64_t start, const std::uint64_t stop) const {
+				if(start >= stop) {
+					return window_type();
+				}
+
+				std::size_t pos = static_cast<std::size_t>(start % _capacity);
+				std::size_t n = static_cast<std::size_t>(stop - start);
+
+				if(pos + n <= _capacity) {
+					return window_type(_all.slice(pos, pos + n - 1), EcgView<const T>());
+				}
+
+				return window_type(_all.slice(pos, _capacity - 1), _all.slice(0, pos + n - _capacity - 1));
+			}
+
+			/**
+			* @brief Drops the annotations before the window
+			*/
+			void prune() {
+				timems first = static_cast<timems>(first_time() - _epoch);
+
+				for(pointmap::iterator pmi = _points.begin(); pmi != _points.end(); ++pmi) {
+					annotationset &as = pmi->second;
+
+					as.erase(as.begin(), as.lower_bound(first));
+				}
+			}
+
+			/**
+			* @brief Moves the epoch to the first sample of the window, dropping the annotations before the window and shifting the rest.
+			* The distance moved may exceed the range of timems after a very long block, so the shift is done in 64 bit
+			*/
+			void advance() {
+				std::uint64_t first = first_time();
+				std::uint64_t d = first - _epoch;
+
+				for(pointmap::iterator pmi = _points.begin(); pmi != _points.end(); ++pmi) {
+					annotationset shifted;
+
+					for(annotationset::const_iterator it = pmi->second.begin(); it != pmi->second.end(); ++it) {
+						if(it->first >= d) {
+							annotation a = it->second;
+							a.location(static_cast<timems>(it->first - d));
+							shifted[a.location()] = a;
+						}
+					}
+
+					pmi->second = std::move(shifted);
+				}
+
+				_epoch = first;
+			}
+
+		// Attributes
+		private:
+			/**
+			* @brief Samples x leads, aligned (see Ecgdata::allocate())
+			*/
+			std::shared_ptr<Mat<T> > _data;
+
+			/**
+			* @brief View of the whole storage, windows are slices of it
+			*/
+			EcgView<T> _all;
+
+			/**
+			* @brief Lead names of the columns
+			*/
+			std::vector<ecglead> _leadnames;
+
+			/**
+			* @brief Number of samples kept
+			*/
+			std::size_t _capacity;
+
+			/**
+			* @brief Number of samples in the window
+			*/
+			std::size_t _count;
+
+			/**
+			* @brief Number of samples appended, sample k is stored in row k % capacity
+			*/
+			std::uint64_t _total;
+
+			/**
+			* @brief ms since the first sample the annotations are relative to
+			*/
+			std::uint64_t _epoch;
+
+			/**
+			* @brief Annotations in ms since _epoch
+			*/
+			pointmap _points;
+	};
+
+	/**
+	* @brief Ring of double samples
+	*/
+	typedef EcgRing<double> ecgring;
+
+	/*!
+	 *@}
+	 */
+}
+
+#endif
@@ -0,0 +1,582 @@
+/**
+ * @file core/ecglib/ecgview.hpp
+ * @author Lars Johannesen <lars.johannesen@fda.hhs.gov>
+ * @author Jose Vicente <jose.vicenteruiz@fda.hhs.gov>
+ * @author Meisam Hosseini <meisam.hosseini@fda.hhs.gov>
+ * @author Dustin C McAfee <dustin.mcafee@fda.hhs.gov
+ *
+ * @version 1.0.0
+ *
+ * @section LICENSE
+ * ecglib is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as published by the Free Software Foundation, either version 3 of the License (GNU LGPL3), or (at your option) any later version.
+ * ecglib is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ * @section DISCLAIMER
+ * ecglib software and documentation were developed by the authors in their capacities as  Oak Ridge Institute for Science and Education (ORISE) research fellows at the U.S. Food and Drug Administration (FDA). .
+ * FDA assumes no responsibility whatsoever for use by other parties of the Software, its source code, documentation or compiled executables, and makes no guarantees, expressed or implied, about its quality, reliability, or any other characteristic.  Further, FDA makes no representations that the use of the Software will not infringe any patent or proprietary rights of third parties.   The use of this code in no way implies endorsement by the FDA or confers any advantage in regulatory decisions.
+ *
+ * @section DESCRIPTION
+ * Non-owning view over ecg samples stored elsewhere (ecgdata, acquisition buffers, mapped files, numpy/R memory)
+ */
+
+#ifndef ECGLIB_CORE_ECGVIEW_LJ_2015_12_09
+#define ECGLIB_CORE_ECGVIEW_LJ_2015_12_09 1
+
+#include <armadillo>
+
+#include <ecglib/ecglib.hpp>
+#include <ecglib/propertystore.hpp>
+
+#include <array>
+#include <memory>
+#include <vector>
+#include <string>
+#include <type_traits>
+#include <cstdint>
+
+namespace ecglib {
+	/*! \addtogroup core
+	 * Core ECGlib classes and functions
+	 * @{
+	 */
+
+	using namespace arma;
+
+	/**
+	* @brief Non-owning view of ecg samples
+	*
+	* Samples are stored column-wise (one column per lead, like armadillo), consecutive samples of a lead are adjacent and
+	* consecutive columns are stride elements apart. A view never allocates or copies samples, the memory has to outlive the view
+	* unless the view keeps its owner alive (see owner()).
+	* Lead names are resolved by a flat lead table (lead+1 -> column).
+	*
+	* @tparam T Sample type, const T for read-only views
+	*/
+	template<class T>
+	class EcgView {
+		public:
+		typedef T* leaditerator;								/**< @brief iterator for the samples of a lead */
+		typedef typename std::remove_const<T>::type value_type;				/**< @brief sample type without const */
+
+		static const int nleadids = ecglead::UNKNOWN2 - ecglead::GLOBAL + 1;		/**< @brief number of lead names (GLOBAL..UNKNOWN2), size of the lead table */
+		typedef std::array<int, nleadids> leadtable;					/**< @brief column of each lead name (indexed by lead+1, -1 if not in the view) */
+
+		// Constructors
+		public:
+			/**
+			* @brief Creates an empty view
+			*/
+			EcgView() : _ptr(nullptr), _nsamples(0), _nleads(0), _stride(0), _fs(0), _res(1), _props(nullptr) {
+				_leadcol.fill(-1);
+			}
+
+			/**
+			* @brief Creates a view over external memory without lead names
+			*
+			* @param ptr First sample of first lead
+			* @param nsamples Number of samples
+			* @param nleads Number of leads (columns)
+			* @param stride Distance between columns in samples (0: nsamples, i.e. contiguous)
+			* @param fs Sampling frequency
+			* @param res Resolution
+			*/
+			EcgView(T *ptr, std::size_t nsamples, std::size_t nleads, std::size_t stride = 0, double fs = 0, double res = 1) : _ptr(ptr), _nsamples(nsamples), _nleads(nleads), _stride(stride == 0 ? nsamples : stride), _fs(fs), _res(res), _props(nullptr) {
+				_leadcol.fill(-1);
+				check();
+			}
+
+			/**
+			* @brief Creates a view over external memory with lead names (first column is first element in leadnames)
+			*
+			* @param ptr First sample of first lead
+			* @param nsamples Number of samples
+			* @param leadnames Lead names of the columns
+			* @param stride Distance between columns in samples (0: nsamples, i.e. contiguous)
+			* @param fs Sampling frequency
+			* @param res Resolution
+			*/
+			EcgView(T *ptr, std::size_t nsamples, const std::vector<ecglead> &leadnames, std::size_t stride = 0, double fs = 0, double res = 1) : _ptr(ptr), _nsamples(nsamples), _nleads(leadnames.size()), _stride(stride == 0 ? nsamples : stride), _fs(fs), _res(res), _props(nullptr) {
+				_leadcol.fill(-1);
+				check();
+
+				for(std::size_t i = 0; i < leadnames.size(); ++i) {
+					int id = leadid(leadnames[i]);
+					if(id == -1) {
+						std::cerr << "ecglib::EcgView::Unknown lead name";
+						throw ecglib::ecglib_exception("ecglib::EcgView::Unknown lead name");
+					}
+					_leadcol[id] = i;
+				}
+			}
+
+			/**
+			* @brief Creates a view with a prepared lead table (used by ecgdata and slicing)
+			*
+			* @param ptr First sample of first lead
+			* @param nsamples Number of samples
+			* @param nleads Number of leads (columns)
+			* @param stride Distance between columns in samples
+			* @param leadcol Lead table
+			* @param fs Sampling frequency
+			* @param res Resolution
+			* @param props Properties of the record (not owned, can be nullptr)
+			*/
+			EcgView(T *ptr, std::size_t nsamples, std::size_t nleads, std::size_t stride, const leadtable &leadcol, double fs, double res, const propertystore *props) : _ptr(ptr), _nsamples(nsamples), _nleads(nleads), _stride(stride), _leadcol(leadcol), _fs(fs), _res(res), _props(props) {
+				check();
+			}
+
+			/**
+			* @brief Converts a writable view into a read-only view
+			*
+			* @param other Writable view
+			*/
+			template<class U, class = typename std::enable_if<std::is_same<const U, T>::value && !std::is_same<U, T>::value>::type>
+			EcgView(const EcgView<U> &other) : _ptr(other.memptr()), _nsamples(other.nsamples()), _nleads(other.nleads()), _stride(other.stride()), _leadcol(other.leadcols()), _fs(other.fs()), _res(other.resolution()), _props(other.properties()), _owner(other.owner()) {
+			}
+
+		// Public methods
+		public:
+			/**
+			* @brief Determines if a lead is in the view
+			*
+			* @param lead Lead
+			*
+			* @return True if the lead has a column
+			*/
+			bool hasleadnum(const ecglead lead) const {
+				int id = leadid(lead);
+				return id != -1 && _leadcol[id] != -1;
+			}
+
+			/**
+			* @brief Gets the column number of the lead. Throws an exception if the lead is not in the view
+			*
+			* @param lead Lead to get the column number for
+			*
+			* @return Column number
+			*/
+			int leadnum(const ecglead lead) const {
+				if(!hasleadnum(lead)) {
+					std::cerr << "No such lead";
+					throw ecglib::ecglib_exception("No such lead");
+				}
+
+				return _leadcol[leadid(lead)];
+			}
+
+			/**
+			* @brief View of a range of samples, [start, stop], all leads
+			*
+			* @param start First sample
+			* @param stop Last sample (inclusive)
+			*
+			* @return View of the range
+			*/
+			EcgView<T> slice(const std::size_t start, const std::size_t stop) const {
+				if(start > stop || stop >= _nsamples) {
+					std::string line = std::string("Start_or_stop_incorrect");
+					std::cerr << line;
+					throw ecglib::ecglib_exception(line);
+				}
+
+				EcgView<T> v(_ptr + start, stop - start + 1, _nleads, _stride, _leadcol, _fs, _res, _props);
+				v._owner = _owner;
+
+				return v;
+			}
+
+			/**
+			* @brief View restricted to some leads (other leads are hidden from the lead table, no samples are moved)
+			*
+			* @param leads Leads to keep
+			*
+			* @return View of the leads
+			*/
+			EcgView<T> select(const std::vector<ecglead> &leads) const {
+				leadtable lt;
+				lt.fill(-1);
+
+				for(std::size_t i = 0; i < leads.size(); ++i) {
+					int col = leadnum(leads[i]);
+					lt[leadid(leads[i])] = col;
+				}
+
+				EcgView<T> v(_ptr, _nsamples, _nleads, _stride, lt, _fs, _res, _props);
+				v._owner = _owner;
+
+				return v;
+			}
+
+		// Container methods
+		public:
+			/**
+			* @brief Get sample by lead,sample
+			*
+			* @param lead lead
+			* @param sample Sample number
+			*
+			* @return sample reference
+			*/
+			T& operator()(const ecglead &lead, const std::size_t sample) const {
+				return _ptr[leadnum(lead)*_stride + sample];
+			}
+
+			/**
+			* @brief Get sample by column,sample (no checks)
+			*
+			* @param col Column number
+			* @param sample Sample number
+			*
+			* @return sample reference
+			*/
+			T& at(const std::size_t col, const std::size_t sample) const {
+				return _ptr[col*_stride + sample];
+			}
+
+			/**
+			* @brief Start of a lead
+			*
+			* @param lead Lead
+			*
+			* @return Pointer to first sample of lead
+			*/
+			leaditerator begin_lead(const ecglead &lead) const {
+				return _ptr + leadnum(lead)*_stride;
+			}
+
+			/**
+			* @brief End of a lead
+			*
+			* @param lead Lead
+			*
+			* @return Pointer past the last sample of lead
+			*/
+			leaditerator end_lead(const ecglead &lead) const {
+				return begin_lead(lead) + _nsamples;
+			}
+
+			/**
+			* @brief Start of a column
+			*
+			* @param num Column number
+			*
+			* @return Pointer to first sample of column
+			*/
+			leaditerator begin_lead(const int num) const {
+				return _ptr + num*_stride;
+			}
+
+			/**
+			* @brief End of a column
+			*
+			* @param num Column number
+			*
+			* @return Pointer past the last sample of column
+			*/
+			leaditerator end_lead(const int num) const {
+				return begin_lead(num) + _nsamples;
+			}
+
+			/**
+			* @brief Lead as an armadillo vector using the memory of the view (no copy)
+			*
+			* The vector must not be resized and must not outlive the memory of the view
+			*
+			* @param lead Lead
+			*
+			* @return Column vector over the samples of the lead
+			*/
+			const Col<value_type> lead(const ecglead lead) const {
+				return this->lead(leadnum(lead));
+			}
+
+			/**
+			* @brief Column as an armadillo vector using the memory of the view (no copy)
+			*
+			* @param num Column number
+			*
+			* @return Column vector over the samples of the column
+			*/
+			const Col<value_type> lead(const int num) const {
+				return Col<value_type>(const_cast<value_type*>(begin_lead(num)), _nsamples, false, true);
+			}
+
+			/**
+			* @brief Part of a lead as an armadillo vector using the memory of the view (no copy)
+			*
+			* @param lead Lead
+			* @param start First sample
+			* @param stop Last sample (inclusive)
+			*
+			* @return Column vector over the samples [start, stop] of the lead
+			*/
+			const Col<value_type> lead(const ecglead lead, const int start, const int stop) const {
+				return this->lead(leadnum(lead), start, stop);
+			}
+
+			/**
+			* @brief Part of a column as an armadillo vector using the memory of the view (no copy)
+			*
+			* @param num Column number
+			* @param start First sample
+			* @param stop Last sample (inclusive)
+			*
+			* @return Column vector over the samples [start, stop] of the column
+			*/
+			const Col<value_type> lead(const int num, const int start, const int stop) const {
+				if(start < 0 || start > stop || stop >= static_cast<int>(_nsamples)) {
+					std::string line = std::string("Start_or_stop_incorrect");
+					std::cerr << line;
+					throw ecglib::ecglib_exception(line);
+				}
+
+				return Col<value_type>(const_cast<value_type*>(begin_lead(num)) + start, stop - start + 1, false, true);
+			}
+
+		// Setters / Getters
+		public:
+			/**
+			* @brief Get first sample of first column
+			*
+			* @return Pointer to the samples
+			*/
+			T* memptr() const {
+				return _ptr;
+			}
+
+			/**
+			* @brief Get number of samples
+			*
+			* @return Nsamples
+			*/
+			std::size_t nsamples() const {
+				return _nsamples;
+			}
+
+			/**
+			* @brief Get number of leads (columns)
+			*
+			* @return Nleads
+			*/
+			std::size_t nleads() const {
+				return _nleads;
+			}
+
+			/**
+			* @brief Get distance between columns
+			*
+			* @return Stride in samples
+			*/
+			std::size_t stride() const {
+				return _stride;
+			}
+
+			/**
+			* @brief Determine if every lead starts on a SAMPLE_ALIGNMENT boundary (always true for views of an ecgdata that owns its samples)
+			*
+			* Views of a whole ecgdata can also read the zero padding between nsamples and stride of each lead.
+			*
+			* @return True if aligned loads can be used on all leads
+			*/
+			bool aligned() const {
+				return reinterpret_cast<std::uintptr_t>(_ptr) % SAMPLE_ALIGNMENT == 0 && (_nleads < 2 || (_stride * sizeof(T)) % SAMPLE_ALIGNMENT == 0);
+			}
+
+			/**
+			* @brief Get the lead table
+			*
+			* @return Lead table
+			*/
+			const leadtable& leadcols() const {
+				return _leadcol;
+			}
+
+			/**
+			* @brief Get sampling frequency
+			*
+			* @return Sampling frequency
+			*/
+			double fs() const {
+				return _fs;
+			}
+
+			/**
+			* @brief Get resolution
+			*
+			* @return Resolution how many units per uV, i.e. if data is in uV it is 1
+			*/
+			double resolution() const {
+				return _res;
+			}
+
+			/**
+			* @brief Get properties of the record
+			*
+			* @return Property store or nullptr
+			*/
+			const propertystore* properties() const {
+				return _props;
+			}
+
+			/**
+			* @brief Set properties of the record (not owned)
+			*
+			* @param props Property store, must outlive the view
+			*/
+			void properties(const propertystore *props) {
+				_props = props;
+			}
+
+			/**
+			* @brief Get the owner of the samples that the view keeps alive
+			*
+			* @return Owner, nullptr if the memory is external
+			*/
+			const std::shared_ptr<const void>& owner() const {
+				return _owner;
+			}
+
+			/**
+			* @brief Keeps the owner of the samples alive as long as the view or a view derived from it (slice(), select()) exists
+			*
+			* @param owner Owner of the samples
+			*/
+			void owner(std::shared_ptr<const void> owner) {
+				_owner = std::move(owner);
+			}
+
+			/**
+			* @brief Determine if a property is set
+			*
+			* @param prop Property name
+			*
+			* @return True/false
+			*/
+			bool hasproperty(const std::string &prop) const {
+				return _props != nullptr && _props->has(prop);
+			}
+
+			/**
+			* @brief Get a property
+			*
+			* @param prop Property
+			*
+			* @return Value of property
+			*/
+			property getproperty(const std::string &prop) const {
+				if(!hasproperty(prop)) {
+					std::string line = std::string("No such property: ") + prop;
+					std::cerr << line;
+					throw std::logic_error(line);
+				}
+
+				return _props->get(prop);
+			}
+
+			/**
+			* @brief Get a property value of a type without copying it
+			*
+			* @tparam V std::string, double, int or unsigned int
+			* @param key Key
+			*
+			* @return Pointer to the value, nullptr if not set or of another type
+			*/
+			template<class V>
+			const V* findproperty(const propertykey &key) const {
+				return _props == nullptr ? nullptr : _props->find<V>(key);
+			}
+
+		// Helpers
+		private:
+			/**
+			* @brief Index of a lead in the lead table
+			*
+			* @param lead Lead
+			*
+			* @return Index or -1 if the lead is out of range
+			*/
+			static int leadid(const ecglead lead) {
+				int id = static_cast<int>(lead.index) - ecglead::GLOBAL;
+
+				return (id < 0 || id >= nleadids) ? -1 : id;
+			}
+
+			/**
+			* @brief Checks the geometry of the view
+			*/
+			void check() const {
+				if(_nleads > 1 && _stride < _nsamples) {
+					std::cerr << "ecglib::EcgView::stride is smaller than number of samples";
+					throw ecglib::ecglib_exception("ecglib::EcgView::stride is smaller than number of samples");
+				}
+				if(_ptr == nullptr && _nsamples*_nleads > 0) {
+					std::cerr << "ecglib::EcgView::no memory";
+					throw ecglib::ecglib_exception("ecglib::EcgView::no memory");
+				}
+			}
+
+		// Attributes
+		protected:
+			/**
+			* @brief First sample of first column
+			*/
+			T *_ptr;
+
+			/**
+			* @brief Number of samples
+			*/
+			std::size_t _nsamples;
+
+			/**
+			* @brief Number of leads (columns)
+			*/
+			std::size_t _nleads;
+
+			/**
+			* @brief Distance between columns in samples
+			*/
+			std::size_t _stride;
+
+			/**
+			* @brief Lead table
+			*/
+			leadtable _leadcol;
+
+			/**
+			* @brief Sampling frequency
+			*/
+			double _fs;
+
+			/**
+			* @brief Resolution
+			*/
+			double _res;
+
+			/**
+			* @brief Properties of the record (not owned)
+			*/
+			const propertystore *_props;
+
+			/**
+			* @brief Owner of the samples, nullptr for external memory
+			*/
+			std::shared_ptr<const void> _owner;
+	};
+
+	/**
+	* @brief Writable view of double samples
+	*/
+	typedef EcgView<double> ecgview;
+
+	/**
+	* @brief Read-only view of double samples, accepted by delineators
+	*/
+	typedef EcgView<const double> const_ecgview;
+
+	/*!
+	 *@}
+	 */
+}
+
+#endif
@@ -0,0 +1,462 @@
+/**
+ * @file core/ecglib/mapped.cpp
+ * @author Lars Johannesen <lars.johannesen@fda.hhs.gov>
+ * @author Jose Vicente <jose.vicenteruiz@fda.hhs.gov>
+ * @author Meisam Hosseini <meisam.hosseini@fda.hhs.gov>
+ * @author Dustin C McAfee <dustin.mcafee@fda.hhs.gov
+ *
+ * @version 1.0.0
+ *
+ * @section LICENSE
+ * ecglib is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as published by the Free Software Foundation, either version 3 of the License (GNU LGPL3), or (at your option) any later version.
+ * ecglib is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ * @section DISCLAIMER
+ * ecglib software and documentation were developed by the authors in their capacities as  Oak Ridge Institute for Science and Education (ORISE) research fellows at the U.S. Food and Drug Administration (FDA). .
+ * FDA assumes no responsibility whatsoever for use by other parties of the Software, its source code, documentation or compiled executables, and makes no guarantees, expressed or implied, about its quality, reliability, or any other characteristic.  Further, FDA makes no representations that the use of the Software will not infringe any patent or proprietary rights of third parties.   The use of this code in no way implies endorsement by the FDA or confers any advantage in regulatory decisions.
+ *
+ * @section DESCRIPTION
+ * Memory mapped sample files and snapshots
+ */
+
+#include <ecglib/mapped.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define ECGLIB_HAS_MMAP 1
+#endif
+
+namespace ecglib {
+	namespace {
+		const char mappedmagic[8] = {'E','C','G','L','M','A','P','1'};
+		const char snapshotmagic[8] = {'E','C','G','L','S','N','A','P'};
+
+		// sample type code of the file header
+		template<class T> std::uint32_t sampletype();
+		template<> std::uint32_t sampletype<double>() { return 1; }
+		template<> std::uint32_t sampletype<int16_t>() { return 2; }
+		template<> std::uint32_t sampletype<int32_t>() { return 3; }
+
+		std::uint64_t roundup(const std::uint64_t n, const std::uint64_t alignment) {
+			return ((n + alignment - 1) / alignment) * alignment;
+		}
+
+		std::uint64_t pagesize() {
+#ifdef ECGLIB_HAS_MMAP
+			return static_cast<std::uint64_t>(sysconf(_SC_PAGESIZE));
+#else
+			return 4096;
+#endif
+		}
+
+		// true if count records of size bytes starting at offset lie within length bytes, without overflowing
+		bool fits(const std::uint64_t offset, const std::uint64_t count, const std::uint64_t size, const std::uint64_t length) {
+			return offset <= length && (count == 0 || size <= (length - offset) / count);
+		}
+
+		void mappederror(const std::string &line) {
+			std::cerr << line;
+			throw ecglib::ecglib_exception(line);
+		}
+
+#ifdef ECGLIB_HAS_MMAP
+		int advicecode(const mapadvice advice) {
+			switch(advice) {
+				case mapadvice::SEQUENTIAL: return MADV_SEQUENTIAL;
+				case mapadvice::RANDOM: return MADV_RANDOM;
+				case mapadvice::WILLNEED: return MADV_WILLNEED;
+				case mapadvice::DONTNEED: return MADV_DONTNEED;
+				default: return MADV_NORMAL;
+			}
+		}
+
+		// releases the mapping together with the matrix wrapping it
+		template<class T>
+		struct unmapper {
+			void *base;
+			std::size_t length;
+
+			void operator()(Mat<T> *m) const {
+				delete m;
+				munmap(base, length);
+			}
+		};
+#endif
+
+		// lead records (lead name, gain, baseline) of the columns of an ecgdata
+		template<class T>
+		std::vector<mappedlead> leadrecords(const Ecgdata<T> &e, const std::size_t nleads) {
+			std::vector<mappedlead> leads(nleads);
+			for(std::size_t i = 0; i < leads.size(); ++i) {
+				leads[i].lead = -2;
+				leads[i].reserved = 0;
+				leads[i].gain = e.gain(i);
+				leads[i].baseline = e.baseline(i);
+			}
+			const typename Ecgdata<T>::leadmap &lm = e.leadnames();
+			for(auto lit = lm.left.begin(); lit != lm.left.end(); ++lit) {
+				if(lit->first >= 0 && static_cast<std::size_t>(lit->first) < nleads) {
+					leads[lit->first].lead = static_cast<std::int32_t>(lit->second.index);
+				}
+			}
+
+			return leads;
+		}
+
+		// pads the file up to pos and writes the samples, every lead is padded to the stride so that the next one starts on a new page
+		template<class T>
+		void writesamples(std::ostream &out, std::uint64_t pos, const std::uint64_t dataoffset, const EcgView<const T> &v, const std::uint64_t stride, const std::uint32_t alignment) {
+			std::vector<char> padding(alignment, 0);
+			out.write(&padding[0], dataoffset - pos);
+
+			for(std::size_t i = 0; i < v.nleads(); ++i) {
+				out.write(reinterpret_cast<const char*>(v.begin_lead(static_cast<int>(i))), v.nsamples() * sizeof(T));
+				out.write(&padding[0], (stride - v.nsamples()) * sizeof(T));
+			}
+		}
+
+#ifdef ECGLIB_HAS_MMAP
+		// maps a whole file read-only, throws with the name of the caller on failure
+		void* mapfile(const std::string &filename, const std::size_t minlength, std::size_t &length, const std::string &caller) {
+			int fd = open(filename.c_str(), O_RDONLY);
+			if(fd < 0) {
+				mappederror(caller + ": could not open " + filename);
+			}
+
+			struct stat st;
+			if(fstat(fd, &st) != 0 || static_cast<std::uint64_t>(st.st_size) < minlength) {
+				close(fd);
+				mappederror(caller + ": not a mapped sample file " + filename);
+			}
+
+			length = static_cast<std::size_t>(st.st_size);
+			void *base = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+			close(fd); // the mapping keeps the file open
+			if(base == MAP_FAILED) {
+				mappederror(caller + ": could not map " + filename);
+			}
+
+			return base;
+		}
+
+		// ecgdata over the samples of a mapping, takes over the mapping
+		template<class T>
+		Ecgdata<T> mappeddata(void *base, const std::size_t length, const mappedlead *leads, const std::uint64_t nleads, const std::uint64_t nsamples, const std::uint64_t stride, const std::uint64_t dataoffset, const double fs, const double res) {
+			typename Ecgdata<T>::leadmap lm;
+			for(std::uint64_t i = 0; i < nleads; ++i) {
+				if(leads[i].lead != -2) {
+					lm.insert(typename Ecgdata<T>::leadmap::value_type(i, ecglead(leads[i].lead)));
+				}
+			}
+
+			// the matrix uses the mapped pages directly (the rows beyond nsamples are the padding of the leads)
+			T *samples = reinterpret_cast<T*>(static_cast<char*>(base) + dataoffset);
+			std::shared_ptr<Mat<T> > data(new Mat<T>(samples, stride, nleads, false, true), unmapper<T>{base, length});
+
+			Ecgdata<T> e(std::move(data), nsamples, lm, fs, res, true);
+			for(std::uint64_t i = 0; i < nleads; ++i) {
+				if(leads[i].gain != res) {
+					e.gain(i, leads[i].gain);
+				}
+				if(leads[i].baseline != 0) {
+					e.baseline(i, leads[i].baseline);
+				}
+			}
+
+			return e;
+		}
+#endif
+
+		// appends raw bytes of a value to a buffer
+		template<class V>
+		void putbytes(std::vector<char> &buf, const V &val) {
+			const char *b = reinterpret_cast<const char*>(&val);
+			buf.insert(buf.end(), b, b + sizeof(V));
+		}
+
+		void putstring(std::vector<char> &buf, const std::string &str) {
+			putbytes(buf, static_cast<std::uint32_t>(str.size()));
+			buf.insert(buf.end(), str.begin(), str.end());
+		}
+
+		// reads raw bytes of a value from [pos, stop), false if the buffer is too short
+		template<class V>
+		bool getbytes(const char *&pos, const char *stop, V &val) {
+			if(static_cast<std::size_t>(stop - pos) < sizeof(V)) {
+				return false;
+			}
+			std::memcpy(&val, pos, sizeof(V));
+			pos += sizeof(V);
+			return true;
+		}
+
+		bool getstring(const char *&pos, const char *stop, std::string &str) {
+			std::uint32_t n;
+			if(!getbytes(pos, stop, n) || static_cast<std::size_t>(stop - pos) < n) {
+				return false;
+			}
+			str.assign(pos, n);
+			pos += n;
+			return true;
+		}
+
+		// property section of a snapshot
+		std::vector<char> writeproperties(const propertystore &props) {
+			std::vector<char> buf;
+			for(auto p : props) {
+				const propertyvalue &val = p.second;
+				putbytes(buf, static_cast<std::uint32_t>(val.which()));
+				putstring(buf, p.first);
+				switch(static_cast<Type>(val.which())) {
+					case Type::String: putstring(buf, boost::get<std::string>(val)); break;
+					case Type::Double: putbytes(buf, boost::get<double>(val)); break;
+					case Type::Int: putbytes(buf, static_cast<std::int32_t>(boost::get<int>(val))); break;
+					case Type::Uint: putbytes(buf, static_cast<std::uint32_t>(boost::get<unsigned int>(val))); break;
+				}
+			}
+
+			return buf;
+		}
+
+		template<class T>
+		bool readproperties(const char *pos, const char *stop, Ecgdata<T> &e) {
+			while(pos < stop) {
+				std::uint32_t type;
+				std::string name;
+				if(!getbytes(pos, stop, type) || !getstring(pos, stop, name)) {
+					return false;
+				}
+
+				propertyvalue val;
+				bool ok = true;
+				switch(static_cast<Type>(type)) {
+					case Type::String: { std::string v; ok = getstring(pos, stop, v); val = std::move(v); break; }
+					case Type::Double: { double v; ok = getbytes(pos, stop, v); val = v; break; }
+					case Type::Int: { std::int32_t v; ok = getbytes(pos, stop, v); val = static_cast<int>(v); break; }
+					case Type::Uint: { std::uint32_t v; ok = getbytes(pos, stop, v); val = static_cast<unsigned int>(v); break; }
+					default: ok = false;
+				}
+				if(!ok) {
+					return false;
+				}
+
+				e.setproperty(propertykey(name), std::move(val));
+			}
+
+			return true;
+		}
+	}
+
+	template<class T>
+	void write_mapped(const std::string &filename, const Ecgdata<T> &e) {
+		EcgView<const T> v = e.view();
+
+		mappedheader h;
+		std::memset(&h, 0, sizeof(h));
+		std::memcpy(h.magic, mappedmagic, sizeof(h.magic));
+		h.sampletype = sampletype<T>();
+		h.alignment = static_cast<std::uint32_t>(pagesize());
+		h.nsamples = v.nsamples();
+		h.nleads = v.nleads();
+		h.stride = roundup(h.nsamples * sizeof(T), h.alignment) / sizeof(T);
+		h.dataoffset = roundup(sizeof(mappedheader) + h.nleads * sizeof(mappedlead), h.alignment);
+		h.fs = e.fs();
+		h.res = e.resolution();
+
+		std::vector<mappedlead> leads = leadrecords(e, h.nleads);
+
+		std::ofstream out(filename.c_str(), std::ios::binary | std::ios::trunc);
+		if(!out) {
+			mappederror(std::string("ecglib::write_mapped: could not open ") + filename);
+		}
+
+		out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+		if(!leads.empty()) {
+			out.write(reinterpret_cast<const char*>(&leads[0]), leads.size() * sizeof(mappedlead));
+		}
+
+		writesamples(out, sizeof(h) + leads.size() * sizeof(mappedlead), h.dataoffset, v, h.stride, h.alignment);
+
+		if(!out) {
+			mappederror(std::string("ecglib::write_mapped: could not write ") + filename);
+		}
+	}
+
+	template<class T>
+	Ecgdata<T> read_mapped(const std::string &filename, const mapadvice advice) {
+#ifdef ECGLIB_HAS_MMAP
+		std::size_t length;
+		void *base = mapfile(filename, sizeof(mappedheader), length, "ecglib::read_mapped");
+
+		const mappedheader *h = static_cast<const mappedheader*>(base);
+		const char *bytes = static_cast<const char*>(base);
+		if(std::memcmp(h->magic, mappedmagic, sizeof(mappedmagic)) != 0 || h->sampletype != sampletype<T>() || h->stride < h->nsamples
+				|| !fits(sizeof(mappedheader), h->nleads, sizeof(mappedlead), length) || h->dataoffset < sizeof(mappedheader) + h->nleads * sizeof(mappedlead)
+				|| h->stride > length / sizeof(T) || !fits(h->dataoffset, h->nleads, h->stride * sizeof(T), length)) {
+			munmap(base, length);
+			mappederror(std::string("ecglib::read_mapped: wrong sample type or corrupt file ") + filename);
+		}
+
+		madvise(base, length, advicecode(advice));
+
+		const mappedlead *leads = reinterpret_cast<const mappedlead*>(bytes + sizeof(mappedheader));
+		return mappeddata<T>(base, length, leads, h->nleads, h->nsamples, h->stride, h->dataoffset, h->fs, h->res);
+#else
+		mappederror("ecglib::read_mapped: memory mapped files are not supported on this platform");
+		return Ecgdata<T>();
+#endif
+	}
+
+	template<class T>
+	void write_snapshot(const std::string &filename, const Ecgdata<T> &e) {
+		EcgView<const T> v = e.view();
+
+		std::vector<snapshotannotation> anns;
+		const pointmap &pm = e.pointsmap();
+		anns.reserve(pm.nanns());
+		for(auto pit = pm.begin(); pit != pm.end(); ++pit) {
+			for(auto ait = pit->second.begin(); ait != pit->second.end(); ++ait) {
+				snapshotannotation a;
+				a.key = static_cast<std::int32_t>(pit->first);
+				a.lead = static_cast<std::int32_t>(ait->second.lead());
+				a.location = static_cast<std::uint32_t>(ait->first);
+				a.type = static_cast<std::uint16_t>(ait->second.type().index);
+				a.subtype = static_cast<std::uint16_t>(ait->second.subtype().index);
+				anns.push_back(a);
+			}
+		}
+
+		std::vector<char> props = writeproperties(e.properties());
+
+		snapshotheader h;
+		std::memset(&h, 0, sizeof(h));
+		std::memcpy(h.magic, snapshotmagic, sizeof(h.magic));
+		h.version = SNAPSHOT_VERSION;
+		h.sampletype = sampletype<T>();
+		h.alignment = static_cast<std::uint32_t>(pagesize());
+		h.nsamples = v.nsamples();
+		h.nleads = v.nleads();
+		h.stride = roundup(h.nsamples * sizeof(T), h.alignment) / sizeof(T);
+		h.annoffset = sizeof(snapshotheader) + h.nleads * sizeof(mappedlead);
+		h.nannotations = anns.size();
+		h.propoffset = h.annoffset + h.nannotations * sizeof(snapshotannotation);
+		h.propbytes = props.size();
+		h.dataoffset = roundup(h.propoffset + h.propbytes, h.alignment);
+		h.fs = e.fs();
+		h.res = e.resolution();
+
+		std::vector<mappedlead> leads = leadrecords(e, h.nleads);
+
+		std::ofstream out(filename.c_str(), std::ios::binary | std::ios::trunc);
+		if(!out) {
+			mappederror(std::string("ecglib::write_snapshot: could not open ") + filename);
+		}
+
+		out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+		if(!leads.empty()) {
+			out.write(reinterpret_cast<const char*>(&leads[0]), leads.size() * sizeof(mappedlead));
+		}
+		if(!anns.empty()) {
+			out.write(reinterpret_cast<const char*>(&anns[0]), anns.size() * sizeof(snapshotannotation));
+		}
+		if(!props.empty()) {
+			out.write(&props[0], props.size());
+		}
+
+		writesamples(out, h.propoffset + h.propbytes, h.dataoffset, v, h.stride, h.alignment);
+
+		if(!out) {
+			mappederror(std::string("ecglib::write_snapshot: could not write ") + filename);
+		}
+	}
+
+	template<class T>
+	Ecgdata<T> read_snapshot(const std::string &filename, const mapadvice advice) {
+#ifdef ECGLIB_HAS_MMAP
+		std::size_t length;
+		void *base = mapfile(filename, sizeof(snapshotheader), length, "ecglib::read_snapshot");
+
+		const snapshotheader *h = static_cast<const snapshotheader*>(base);
+		const char *bytes = static_cast<const char*>(base);
+		if(std::memcmp(h->magic, snapshotmagic, sizeof(snapshotmagic)) != 0 || h->version == 0 || h->version > SNAPSHOT_VERSION) {
+			munmap(base, length);
+			mappederror(std::string("ecglib::read_snapshot: not a snapshot or unsupported version ") + filename);
+		}
+		// every region is bounded by the file before the next offset is computed from it, so none of the sums can overflow
+		if(h->sampletype != sampletype<T>() || h->stride < h->nsamples
+				|| !fits(sizeof(snapshotheader), h->nleads, sizeof(mappedlead), length) || h->annoffset < sizeof(snapshotheader) + h->nleads * sizeof(mappedlead)
+				|| !fits(h->annoffset, h->nannotations, sizeof(snapshotannotation), length) || h->propoffset < h->annoffset + h->nannotations * sizeof(snapshotannotation)
+				|| !fits(h->propoffset, h->propbytes, 1, length) || h->dataoffset < h->propoffset + h->propbytes
+				|| h->stride > length / sizeof(T) || !fits(h->dataoffset, h->nleads, h->stride * sizeof(T), length)) {
+			munmap(base, length);
+			mappederror(std::string("ecglib::read_snapshot: wrong sample type or corrupt file ") + filename);
+		}
+
+		// the annotations and properties are read right away, the samples are only paged in when accessed
+		madvise(base, length, advicecode(advice));
+
+		const mappedlead *leads = reinterpret_cast<const mappedlead*>(bytes + sizeof(snapshotheader));
+		Ecgdata<T> e = mappeddata<T>(base, length, leads, h->nleads, h->nsamples, h->stride, h->dataoffset, h->fs, h->res);
+
+		// keys are column numbers or lead names, anything else would make the pointmap allocate a slot for every lead number up to it
+		const std::int64_t maxkey = std::max<std::int64_t>(static_cast<std::int64_t>(h->nleads), ecglead::UNKNOWN2 + 1);
+		pointmap pm;
+		const snapshotannotation *anns = reinterpret_cast<const snapshotannotation*>(bytes + h->annoffset);
+		for(std::uint64_t i = 0; i < h->nannotations; ++i) {
+			if(anns[i].key < GLOBAL_LEAD || anns[i].key >= maxkey) {
+				mappederror(std::string("ecglib::read_snapshot: corrupt annotations in ") + filename);
+			}
+			pm[anns[i].key][anns[i].location] = annotation(anns[i].location, annotation_type(anns[i].type), anns[i].lead, annotation_subtype(anns[i].subtype));
+		}
+		e.pointsmap(std::move(pm));
+
+		if(!readproperties(bytes + h->propoffset, bytes + h->propoffset + h->propbytes, e)) {
+			mappederror(std::string("ecglib::read_snapshot: corrupt properties in ") + filename);
+		}
+
+		return e;
+#else
+		mappederror("ecglib::read_snapshot: memory mapped files are not supported on this platform");
+		return Ecgdata<T>();
+#endif
+	}
+
+	template<class T>
+	void advise_lead(const Ecgdata<T> &e, const int lead, const mapadvice advice) {
+#ifdef ECGLIB_HAS_MMAP
+		if(!e.readonly() || lead < 0 || lead >= static_cast<int>(e.nleads())) {
+			return;
+		}
+
+		// madvise works on whole pages, leads of mapped files start on a page
+		std::uintptr_t start = reinterpret_cast<std::uintptr_t>(&*e.begin_lead(lead));
+		std::uintptr_t page = start & ~(static_cast<std::uintptr_t>(pagesize()) - 1);
+		madvise(reinterpret_cast<void*>(page), (start - page) + e.nsamples() * sizeof(T), advicecode(advice));
+#endif
+	}
+
+	template void write_mapped<double>(const std::string &filename, const Ecgdata<double> &e);
+	template void write_mapped<int16_t>(const std::string &filename, const Ecgdata<int16_t> &e);
+	template void write_mapped<int32_t>(const std::string &filename, const Ecgdata<int32_t> &e);
+	template Ecgdata<double> read_mapped<double>(const std::string &filename, const mapadvice advice);
+	template Ecgdata<int16_t> read_mapped<int16_t>(const std::string &filename, const mapadvice advice);
+	template Ecgdata<int32_t> read_mapped<int32_t>(const std::string &filename, const mapadvice advice);
+	template void advise_lead<double>(const Ecgdata<double> &e, const int lead, const mapadvice advice);
+	template void advise_lead<int16_t>(const Ecgdata<int16_t> &e, const int lead, const mapadvice advice);
+	template void advise_lead<int32_t>(const Ecgdata<int32_t> &e, const int lead, const mapadvice advice);
+	template void write_snapshot<double>(const std::string &filename, const Ecgdata<double> &e);
+	template void write_snapshot<int16_t>(const std::string &filename, const Ecgdata<int16_t> &e);
+	template void write_snapshot<int32_t>(const std::string &filename, const Ecgdata<int32_t> &e);
+	template Ecgdata<double> read_snapshot<double>(const std::string &filename, const mapadvice advice);
+	template Ecgdata<int16_t> read_snapshot<int16_t>(const std::string &filename, const mapadvice advice);
+	template Ecgdata<int32_t> read_snapshot<int32_t>(const std::string &filename, const mapadvice advice);
+}
@@ -0,0 +1,185 @@
+/**
+ * @file core/ecglib/mapped.hpp
+ * @author Lars Johannesen <lars.johannesen@fda.hhs.gov>
+ * @author Jose Vicente <jose.vicenteruiz@fda.hhs.gov>
+ * @author Meisam Hosseini <meisam.hosseini@fda.hhs.gov>
+ * @author Dustin C McAfee <dustin.mcafee@fda.hhs.gov
+ *
+ * @version 1.0.0
+ *
+ * @section LICENSE
+ * ecglib is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as published by the Free Software Foundation, either version 3 of the License (GNU LGPL3), or (at your option) any later version.
+ * ecglib is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ * @section DISCLAIMER
+ * ecglib software and documentation were developed by the authors in their capacities as  Oak Ridge Institute for Science and Education (ORISE) research fellows at the U.S. Food and Drug Administration (FDA). .
+ * FDA assumes no responsibility whatsoever for use by other parties of the Software, its source code, documentation or compiled executables, and makes no guarantees, expressed or implied, about its quality, reliability, or any other characteristic.  Further, FDA makes no representations that the use of the Software will not infringe any patent or proprietary rights of third parties.   The use of this code in no way implies endorsement by the FDA or confers any advantage in regulatory decisions.
+ *
+ * @section DESCRIPTION
+ * Memory mapped sample files and snapshots: ecgdata backed by an on-disk, column-major sample file
+ */
+
+#ifndef ECGLIB_CORE_MAPPED_LJ_2015_12_09
+#define ECGLIB_CORE_MAPPED_LJ_2015_12_09 1
+
+#include <ecglib/ecgdata.hpp>
+
+#include <string>
+#include <cstdint>
+
+namespace ecglib {
+	/*! \addtogroup core
+	 * Core ECGlib classes and functions
+	 * @{
+	 */
+
+	/**
+	* @brief Access pattern hints for mapped samples (madvise)
+	*/
+	enum class mapadvice {NORMAL, SEQUENTIAL, RANDOM, WILLNEED, DONTNEED};
+
+	/**
+	* @brief Header of a mapped sample file
+	*
+	* The file is the header, followed by one lead record (lead name, gain, baseline) per lead, followed by the samples.
+	* Samples are column-major: lead i starts at dataoffset + i*stride*sizeof(T). dataoffset and the byte length of
+	* stride are multiples of alignment (the page size of the writer), so every lead starts on its own page.
+	* All values are in the byte order of the writer.
+	*/
+	struct mappedheader {
+		char magic[8];			/**< @brief "ECGLMAP1" */
+		std::uint32_t sampletype;	/**< @brief 1: double, 2: int16, 3: int32 */
+		std::uint32_t alignment;	/**< @brief alignment of the leads in bytes */
+		std::uint64_t nsamples;		/**< @brief number of samples */
+		std::uint64_t nleads;		/**< @brief number of leads */
+		std::uint64_t stride;		/**< @brief distance between the starts of two leads in samples */
+		std::uint64_t dataoffset;	/**< @brief position of the first sample in bytes */
+		double fs;			/**< @brief sampling frequency */
+		double res;			/**< @brief resolution */
+	};
+
+	/**
+	* @brief Lead record of a mapped sample file
+	*/
+	struct mappedlead {
+		std::int32_t lead;		/**< @brief ecglead of the column, -2 if the column has no lead name */
+		std::int32_t reserved;		/**< @brief padding, 0 */
+		double gain;			/**< @brief ADU per uV */
+		double baseline;		/**< @brief ADU of 0 uV */
+	};
+
+	/**
+	* @brief Header of a snapshot file
+	*
+	* A snapshot is a mapped sample file that also holds the annotations and properties of the ecgdata:
+	* the header, followed by one mappedlead per lead, the annotations (nannotations snapshotannotation records
+	* at annoffset), the properties (propbytes bytes at propoffset) and the samples, laid out as in a mapped sample file.
+	* Each property is stored as its type (uint32, propertyvalue::which()), the length of its name (uint32), the name
+	* and the value (double, int32 or uint32; strings as their length (uint32) followed by the characters).
+	* All values are in the byte order of the writer.
+	*/
+	struct snapshotheader {
+		char magic[8];			/**< @brief "ECGLSNAP" */
+		std::uint32_t version;		/**< @brief format version, see SNAPSHOT_VERSION */
+		std::uint32_t sampletype;	/**< @brief 1: double, 2: int16, 3: int32 */
+		std::uint32_t alignment;	/**< @brief alignment of the leads in bytes */
+		std::uint32_t reserved;		/**< @brief padding, 0 */
+		std::uint64_t nsamples;		/**< @brief number of samples */
+		std::uint64_t nleads;		/**< @brief number of leads */
+		std::uint64_t stride;		/**< @brief distance between the starts of two leads in samples */
+		std::uint64_t dataoffset;	/**< @brief position of the first sample in bytes */
+		std::uint64_t annoffset;	/**< @brief position of the first annotation in bytes */
+		std::uint64_t nannotations;	/**< @brief number of annotations */
+		std::uint64_t propoffset;	/**< @brief position of the properties in bytes */
+		std::uint64_t propbytes;	/**< @brief size of the properties in bytes */
+		double fs;			/**< @brief sampling frequency */
+		double res;			/**< @brief resolution */
+	};
+
+	/**
+	* @brief Annotation record of a snapshot file, sorted by pointmap lead and location
+	*/
+	struct snapshotannotation {
+		std::int32_t key;		/**< @brief lead of the annotationset in the pointmap */
+		std::int32_t lead;		/**< @brief lead of the annotation */
+		std::uint32_t location;		/**< @brief location in ms, the key of the annotation in its annotationset */
+		std::uint16_t type;		/**< @brief annotation_type */
+		std::uint16_t subtype;		/**< @brief annotation_subtype */
+	};
+
+	/**
+	* @brief Snapshot format version written by write_snapshot, read_snapshot rejects newer versions
+	*/
+	const std::uint32_t SNAPSHOT_VERSION = 1;
+
+	/**
+	 * @brief Writes the samples of an ecgdata into a mapped sample file (annotations and properties are not written)
+	 *
+	 * @tparam T Sample type (double, int16_t, int32_t)
+	 * @param filename File name
+	 * @param e Ecgdata
+	 */
+	template<class T>
+	void write_mapped(const std::string &filename, const Ecgdata<T> &e);
+
+	/**
+	 * @brief Maps a sample file into an ecgdata without reading it
+	 *
+	 * The mapping is shared and read-only, so several processes mapping the same file share the same pages.
+	 * Only the pages of the leads/samples that are accessed are read from disk. The first non-const access
+	 * to the samples copies them into memory (see Ecgdata::readonly()). The mapping is released with the last copy of the ecgdata.
+	 *
+	 * @tparam T Sample type, has to match the file
+	 * @param filename File name
+	 * @param advice Access pattern of the whole mapping
+	 *
+	 * @return Ecgdata over the mapping
+	 */
+	template<class T>
+	Ecgdata<T> read_mapped(const std::string &filename, const mapadvice advice = mapadvice::NORMAL);
+
+	/**
+	 * @brief Gives an access pattern hint for the samples of a lead, e.g. SEQUENTIAL before filtering or WILLNEED before a scan.
+	 * Does nothing if the samples are not mapped.
+	 *
+	 * @tparam T Sample type
+	 * @param e Ecgdata from read_mapped
+	 * @param lead Column number
+	 * @param advice Access pattern
+	 */
+	template<class T>
+	void advise_lead(const Ecgdata<T> &e, const int lead, const mapadvice advice);
+
+	/**
+	 * @brief Writes an ecgdata (samples, leads, annotations and properties) into a snapshot file
+	 *
+	 * Used to cache intermediate results (e.g. filtered signals or median beats) between the stages of a pipeline.
+	 *
+	 * @tparam T Sample type (double, int16_t, int32_t)
+	 * @param filename File name
+	 * @param e Ecgdata
+	 */
+	template<class T>
+	void write_snapshot(const std::string &filename, const Ecgdata<T> &e);
+
+	/**
+	 * @brief Loads a snapshot file, the samples are mapped as in read_mapped and used in place without parsing
+	 *
+	 * Only the annotations and properties are read into memory.
+	 *
+	 * @tparam T Sample type, has to match the file
+	 * @param filename File name
+	 * @param advice Access pattern of the whole mapping
+	 *
+	 * @return Ecgdata over the mapping, with the annotations and properties of the snapshot
+	 */
+	template<class T>
+	Ecgdata<T> read_snapshot(const std::string &filename, const mapadvice advice = mapadvice::NORMAL);
+
+	/*!
+	 *@}
+	 */
+}
+
+#endif
@@ -0,0 +1,158 @@
+/**
+ * @file core/ecglib/propertystore.cpp
+ * @author Lars Johannesen <lars.johannesen@fda.hhs.gov>
+ * @author Jose Vicente <jose.vicenteruiz@fda.hhs.gov>
+ * @author Meisam Hosseini <meisam.hosseini@fda.hhs.gov>
+ * @author Dustin C McAfee <dustin.mcafee@fda.hhs.gov
+ *
+ * @version 1.0.0
+ *
+ * @section LICENSE
+ * ecglib is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as published by the Free Software Foundation, either version 3 of the License (GNU LGPL3), or (at your option) any later version.
+ * ecglib is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ * @section DISCLAIMER
+ * ecglib software and documentation were developed by the authors in their capacities as  Oak Ridge Institute for Science and Education (ORISE) research fellows at the U.S. Food and Drug Administration (FDA). .
+ * FDA assumes no responsibility whatsoever for use by other parties of the Software, its source code, documentation or compiled executables, and makes no guarantees, expressed or implied, about its quality, reliability, or any other characteristic.  Further, FDA makes no representations that the use of the Software will not infringe any patent or proprietary rights of third parties.   The use of this code in no way implies endorsement by the FDA or confers any advantage in regulatory decisions.
+ *
+ * @section DESCRIPTION
+ * Property key registry and property conversions
+ */
+#include <ecglib/propertystore.hpp>
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace ecglib {
+	namespace {
+		// names are kept in a deque so references returned by name() stay valid
+		struct keyregistry {
+			std::mutex lock;
+			std::unordered_map<std::string, std::size_t> ids;
+			std::deque<std::string> names;
+		};
+
+		keyregistry& registry() {
+			static keyregistry r;
+
+			return r;
+		}
+
+		struct anyvisitor : boost::static_visitor<boost::any> {
+			template<class V>
+			boost::any operator()(const V &v) const {
+				return boost::any(v);
+			}
+		};
+
+		struct numbervisitor : boost::static_visitor<bool> {
+			explicit numbervisitor(double &out) : value(out) {
+			}
+
+			bool operator()(const std::string &) const {
+				return false;
+			}
+
+			template<class V>
+			bool operator()(const V &v) const {
+				value = static_cast<double>(v);
+				return true;
+			}
+
+			double &value;
+		};
+	}
+
+	std::size_t propertykey::intern(const std::string &name) {
+		keyregistry &r = registry();
+		std::lock_guard<std::mutex> guard(r.lock);
+
+		auto it = r.ids.find(name);
+		if(it != r.ids.end()) {
+			return it->second;
+		}
+
+		r.names.push_back(name);
+		r.ids[name] = r.names.size() - 1;
+
+		return r.names.size() - 1;
+	}
+
+	bool propertykey::find(const std::string &name, std::size_t &id) {
+		keyregistry &r = registry();
+		std::lock_guard<std::mutex> guard(r.lock);
+
+		auto it = r.ids.find(name);
+		if(it == r.ids.end()) {
+			return false;
+		}
+
+		id = it->second;
+
+		return true;
+	}
+
+	const std::string& propertykey::name(const std::size_t id) {
+		keyregistry &r = registry();
+		std::lock_guard<std::mutex> guard(r.lock);
+
+		return r.names.at(id);
+	}
+
+	bool propertystore::number(const propertykey &key, double &value) const {
+		const propertyvalue *v = find(key);
+
+		if(v == nullptr) {
+			return false;
+		}
+
+		if(!boost::apply_visitor(numbervisitor(value), *v)) {
+			std::string line = std::string("ecglib::propertystore::Property is not a number: ") + key.name();
+			std::cerr << line;
+			throw std::logic_error(line);
+		}
+
+		return true;
+	}
+
+	property propertystore::get(const std::string &name) const {
+		std::size_t id;
+
+		if(!propertykey::find(name, id) || id >= _slots.size() || !_slots[id]) {
+			std::string line = std::string("No such property: ") + name;
+			std::cerr << line;
+			throw std::logic_error(line);
+		}
+
+		return toproperty(*_slots[id]);
+	}
+
+	propertymap propertystore::map() const {
+		propertymap pm;
+
+		for(const_iterator it = begin(); it != end(); ++it) {
+			pm.insert(std::pair<std::string, property>((*it).first, toproperty((*it).second)));
+		}
+
+		return pm;
+	}
+
+	propertyvalue propertystore::value(const property &prop) {
+		switch(prop.type) {
+			case Type::String: return boost::any_cast<std::string>(prop.value);
+			case Type::Double: return boost::any_cast<double>(prop.value);
+			case Type::Int: return boost::any_cast<int>(prop.value);
+			case Type::Uint: return boost::any_cast<unsigned int>(prop.value);
+		}
+
+		std::string line = std::string("ecglib::propertystore::Unknown property type");
+		std::cerr << line;
+		throw std::logic_error(line);
+	}
+
+	property propertystore::toproperty(const propertyvalue &val) {
+		return property(static_cast<Type>(val.which()), boost::apply_visitor(anyvisitor(), val));
+	}
+}
@@ -0,0 +1,431 @@
+/**
+ * @file core/ecglib/propertystore.hpp
+ * @author Lars Johannesen <lars.johannesen@fda.hhs.gov>
+ * @author Jose Vicente <jose.vicenteruiz@fda.hhs.gov>
+ * @author Meisam Hosseini <meisam.hosseini@fda.hhs.gov>
+ * @author Dustin C McAfee <dustin.mcafee@fda.hhs.gov
+ *
+ * @version 1.0.0
+ *
+ * @section LICENSE
+ * ecglib is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as published by the Free Software Foundation, either version 3 of the License (GNU LGPL3), or (at your option) any later version.
+ * ecglib is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ * @section DISCLAIMER
+ * ecglib software and documentation were developed by the authors in their capacities as  Oak Ridge Institute for Science and Education (ORISE) research fellows at the U.S. Food and Drug Administration (FDA). .
+ * FDA assumes no responsibility whatsoever for use by other parties of the Software, its source code, documentation or compiled executables, and makes no guarantees, expressed or implied, about its quality, reliability, or any other characteristic.  Further, FDA makes no representations that the use of the Software will not infringe any patent or proprietary rights of third parties.   The use of this code in no way implies endorsement by the FDA or confers any advantage in regulatory decisions.
+ *
+ * @section DESCRIPTION
+ * Property store with interned keys and inline typed values
+ */
+
+#ifndef ECGLIB_CORE_PROPERTYSTORE_LJ_2015_12_09
+#define ECGLIB_CORE_PROPERTYSTORE_LJ_2015_12_09 1
+
+#include <ecglib/ecglib.hpp>
+
+#include <boost/optional.hpp>
+#include <boost/variant.hpp>
+
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ecglib {
+	/*! \addtogroup core
+	 * Core ECGlib classes and functions
+	 * @{
+	 */
+
+	/**
+	* @brief Value of a property, held inline. which() is the ecglib::Type of the value
+	*/
+	typedef boost::variant<std::string, double, int, unsigned int> propertyvalue;
+
+	/**
+	* @brief Property name interned to a small integer id
+	*
+	* Keys are interned once (e.g. as static constants) and then index the slots of a propertystore directly.
+	* The same name always gives the same id within a process.
+	*/
+	class propertykey {
+		public:
+			/**
+			* @brief Interns a property name
+			*
+			* @param name Property name
+			*/
+			explicit propertykey(const std::string &name) : _id(intern(name)) {
+			}
+
+			/**
+			* @brief Get id of the key
+			*
+			* @return Slot id
+			*/
+			std::size_t id() const {
+				return _id;
+			}
+
+			/**
+			* @brief Get name of the key
+			*
+			* @return Property name
+			*/
+			const std::string& name() const {
+				return name(_id);
+			}
+
+			/**
+			* @brief Interns a property name (thread-safe)
+			*
+			* @param name Property name
+			*
+			* @return Id of the name
+			*/
+			static std::size_t intern(const std::string &name);
+
+			/**
+			* @brief Looks up a property name without interning it (thread-safe)
+			*
+			* @param name Property name
+			* @param id (out var) Id of the name
+			*
+			* @return True if the name is interned
+			*/
+			static bool find(const std::string &name, std::size_t &id);
+
+			/**
+			* @brief Name of an id
+			*
+			* @param id Id from intern()
+			*
+			* @return Property name
+			*/
+			static const std::string& name(const std::size_t id);
+
+		private:
+			/**
+			* @brief Slot id
+			*/
+			std::size_t _id;
+	};
+
+	/**
+	* @brief Properties of a record, one inline slot per interned key
+	*
+	* Typed reads by key (find<double>(key)) are an array access without copies, allocations or RTTI.
+	* The name based functions convert from/to ecglib::property for the propertymap interface; descriptions are not stored.
+	*/
+	class propertystore {
+		public:
+			/**
+			* @brief Iterator over the set properties, dereferences to (name, value)
+			*/
+			class const_iterator {
+				public:
+					typedef std::forward_iterator_tag iterator_category;					/**< @brief forward iterator */
+					typedef std::pair<const std::string&, const propertyvalue&> value_type;		/**< @brief name and value */
+					typedef std::ptrdiff_t difference_type;						/**< @brief difference */
+					typedef void pointer;								/**< @brief no pointer, dereference gives a value */
+					typedef value_type reference;							/**< @brief dereference gives a value */
+
+					/**
+					* @brief Iterator at a slot
+					*
+					* @param store Store
+					* @param slot First slot to look at
+					*/
+					const_iterator(const propertystore *store, std::size_t slot) : _store(store), _slot(slot) {
+						skip();
+					}
+
+					/**
+					* @brief Current property
+					*
+					* @return Name and value
+					*/
+					value_type operator*() const {
+						return value_type(propertykey::name(_slot), *_store->_slots[_slot]);
+					}
+
+					/**
+					* @brief Moves to the next set property
+					*
+					* @return This iterator
+					*/
+					const_iterator& operator++() {
+						++_slot;
+						skip();
+
+						return *this;
+					}
+
+					/**
+					* @brief Compares positions
+					*
+					* @param other Other iterator
+					*
+					* @return True if equal
+					*/
+					bool operator==(const const_iterator &other) const {
+						return _slot == other._slot;
+					}
+
+					/**
+					* @brief Compares positions
+					*
+					* @param other Other iterator
+					*
+					* @return True if not equal
+					*/
+					bool operator!=(const const_iterator &other) const {
+						return _slot != other._slot;
+					}
+
+				private:
+					/**
+					* @brief Skips unset slots
+					*/
+					void skip() {
+						while(_slot < _store->_slots.size() && !_store->_slots[_slot]) {
+							++_slot;
+						}
+					}
+
+					const propertystore *_store;	/**< @brief store */
+					std::size_t _slot;		/**< @brief slot */
+			};
+
+		public:
+			/**
+			* @brief Creates an empty store
+			*/
+			propertystore() : _size(0) {
+			}
+
+			/**
+			* @brief Creates a store from a propertymap
+			*
+			* @param props Property map
+			*/
+			explicit propertystore(const propertymap &props) : _size(0) {
+				insert(props);
+			}
+
+		// Typed access
+		public:
+			/**
+			* @brief Determine if a property is set
+			*
+			* @param key Key
+			*
+			* @return True/false
+			*/
+			bool has(const propertykey &key) const {
+				return find(key) != nullptr;
+			}
+
+			/**
+			* @brief Get a property value
+			*
+			* @param key Key
+			*
+			* @return Pointer to the value, nullptr if not set
+			*/
+			const propertyvalue* find(const propertykey &key) const {
+				return (key.id() < _slots.size() && _slots[key.id()]) ? &*_slots[key.id()] : nullptr;
+			}
+
+			/**
+			* @brief Get a property value of a type
+			*
+			* @tparam V std::string, double, int or unsigned int
+			* @param key Key
+			*
+			* @return Pointer to the value, nullptr if not set or of another type
+			*/
+			template<class V>
+			const V* find(const propertykey &key) const {
+				const propertyvalue *v = find(key);
+
+				return v == nullptr ? nullptr : boost::get<V>(v);
+			}
+
+			/**
+			* @brief Get a numeric property as double, whether it is stored as double, int or unsigned int
+			*
+			* @param key Key
+			* @param value (out var) Value of the property
+			*
+			* @return True if the property is set, throws if it is a string
+			*/
+			bool number(const propertykey &key, double &value) const;
+
+			/**
+			* @brief Set a property
+			*
+			* @param key Key
+			* @param value Value
+			*/
+			void set(const propertykey &key, const propertyvalue &value) {
+				if(key.id() >= _slots.size()) {
+					_slots.resize(key.id()+1);
+				}
+				if(!_slots[key.id()]) {
+					++_size;
+				}
+
+				_slots[key.id()] = value;
+			}
+
+			/**
+			* @brief Remove a property
+			*
+			* @param key Key
+			*
+			* @return True if it was set
+			*/
+			bool erase(const propertykey &key) {
+				if(!has(key)) {
+					return false;
+				}
+
+				_slots[key.id()] = boost::none;
+				--_size;
+
+				return true;
+			}
+
+		// Name based access
+		public:
+			/**
+			* @brief Determine if a property is set
+			*
+			* @param name Property name
+			*
+			* @return True/false
+			*/
+			bool has(const std::string &name) const {
+				std::size_t id;
+
+				return propertykey::find(name, id) && id < _slots.size() && _slots[id];
+			}
+
+			/**
+			* @brief Get a property, throws if it is not set
+			*
+			* @param name Property name
+			*
+			* @return Property
+			*/
+			property get(const std::string &name) const;
+
+			/**
+			* @brief Set a property, replaces the value if it is set
+			*
+			* @param name Property name
+			* @param prop Property
+			*/
+			void set(const std::string &name, const property &prop) {
+				set(propertykey(name), value(prop));
+			}
+
+			/**
+			* @brief Set the properties of a map that are not set yet
+			*
+			* @param props Property map
+			*/
+			void insert(const propertymap &props) {
+				for(auto &r : props) {
+					propertykey key(r.first);
+
+					if(!has(key)) {
+						set(key, value(r.second));
+					}
+				}
+			}
+
+			/**
+			* @brief Get all properties as a map
+			*
+			* @return Property map
+			*/
+			propertymap map() const;
+
+		public:
+			/**
+			* @brief Number of set properties
+			*
+			* @return Number of properties
+			*/
+			std::size_t size() const {
+				return _size;
+			}
+
+			/**
+			* @brief Remove all properties
+			*/
+			void clear() {
+				_slots.clear();
+				_size = 0;
+			}
+
+			/**
+			* @brief Beginning of properties
+			*
+			* @return Const iterator to start
+			*/
+			const_iterator begin() const {
+				return const_iterator(this, 0);
+			}
+
+			/**
+			* @brief End of properties
+			*
+			* @return Const iterator to end
+			*/
+			const_iterator end() const {
+				return const_iterator(this, _slots.size());
+			}
+
+			/**
+			* @brief Value of a property
+			*
+			* @param prop Property, the type of the value has to match prop.type
+			*
+			* @return Value
+			*/
+			static propertyvalue value(const property &prop);
+
+			/**
+			* @brief Property of a value
+			*
+			* @param val Value
+			*
+			* @return Property of type val.which()
+			*/
+			static property toproperty(const propertyvalue &val);
+
+		private:
+			/**
+			* @brief Value of each key id, unset if the property is not set
+			*/
+			std::vector<boost::optional<propertyvalue> > _slots;
+
+			/**
+			* @brief Number of set slots
+			*/
+			std::size_t _size;
+	};
+
+	/*!
+	 *@}
+	 */
+}
+
+#endif
@@ -0,0 +1,247 @@
+/**
+ * @file core/ecglib/resample.cpp
+ * @author Lars Johannesen <lars.johannesen@fda.hhs.gov>
+ * @author Jose Vicente <jose.vicenteruiz@fda.hhs.gov>
+ * @author Meisam Hosseini <meisam.hosseini@fda.hhs.gov>
+ * @author Dustin C McAfee <dustin.mcafee@fda.hhs.gov
+ *
+ * @version 1.0.0
+ *
+ * @section LICENSE
+ * ecglib is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as published by the Free Software Foundation, either version 3 of the License (GNU LGPL3), or (at your option) any later version.
+ * ecglib is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ * @section DISCLAIMER
+ * ecglib software and documentation were developed by the authors in their capacities as  Oak Ridge Institute for Science and Education (ORISE) research fellows at the U.S. Food and Drug Administration (FDA). .
+ * FDA assumes no responsibility whatsoever for use by other parties of the Software, its source code, documentation or compiled executables, and makes no guarantees, expressed or implied, about its quality, reliability, or any other characteristic.  Further, FDA makes no representations that the use of the Software will not infringe any patent or proprietary rights of third parties.   The use of this code in no way implies endorsement by the FDA or confers any advantage in regulatory decisions.
+ *
+ * @section DESCRIPTION
+ * Polyphase resampling of ecgdata
+ */
+
+
+#include <ecglib/resample.hpp>
+#include <ecglib/util/util.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+namespace ecglib {
+	namespace {
+		const double kaiserbeta = 5.0;
+		const unsigned int maxfactor = 10000;
+		const double pi = 3.14159265358979323846;
+
+		void resampleerror(const std::string &line) {
+			std::cerr << line;
+			throw ecglib::ecglib_exception(line);
+		}
+
+		unsigned long long gcd(unsigned long long a, unsigned long long b) {
+			while(b != 0) {
+				unsigned long long t = a % b;
+				a = b;
+				b = t;
+			}
+			return a;
+		}
+
+		// modified Bessel function of the first kind, order 0 (power series)
+		double besseli0(const double x) {
+			double sum = 1, term = 1;
+			for(int k = 1; k < 64; ++k) {
+				term *= (x / (2*k)) * (x / (2*k));
+				sum += term;
+				if(term < sum * 1e-17) {
+					break;
+				}
+			}
+			return sum;
+		}
+
+		// inner product with independent partial sums, so that the compiler can keep them in vector registers
+		double dot(const double *a, const double *b, const std::size_t n) {
+			double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+			std::size_t k = 0;
+			for(; k + 4 <= n; k += 4) {
+				s0 += a[k] * b[k];
+				s1 += a[k+1] * b[k+1];
+				s2 += a[k+2] * b[k+2];
+				s3 += a[k+3] * b[k+3];
+			}
+			for(; k < n; ++k) {
+				s0 += a[k] * b[k];
+			}
+			return (s0 + s1) + (s2 + s3);
+		}
+
+		template<class T>
+		typename std::enable_if<std::is_floating_point<T>::value, T>::type tosample(const double v) {
+			return static_cast<T>(v);
+		}
+
+		template<class T>
+		typename std::enable_if<std::is_integral<T>::value, T>::type tosample(const double v) {
+			double r = std::round(v);
+			if(r < std::numeric_limits<T>::min()) {
+				return std::numeric_limits<T>::min();
+			}
+			if(r > std::numeric_limits<T>::max()) {
+				return std::numeric_limits<T>::max();
+			}
+			return static_cast<T>(r);
+		}
+	}
+
+	resampler::resampler(const unsigned int up, const unsigned int down, const unsigned int halfwidth) : _up(up), _down(down) {
+		if(up == 0 || down == 0 || halfwidth == 0) {
+			resampleerror("ecglib::resampler: up, down and halfwidth have to be positive");
+		}
+
+		// lowpass at the lower Nyquist frequency, relative to the Nyquist frequency of the upsampled signal
+		const std::size_t m = std::max(up, down);
+		const double fc = 1.0 / m;
+		const std::size_t length = 2 * halfwidth * m + 1;
+		_center = halfwidth * m;
+		_ntaps = (length + up - 1) / up;
+
+		std::vector<double> h(_ntaps * up, 0);
+		const double norm = besseli0(kaiserbeta);
+		for(std::size_t k = 0; k < length; ++k) {
+			double t = pi * fc * (static_cast<double>(k) - static_cast<double>(_center));
+			double r = 2.0 * k / (length - 1) - 1;
+			h[k] = (t == 0 ? 1 : std::sin(t) / t) * besseli0(kaiserbeta * std::sqrt(std::max(0.0, 1 - r*r))) / norm;
+		}
+
+		// every phase keeps the DC level (baseline) exactly
+		_phases.resize(_ntaps * up);
+		for(std::size_t p = 0; p < up; ++p) {
+			double sum = 0;
+			for(std::size_t r = 0; r < _ntaps; ++r) {
+				sum += h[p + r*up];
+			}
+			for(std::size_t q = 0; q < _ntaps; ++q) {
+				_phases[p*_ntaps + q] = h[p + (_ntaps - 1 - q)*up] / sum;
+			}
+		}
+	}
+
+	std::shared_ptr<const resampler> resampler::get(const unsigned int up, const unsigned int down) {
+		static std::mutex lock;
+		static std::map<std::pair<unsigned int, unsigned int>, std::shared_ptr<const resampler> > kernels;
+
+		std::lock_guard<std::mutex> guard(lock);
+		std::shared_ptr<const resampler> &k = kernels[std::make_pair(up, down)];
+		if(!k) {
+			k = std::make_shared<const resampler>(up, down);
+		}
+
+		return k;
+	}
+
+	std::pair<unsigned int, unsigned int> resampler::ratio(const double fsin, const double fsout) {
+		if(!(fsin > 0) || !(fsout > 0)) {
+			resampleerror("ecglib::resampler::ratio: sampling frequencies have to be positive");
+		}
+
+		unsigned long long a = static_cast<unsigned long long>(std::llround(fsin * 1000));
+		unsigned long long b = static_cast<unsigned long long>(std::llround(fsout * 1000));
+		unsigned long long g = gcd(a, b);
+		if(a / g > maxfactor || b / g > maxfactor) {
+			resampleerror("ecglib::resampler::ratio: no small ratio between the sampling frequencies");
+		}
+
+		return std::make_pair(static_cast<unsigned int>(b / g), static_cast<unsigned int>(a / g));
+	}
+
+	template<class T>
+	void resampler::apply(const T *in, const std::size_t n, T *out) const {
+		if(n == 0) {
+			return;
+		}
+
+		// the input extended at both ends, so that the inner products need no bounds checks
+		const std::size_t lpad = _ntaps, rpad = _center / _up + 2;
+		std::vector<double> x(lpad + n + rpad);
+		std::fill(x.begin(), x.begin() + lpad, static_cast<double>(in[0]));
+		std::copy(in, in + n, x.begin() + lpad);
+		std::fill(x.begin() + lpad + n, x.end(), static_cast<double>(in[n-1]));
+
+		const std::size_t nout = outsamples(n);
+		const double *xs = &x[lpad + 1 - _ntaps];
+		for(std::size_t m = 0; m < nout; ++m) {
+			unsigned long long j = static_cast<unsigned long long>(m) * _down + _center;
+			out[m] = tosample<T>(dot(&_phases[(j % _up) * _ntaps], xs + j / _up, _ntaps));
+		}
+	}
+
+	template<class T>
+	Ecgdata<T> resample(const Ecgdata<T> &e, const double fs, const unsigned int threads) {
+		if(fs == e.fs()) {
+			return e;
+		}
+
+		std::pair<unsigned int, unsigned int> r = resampler::ratio(e.fs(), fs);
+		std::shared_ptr<const resampler> k = resampler::get(r.first, r.second);
+
+		EcgView<const T> v = e.view();
+		const std::size_t nout = k->outsamples(v.nsamples());
+		std::shared_ptr<Mat<T> > data = Ecgdata<T>::allocate(nout, v.nleads());
+
+		// leads are handed out one at a time to the threads
+		std::atomic<std::size_t> next(0);
+		auto work = [&]() {
+			for(std::size_t i = next++; i < v.nleads(); i = next++) {
+				k->apply(&*v.begin_lead(static_cast<int>(i)), v.nsamples(), data->colptr(i));
+			}
+		};
+
+		std::size_t nthreads = threads == 0 ? std::thread::hardware_concurrency() : threads;
+		nthreads = std::max<std::size_t>(1, std::min<std::size_t>(nthreads, v.nleads()));
+		std::vector<std::thread> pool;
+		for(std::size_t t = 1; t < nthreads; ++t) {
+			pool.emplace_back(work);
+		}
+		work();
+		for(auto &t : pool) {
+			t.join();
+		}
+
+		Ecgdata<T> out(std::move(data), nout, e.leadnames(), fs, e.resolution(), false);
+		for(std::size_t i = 0; i < v.nleads(); ++i) {
+			if(e.gain(i) != e.resolution()) {
+				out.gain(i, e.gain(i));
+			}
+			if(e.baseline(i) != 0) {
+				out.baseline(i, e.baseline(i));
+			}
+		}
+		out.setproperties(e.properties());
+
+		const timems last = nout == 0 ? 0 : sample_to_time(static_cast<double>(nout - 1), fs);
+		const pointmap &pm = e.pointsmap();
+		pointmap kept;
+		for(auto pit = pm.begin(); pit != pm.end(); ++pit) {
+			for(auto ait = pit->second.begin(); ait != pit->second.end() && ait->first <= last; ++ait) {
+				kept[pit->first][ait->first] = ait->second;
+			}
+		}
+		out.pointsmap(std::move(kept));
+
+		return out;
+	}
+
+	template void resampler::apply<double>(const double *in, const std::size_t n, double *out) const;
+	template void resampler::apply<int16_t>(const int16_t *in, const std::size_t n, int16_t *out) const;
+	template void resampler::apply<int32_t>(const int32_t *in, const std::size_t n, int32_t *out) const;
+	template Ecgdata<double> resample<double>(const Ecgdata<double> &e, const double fs, const unsigned int threads);
+	template Ecgdata<int16_t> resample<int16_t>(const Ecgdata<int16_t> &e, const double fs, const unsigned int threads);
+	template Ecgdata<int32_t> resample<int32_t>(const Ecgdata<int32_t> &e, const double fs, const unsigned int threads);
+}
@@ -0,0 +1,179 @@
+/**
+ * @file core/ecglib/resample.hpp
+ * @author Lars Johannesen <lars.johannesen@fda.hhs.gov>
+ * @author Jose Vicente <jose.vicenteruiz@fda.hhs.gov>
+ * @author Meisam Hosseini <meisam.hosseini@fda.hhs.gov>
+ * @author Dustin C McAfee <dustin.mcafee@fda.hhs.gov
+ *
+ * @version 1.0.0
+ *
+ * @section LICENSE
+ * ecglib is free software: you can redistribute it and/or modify it under the terms of the GNU Lesser General Public License as published by the Free Software Foundation, either version 3 of the License (GNU LGPL3), or (at your option) any later version.
+ * ecglib is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Lesser General Public License for more details.
+ * You should have received a copy of the GNU Lesser General Public License along with this program.  If not, see http://www.gnu.org/licenses/.
+ *
+ * @section DISCLAIMER
+ * ecglib software and documentation were developed by the authors in their capacities as  Oak Ridge Institute for Science and Education (ORISE) research fellows at the U.S. Food and Drug Administration (FDA). .
+ * FDA assumes no responsibility whatsoever for use by other parties of the Software, its source code, documentation or compiled executables, and makes no guarantees, expressed or implied, about its quality, reliability, or any other characteristic.  Further, FDA makes no representations that the use of the Software will not infringe any patent or proprietary rights of third parties.   The use of this code in no way implies endorsement by the FDA or confers any advantage in regulatory decisions.
+ *
+ * @section DESCRIPTION
+ * Polyphase resampling of ecgdata
+ */
+
+#ifndef ECGLIB_CORE_RESAMPLE_LJ_2015_12_09
+#define ECGLIB_CORE_RESAMPLE_LJ_2015_12_09 1
+
+#include <ecglib/ecgdata.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace ecglib {
+	/*! \addtogroup core
+	 * Core ECGlib classes and functions
+	 * @{
+	 */
+
+	/**
+	* @brief Polyphase FIR resampler for a rational ratio up/down
+	*
+	* The anti-aliasing filter is a Kaiser windowed sinc (beta 5) with halfwidth zero crossings on each side, cut off at
+	* the lower of the two Nyquist frequencies. It is split into up phases, each stored reversed and contiguous, so every
+	* output sample is a single inner product of ntaps() consecutive input samples. The filter is centered (no delay):
+	* output sample m is at the time of input sample m*down/up. The ends are extended with the first/last sample.
+	*
+	* Kernels are immutable, get() caches one per ratio so that it is designed once per process.
+	*/
+	class resampler {
+		public:
+			/**
+			* @brief Designs the kernel of a ratio, use get() to share kernels
+			*
+			* @param up Upsampling factor
+			* @param down Downsampling factor
+			* @param halfwidth Zero crossings of the sinc on each side
+			*/
+			resampler(const unsigned int up, const unsigned int down, const unsigned int halfwidth = 10);
+
+			/**
+			* @brief Cached kernel of a ratio (thread-safe)
+			*
+			* @param up Upsampling factor
+			* @param down Downsampling factor
+			*
+			* @return Kernel, shared by all callers with the same ratio
+			*/
+			static std::shared_ptr<const resampler> get(const unsigned int up, const unsigned int down);
+
+			/**
+			* @brief Smallest ratio up/down from fsin to fsout (frequencies are taken with 0.001 Hz precision)
+			*
+			* @param fsin Input sampling frequency
+			* @param fsout Output sampling frequency
+			*
+			* @return up and down
+			*/
+			static std::pair<unsigned int, unsigned int> ratio(const double fsin, const double fsout);
+
+			/**
+			* @brief Number of output samples of n input samples, ceil(n*up/down)
+			*
+			* @param n Number of input samples
+			*
+			* @return Number of output samples
+			*/
+			std::size_t outsamples(const std::size_t n) const {
+				return static_cast<std::size_t>((static_cast<unsigned long long>(n) * _up + _down - 1) / _down);
+			}
+
+			/**
+			* @brief Resamples one lead (thread-safe, the kernel is not modified)
+			*
+			* Integer samples are rounded and saturated.
+			*
+			* @tparam T Sample type (double, int16_t, int32_t)
+			* @param in First of n input samples
+			* @param n Number of input samples
+			* @param out First of outsamples(n) output samples
+			*/
+			template<class T>
+			void apply(const T *in, const std::size_t n, T *out) const;
+
+			/**
+			* @brief Upsampling factor
+			*
+			* @return up
+			*/
+			unsigned int up() const {
+				return _up;
+			}
+
+			/**
+			* @brief Downsampling factor
+			*
+			* @return down
+			*/
+			unsigned int down() const {
+				return _down;
+			}
+
+			/**
+			* @brief Taps per phase
+			*
+			* @return Length of the inner product of one output sample
+			*/
+			std::size_t ntaps() const {
+				return _ntaps;
+			}
+
+		private:
+			/**
+			* @brief Upsampling factor
+			*/
+			unsigned int _up;
+
+			/**
+			* @brief Downsampling factor
+			*/
+			unsigned int _down;
+
+			/**
+			* @brief Taps per phase
+			*/
+			std::size_t _ntaps;
+
+			/**
+			* @brief Delay of the center of the filter in upsampled samples
+			*/
+			std::size_t _center;
+
+			/**
+			* @brief Phases, phase p at p*_ntaps, taps reversed
+			*/
+			std::vector<double> _phases;
+	};
+
+	/**
+	 * @brief Resamples all leads of an ecgdata to a sampling frequency, e.g. resample(e, 1000) before delineation
+	 *
+	 * The leads are resampled independently, by up to threads threads. Lead names, gain, baseline and properties are kept.
+	 * Annotations are in ms and keep their location; annotations beyond the end of the resampled record are dropped.
+	 *
+	 * @tparam T Sample type (double, int16_t, int32_t)
+	 * @param e Ecgdata
+	 * @param fs Output sampling frequency
+	 * @param threads Number of threads, 0 for one per hardware thread
+	 *
+	 * @return Resampled ecgdata, a copy sharing samples with e if fs is e.fs()
+	 */
+	template<class T>
+	Ecgdata<T> resample(const Ecgdata<T> &e, const double fs, const unsigned int threads = 1);
+
+	/*!
+	 *@}
+	 */
+}
+
+#endif
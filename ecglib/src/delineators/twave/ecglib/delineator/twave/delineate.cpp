@@ -21,6 +21,7 @@
  */
 
 #include "math.h" // for calculating sigmoid function
+#include <algorithm>
 #include "delineate.hpp"
 
 using namespace ecglib::twaveDelineate;
@@ -29,15 +30,13 @@ using namespace ecglib::twaveDelineate;
 /// Main function for finding twave delineation based on twave's candidates containing peaks & slurs
 annotation delineate::delineator(const arma::rowvec& twave, int pointStart, const std::vector<std::vector<double> >& featursThreshold,
 				int candidateFinderFlag, double deltaStepSlope, int looseWindow, int minPoints, double deltaAmplitude, double minVoltageMainPeak, double percentMainePeak,
-				double minVoltage, double percentPeak, double maxDelatAplitudeNotches, double minAmplitudeFlatness, double minValidAmplitudePeak, double measurableVoltage) {
+				double minVoltage, double percentPeak, double maxDelatAplitudeNotches, double minAmplitudeFlatness, double minValidAmplitudePeak, double measurableVoltage, int maxSlopeLevels, bool mergeCandidates) {
 	/*
 	// This function takes a twave as an input and returns twave's annotators ton/ tpeak/ tppeak/ toff/ flatness/ skewness/ rotation
 	// twave should be a filtered wave otherwise this function could not find proper annotators
 	*/
 
 	annotation anns;				// main output structure of annotators
-	std::vector<candidate> candids; 		// main internal structure for keeping info of all candidates
-	std::vector<int> badCandidates; 		// temporary container for removing candidates in different steps
 	try {	
 		arma::rowvec derivative = twave(arma::span(1,twave.n_elem-1)) - twave(arma::span(0,twave.n_elem-2)); // first derivative of twave
 
@@ -49,111 +48,64 @@ annotation delineate::delineator(const arma::rowvec& twave, int pointStart, cons
 				    // smaller number can reduce the number of candidates.
 				    // 10 is about 5.7' degree in which removes slurs less than this range of slope.	
 		if (candidateFinderFlag != 2)
-			delineate::candidateFinder(twave, derivative, movedZeroCrossingAmplitutedPage, candidatePeaksPosition, deltaStepSlope); // finds the candidates
+			delineate::candidateFinder(twave, derivative, movedZeroCrossingAmplitutedPage, candidatePeaksPosition, deltaStepSlope, maxSlopeLevels); // finds the candidates
 		else
 			delineate::candidateFinder2DerivativeBased(twave, derivative, movedZeroCrossingAmplitutedPage, candidatePeaksPosition); // finds the candidates	
 
-		/* step02: finds a range of each candidate for later processing */
-		//int looseWindow = 10; // defines min points of a candidate: bigger size can marge candidates and smaller size can generate more candidates
-		delineate::candidateRangeInfoFinder(derivative, movedZeroCrossingAmplitutedPage, candids, looseWindow); // find the candidate ranges containing start of rising slope of candidate & end of falling slope of candidates
-		movedZeroCrossingAmplitutedPage.clear();
-
-		/* step03 (rule pre_process): removes small candidates in term of number of points */
-		//int minPoints = 10; // min points that make a candidate
-		badCandidates = preProcessingRules::fewPointsCandidates(candids, minPoints);
-		anns.rulesHit["fewPointsCandidates"] = badCandidates.size();
-		delineate::cleanUpCandidates(candids, badCandidates);
-
-		/* step04: labels candidates by slur(0) & peak(2) */
-		delineate::labellingPeaks(candids, candidatePeaksPosition);
-		candidatePeaksPosition.clear();
-
-		/* step05: finds annotation of each candidate */
-		//double deltaAmplitude = 5; 	/* pre defined threshold for calculating peak of each candidate
-		//				   The candidat's peak can contain couple of points with highest amplitude <= deltaAmplitude */
-		for (candidate& candid : candids) {
-			delineateFinder::delineatorsInfo(twave, derivative, candid, deltaAmplitude); // finds rising slope/ peak/ falling slope/ skewness/ distortion & flatness of candidate
-		}
-		derivative.clear();
-
-		/* *********		   ********* */
-		/* * * * * 		    * * * *  */
-		/*  * * * 		     * * * * */
-		/* ***** post processing steps ***** */
+		anns = delineate::delineateCandidates(twave, derivative, pointStart, movedZeroCrossingAmplitutedPage, candidatePeaksPosition, featursThreshold,
+				looseWindow, minPoints, deltaAmplitude, minVoltageMainPeak, percentMainePeak, minVoltage, percentPeak, maxDelatAplitudeNotches, minAmplitudeFlatness, minValidAmplitudePeak, measurableVoltage, mergeCandidates);
 
-		/* step06 (rule post_process): removes candidates when main peak has a low amplitude*/
-		badCandidates = postProcessingRules::lowAmplitudeMainPeak(candids, minVoltageMainPeak, percentMainePeak);
-		anns.rulesHit["lowAmplitudeMainPeak"] = badCandidates.size();
-		delineate::cleanUpCandidates(candids, badCandidates);
+	} catch(const std::exception &e){
+		std::string line = std::string("Caught exception (Could not delineate ECG, error in t-wave delineation): ") + e.what();
+		std::cerr << line;
+		throw;
+	} catch(const char* e){
+		std::string line = std::string("Caught exception (Could not delineate ECG, error in t-wave delineation): ") + e;
+		std::cerr << line;
+		throw;
+	} catch(...){
+		std::string line = std::string("Unknown caught exception (Could not delineate ECG, error in t-wave delineation)");
+		std::cerr << line;
+		throw;
+	}
 
-		/* step07 (rule post_process): removes peaks with low amplitude based on max peak */
-		badCandidates = postProcessingRules::lowAmplitudePeaks(candids, minVoltage, percentPeak);
-		anns.rulesHit["lowAmplitudePeaks"] = badCandidates.size();
-		delineate::cleanUpCandidates(candids, badCandidates);
+	return anns;
+}
 
-		/* step08 (rule post_process): remove a peak candidate, if the amplitude differences between max peak and this peak is considerable */
-		badCandidates = postProcessingRules::inconsistentPeaks(candids, maxDelatAplitudeNotches);
-		anns.rulesHit["inconsistentPeaks"] = badCandidates.size();
-		delineate::cleanUpCandidates(candids, badCandidates);
 
-		/* step09: re-labeles the slur candidates
-		 	   slur(0)[contains slur before or after slur & slur with inconsistent slope],
-		           rising slur(1) [contains slur before a peak with rising slope], and
-		           falling slur(-1) [contains slur after a peak with falling slope] */
-		delineate::reLabellingSlurs(candids);
+/// Batch version of delineator: the first derivative and the moving zero crossing lines of several twaves are processed at once (one lane per twave)
+std::vector<annotation> delineate::delineator(const std::vector<arma::rowvec>& twaves, const std::vector<int>& pointStarts, const std::vector<std::vector<double> >& featursThreshold,
+				int candidateFinderFlag, double deltaStepSlope, int looseWindow, int minPoints, double deltaAmplitude, double minVoltageMainPeak, double percentMainePeak,
+				double minVoltage, double percentPeak, double maxDelatAplitudeNotches, double minAmplitudeFlatness, double minValidAmplitudePeak, double measurableVoltage, int maxSlopeLevels, bool mergeCandidates) {
 
-		/* step10 (rule post_process): removes unrelated slur(0)
-			   caution: this step should not be commented or ignored. It has an effects on output preparation steps */
-		badCandidates = postProcessingRules::unrelatedSlure(candids);
-		anns.rulesHit["unrelatedSlure"] = badCandidates.size();
-		delineate::cleanUpCandidates(candids, badCandidates);
+	std::vector<annotation> anns(twaves.size());
+	if (twaves.size() != pointStarts.size()) {
+		std::string line = std::string("Number of twaves and start points differ");
+		std::cerr << line;
+		throw std::logic_error(line);
+	}
 
-		/* step11 (rule post_process): merges two consecutive candidates  for shaping a flat candidate based on amplitude */
-		badCandidates = postProcessingRules::meargingCandidates(twave, candids, minAmplitudeFlatness);
-		anns.rulesHit["meargingCandidates"] = badCandidates.size() / 2;
-		delineate::cleanUpCandidates(candids, badCandidates);
+	// the derivative based finder has not lanes mode
+	if (candidateFinderFlag == 2) {
+		for (std::size_t b = 0; b < twaves.size(); ++b) {
+			anns[b] = delineate::delineator(twaves[b], pointStarts[b], featursThreshold, candidateFinderFlag, deltaStepSlope, looseWindow, minPoints, deltaAmplitude, minVoltageMainPeak, percentMainePeak,
+							minVoltage, percentPeak, maxDelatAplitudeNotches, minAmplitudeFlatness, minValidAmplitudePeak, measurableVoltage, maxSlopeLevels, mergeCandidates);
+		}
+		return anns;
+	}
 
-		/* step12 (rule post_process): distinguishes between good slur and bad slur to clean up the slur's candidates (using extracted rules by decision-tree) */
-		badCandidates = postProcessingRules::slurClassifier(candids, featursThreshold);
-		anns.rulesHit["slurClassifier"] = badCandidates.size();
-		cleanUpCandidates(candids, badCandidates);
-
-		/* step13 (rule post_process): keeps max two peaks based on max amplitude
-		          this step changes the label of peaks after second peak */
-		badCandidates = postProcessingRules::keepJustTwoPeaks(candids);
-		anns.rulesHit["keepJustTwoPeaks"] = badCandidates.size();
-		for (std::size_t i = 0; i < badCandidates.size() && candids.size() > 0; ++i)
-			candids[badCandidates[i]].set_label(candidateLabel::peakUnrelated);	// converts to unrelated peak
-		eraseList(badCandidates);	/* do not clear peaks after second peak from list just simply do not use them for final output.
-						   Still the slope of these peaks can change the place of on/off set
-						   if do not remove them, they will assume as slur. if want to remove them, should remove dependent slurs with those peaks as well */
-
-		/* step14 (rule post_process): converts a peak to slure when one of its angle is really small based on delta ampiltude of that angle with local minima */
-		badCandidates = postProcessingRules::convertPeakToSlur(twave, candids, minValidAmplitudePeak);	
-		anns.rulesHit["convertPeakToSlur"] = badCandidates.size();
-		for (std::size_t i = 0; i < badCandidates.size(); ++i)
-			candids[badCandidates[i]].set_label(candidateLabel::sluredPeak);	// converts to slured-peak
-		eraseList(badCandidates);	/* do not clear peaks after second peak from list just simply do not use them for final output.
-						   Still the slope of these peaks can change the place of on/off set
-						   if do not remove them, they will assume as slur. if want to remove them, should remove dependent slurs with those peaks as well */
-
-		/* step15 (rule post_process): just an informative flag to label a non-measurable signal (low main peak amplitude) */
-		bool nonMeasurable = postProcessingRules::nonMeasurableSignal(candids, measurableVoltage);
-		anns.rulesHit["non-measurable"] = (nonMeasurable? 1: 0);
-
-		/* step16: output preparation */
-		std::vector<int> indexPeakCandidates = postProcessingRules::peakCandidates(candids);
-		if (indexPeakCandidates.size() > 0) {   // if this condition hits false: main peak has got removed based on current rules
-			anns.on = std::round(pointStart - (candids[0].get_b0() / candids[0].get_a0())); // intersection between max slope of first left candidate with line amplitude  = 0
-			anns.off = std::round(pointStart - (candids[candids.size()-1].get_b1() / candids[candids.size()-1].get_a1())); // intersection between min slope of last right candidate with line amplitude  = 0
-			anns.lastCandidate = pointStart + candids[candids.size()-1].get_x();
-
-			for (std::size_t i = 0; i < indexPeakCandidates.size(); ++i) {
-				anns.peak.push_back(pointStart + candids[indexPeakCandidates[i]].get_x());
-				anns.flatness.push_back(candids[indexPeakCandidates[i]].get_flatnessSamples());
-				anns.distortion.push_back(candids[indexPeakCandidates[i]].get_distortion());
-				anns.skewness.push_back(candids[indexPeakCandidates[i]].get_skewness());
-			}
+	try {
+		/* step01: first derivative and moving zero crossing lines of all twaves (lanes) */
+		std::vector<arma::rowvec> movedZeroCrossingAmplitutedPages;
+		std::vector<arma::uvec> candidatePeaksPositions;
+		delineate::candidateFinderLanes(twaves, movedZeroCrossingAmplitutedPages, candidatePeaksPositions, deltaStepSlope, maxSlopeLevels);
+
+		/* step02 - step16 are data dependent and continue per twave */
+		for (std::size_t b = 0; b < twaves.size(); ++b) {
+			const arma::rowvec& twave = twaves[b];
+			arma::rowvec derivative = twave(arma::span(1,twave.n_elem-1)) - twave(arma::span(0,twave.n_elem-2)); // first derivative of twave
+			anns[b] = delineate::delineateCandidates(twave, derivative, pointStarts[b], movedZeroCrossingAmplitutedPages[b], candidatePeaksPositions[b], featursThreshold,
+					looseWindow, minPoints, deltaAmplitude, minVoltageMainPeak, percentMainePeak, minVoltage, percentPeak, maxDelatAplitudeNotches, minAmplitudeFlatness, minValidAmplitudePeak, measurableVoltage, mergeCandidates);
 		}
 
 	} catch(const std::exception &e){
@@ -173,96 +125,250 @@ annotation delineate::delineator(const arma::rowvec& twave, int pointStart, cons
 	return anns;
 }
 
+
+/// finds twave delineation based on the candidates of twave (steps 02 - 16 of delineator)
+annotation delineate::delineateCandidates(const arma::rowvec& twave, arma::rowvec& derivative, int pointStart, arma::rowvec& movedZeroCrossingAmplitutedPage, arma::uvec& candidatePeaksPosition,
+				const std::vector<std::vector<double> >& featursThreshold, int looseWindow, int minPoints, double deltaAmplitude, double minVoltageMainPeak, double percentMainePeak,
+				double minVoltage, double percentPeak, double maxDelatAplitudeNotches, double minAmplitudeFlatness, double minValidAmplitudePeak, double measurableVoltage, bool mergeCandidates) {
+
+	annotation anns;				// main output structure of annotators
+	candidateTable candids; 		// main internal structure for keeping info of all candidates (column-wise)
+	std::vector<int> badCandidates; 		// temporary container for removing candidates in different steps
+
+	/* step02: finds a range of each candidate for later processing */
+	//int looseWindow = 10; // defines min points of a candidate: bigger size can marge candidates and smaller size can generate more candidates
+	delineate::candidateRangeInfoFinder(derivative, movedZeroCrossingAmplitutedPage, candids, looseWindow); // find the candidate ranges containing start of rising slope of candidate & end of falling slope of candidates
+	movedZeroCrossingAmplitutedPage.clear();
+
+	/* step03 (rule pre_process): removes small candidates in term of number of points */
+	//int minPoints = 10; // min points that make a candidate
+	badCandidates = preProcessingRules::fewPointsCandidates(candids, minPoints);
+	anns.rulesHit[rule::fewPointsCandidates] = badCandidates.size();
+	delineate::cleanUpCandidates(candids, badCandidates);
+
+	/* step04: labels candidates by slur(0) & peak(2) */
+	delineate::labellingPeaks(candids, candidatePeaksPosition);
+	candidatePeaksPosition.clear();
+
+	/* step05: finds annotation of each candidate */
+	//double deltaAmplitude = 5; 	/* pre defined threshold for calculating peak of each candidate
+	//				   The candidat's peak can contain couple of points with highest amplitude <= deltaAmplitude */
+	for (std::size_t candid = 0; candid < candids.size(); ++candid) {
+		delineateFinder::delineatorsInfo(twave, derivative, candids, candid, deltaAmplitude); // finds rising slope/ peak/ falling slope/ skewness/ distortion & flatness of candidate
+	}
+	derivative.clear();
+
+	/* *********		   ********* */
+	/* * * * * 		    * * * *  */
+	/*  * * * 		     * * * * */
+	/* ***** post processing steps ***** */
+
+	/* step06 (rule post_process): removes candidates when main peak has a low amplitude*/
+	badCandidates = postProcessingRules::lowAmplitudeMainPeak(candids, minVoltageMainPeak, percentMainePeak);
+	anns.rulesHit[rule::lowAmplitudeMainPeak] = badCandidates.size();
+	delineate::cleanUpCandidates(candids, badCandidates);
+
+	/* step07 (rule post_process): removes peaks with low amplitude based on max peak */
+	badCandidates = postProcessingRules::lowAmplitudePeaks(candids, minVoltage, percentPeak);
+	anns.rulesHit[rule::lowAmplitudePeaks] = badCandidates.size();
+	delineate::cleanUpCandidates(candids, badCandidates);
+
+	/* step08 (rule post_process): remove a peak candidate, if the amplitude differences between max peak and this peak is considerable */
+	badCandidates = postProcessingRules::inconsistentPeaks(candids, maxDelatAplitudeNotches);
+	anns.rulesHit[rule::inconsistentPeaks] = badCandidates.size();
+	delineate::cleanUpCandidates(candids, badCandidates);
+
+	/* step09: re-labeles the slur candidates
+	 	   slur(0)[contains slur before or after slur & slur with inconsistent slope],
+	           rising slur(1) [contains slur before a peak with rising slope], and
+	           falling slur(-1) [contains slur after a peak with falling slope] */
+	delineate::reLabellingSlurs(candids);
+
+	/* step10 (rule post_process): removes unrelated slur(0)
+		   caution: this step should not be commented or ignored. It has an effects on output preparation steps */
+	badCandidates = postProcessingRules::unrelatedSlure(candids);
+	anns.rulesHit[rule::unrelatedSlure] = badCandidates.size();
+	delineate::cleanUpCandidates(candids, badCandidates);
+
+	/* step11 (rule post_process): merges two consecutive candidates  for shaping a flat candidate based on amplitude */
+	if (mergeCandidates) {
+		badCandidates = postProcessingRules::meargingCandidates(twave, candids, minAmplitudeFlatness);
+		anns.rulesHit[rule::meargingCandidates] = badCandidates.size() / 2;
+		delineate::cleanUpCandidates(candids, badCandidates);
+	}
+
+	/* step12 (rule post_process): distinguishes between good slur and bad slur to clean up the slur's candidates (using extracted rules by decision-tree) */
+	badCandidates = postProcessingRules::slurClassifier(candids, featursThreshold);
+	anns.rulesHit[rule::slurClassifier] = badCandidates.size();
+	cleanUpCandidates(candids, badCandidates);
+
+	/* step13 (rule post_process): keeps max two peaks based on max amplitude
+	          this step changes the label of peaks after second peak */
+	badCandidates = postProcessingRules::keepJustTwoPeaks(candids);
+	anns.rulesHit[rule::keepJustTwoPeaks] = badCandidates.size();
+	for (std::size_t i = 0; i < badCandidates.size() && candids.size() > 0; ++i)
+		candids.set_label(badCandidates[i], candidateLabel::peakUnrelated);	// converts to unrelated peak
+	eraseList(badCandidates);	/* do not clear peaks after second peak from list just simply do not use them for final output.
+					   Still the slope of these peaks can change the place of on/off set
+					   if do not remove them, they will assume as slur. if want to remove them, should remove dependent slurs with those peaks as well */
+
+	/* step14 (rule post_process): converts a peak to slure when one of its angle is really small based on delta ampiltude of that angle with local minima */
+	badCandidates = postProcessingRules::convertPeakToSlur(twave, candids, minValidAmplitudePeak);	
+	anns.rulesHit[rule::convertPeakToSlur] = badCandidates.size();
+	for (std::size_t i = 0; i < badCandidates.size(); ++i)
+		candids.set_label(badCandidates[i], candidateLabel::sluredPeak);	// converts to slured-peak
+	eraseList(badCandidates);	/* do not clear peaks after second peak from list just simply do not use them for final output.
+					   Still the slope of these peaks can change the place of on/off set
+					   if do not remove them, they will assume as slur. if want to remove them, should remove dependent slurs with those peaks as well */
+
+	/* step15 (rule post_process): just an informative flag to label a non-measurable signal (low main peak amplitude) */
+	bool nonMeasurable = postProcessingRules::nonMeasurableSignal(candids, measurableVoltage);
+	anns.rulesHit[rule::nonMeasurable] = (nonMeasurable? 1: 0);
+
+	/* step16: output preparation */
+	std::vector<int> indexPeakCandidates = postProcessingRules::peakCandidates(candids);
+	if (indexPeakCandidates.size() > 0) {   // if this condition hits false: main peak has got removed based on current rules
+		anns.on = std::round(pointStart - (candids.get_b0(0) / candids.get_a0(0))); // intersection between max slope of first left candidate with line amplitude  = 0
+		anns.off = std::round(pointStart - (candids.get_b1(candids.size()-1) / candids.get_a1(candids.size()-1))); // intersection between min slope of last right candidate with line amplitude  = 0
+		anns.lastCandidate = pointStart + candids.get_x(candids.size()-1);
+
+		for (std::size_t i = 0; i < indexPeakCandidates.size(); ++i) {
+			anns.peak.push_back(pointStart + candids.get_x(indexPeakCandidates[i]));
+			anns.flatness.push_back(candids.get_flatnessSamples(indexPeakCandidates[i]));
+			anns.distortion.push_back(candids.get_distortion(indexPeakCandidates[i]));
+			anns.skewness.push_back(candids.get_skewness(indexPeakCandidates[i]));
+		}
+	}
+
+	return anns;
+}
+
 /// finds all candidates of twave based on moving zero crossing line on a clean first derivative vectore
-void delineate::candidateFinder(const arma::rowvec& wave, const arma::rowvec& derivative, arma::rowvec& movedZeroCrossingAmplitutedMax, arma::uvec& candidatePeaksPosition, double deltaStepSlope) {
+void delineate::candidateFinder(const arma::rowvec& wave, const arma::rowvec& derivative, arma::rowvec& movedZeroCrossingAmplitutedMax, arma::uvec& candidatePeaksPosition, double deltaStepSlope, int maxSlopeLevels) {
 	// moving the slope origin from max slop of first derivative to min slope of first derivative to find all candidates (peak/slur) and range of each
 	// this function takes care of falt slopes (derivative = zero) as well
 
-	double startingSlope = std::trunc(derivative.max() * deltaStepSlope) / deltaStepSlope;
-	double endingSlope   = std::trunc(derivative.min() * deltaStepSlope) / deltaStepSlope;
-	int numberSlope      = ((startingSlope - endingSlope ) * deltaStepSlope) + 1; // number of different slopes when moving the slope origin line
+	double startingSlope;
+	int numberSlope, zeroSlopeIndex;
+	delineate::slopeLevels(derivative, deltaStepSlope, startingSlope, numberSlope, zeroSlopeIndex);
+
+	arma::rowvec hit(derivative.n_elem -1, arma::fill::zeros);	 // intersection of any moving slope line with derivative (max over all slopes)
+	arma::rowvec peakHit(derivative.n_elem -1, arma::fill::zeros); // intersection of slopes 'zeroSlopeIndex' & 'zeroSlopeIndex - 1' & 'zeroSlopeIndex + 1' with derivative
+	arma::rowvec signs(derivative.n_elem);
+	std::vector<int> pending;	// index of flat slopes on derivative (temporary index)
 
-	int zeroSlopeIndex = static_cast<int>(startingSlope * deltaStepSlope); // index slope when it's equal to zero: for sanity check 'zeroSlopeIndex - 1' & 'zeroSlopeIndex + 1' should be checked too
-	arma::mat movedZeroCrossingPage(numberSlope, derivative.n_elem -1, arma::fill::zeros); // keeps the intersection of moving slope line with derivative
-	arma::mat peakCandidates(3, derivative.n_elem -1, arma::fill::zeros); // 3 cells: for 'zeroSlopeIndex' & 'zeroSlopeIndex - 1' & 'zeroSlopeIndex + 1'
+	// when the number of slopes is capped, slopes are skipped evenly but the slopes around zero are always kept for finding peaks
+	int strideSlope = (maxSlopeLevels > 0 && numberSlope > maxSlopeLevels) ? (numberSlope + maxSlopeLevels - 1) / maxSlopeLevels : 1;
 
 	for (int j = 0; j < numberSlope; ++j) {
+		if (strideSlope > 1 && j % strideSlope != 0 && std::abs(j - zeroSlopeIndex) > 1) continue;
 		double movingOriginZeroSlope = startingSlope + (j * (-1 / deltaStepSlope));
-		bool signFlag = true;
-        	arma::uvec indexFlatSlope;
+		signs = arma::sign(arma::trunc((derivative - movingOriginZeroSlope) * deltaStepSlope));
+		delineate::candidateSweep(signs.memptr(), derivative.n_elem, std::abs(j - zeroSlopeIndex) <= 1, hit, peakHit, pending);
+	} // end of for: j
 
-		for (int i = 1; i < static_cast<int>(derivative.n_elem); ++i) {
-			double deltaSlope = std::trunc((derivative(i) - movingOriginZeroSlope) * deltaStepSlope);
-			int signDeltaSlope = (deltaSlope > 0) ? 1 : ((deltaSlope < 0) ? -1 : 0);
-			double deltaSlopePrevious = std::trunc((derivative(i-1) - movingOriginZeroSlope) * deltaStepSlope);
-			int signDeltaSlopePrevious = (deltaSlopePrevious > 0) ? 1 : ((deltaSlopePrevious < 0) ? -1 : 0);
+	movedZeroCrossingAmplitutedMax = hit % wave(arma::span(1, wave.n_elem -2)); // vectore of intersection of moving zero crossing line * amplitude of each point
+	candidatePeaksPosition = arma::find(peakHit > 0); // place of peaks (intersection with slope = 0 ) based on first derivative
+}
 
-			if (signDeltaSlope == 1) {
-				signFlag = true;
-				indexFlatSlope.clear();
-				if ((i-1)-1 >= 0) indexFlatSlope = arma::find(movedZeroCrossingPage(j,arma::span(0,(i-1)-1)) == 2);  // index of flat slopes on derivative (temporary index)
-				arma::urowvec jj(1); jj = j;
-				if (!indexFlatSlope.is_empty()) movedZeroCrossingPage(jj,indexFlatSlope) = arma::zeros<arma::mat>(1,indexFlatSlope.n_elem); // reset index of flat slopes on derivative (temporary index)
-			}
-			else if (signDeltaSlope == 0) {
-				if (signDeltaSlopePrevious == 1)
-					movedZeroCrossingPage(j,i-1) = 2; //set index of flat slope on derivative (temporary index)
-				else if (signDeltaSlopePrevious == 0) {
-					if (signFlag == true)
-						movedZeroCrossingPage(j,i-1) = 2; //set index of flat slopes on derivative (temporary index)
-					else // if (signFlag == false)
-						signFlag = false;
-					}
-				else if (signDeltaSlopePrevious == -1)
-					signFlag = false;
-			}
- 			else if(signDeltaSlope == -1) {
-				if (signDeltaSlopePrevious == 1) {
-					movedZeroCrossingPage(j,i-1) = 1; // moved zero crossing line has intersection with derivative (one point of a candidate )
-					int jz = (j == zeroSlopeIndex -1) ? 0 : (j == zeroSlopeIndex ? 1 : (j == zeroSlopeIndex +1 ? 2 : -1));
-					if (jz != -1) peakCandidates(jz,i-1) = 1; // derivative has intersection with moved zero crossing line = 0 (slope == 0)
-				}
-				else if (signDeltaSlopePrevious == 0) {
-					if (signFlag == true) {
-						movedZeroCrossingPage(j,i-1) = 1;
-						indexFlatSlope.clear();
-						if ((i-1)-1 >= 0) indexFlatSlope = arma::find(movedZeroCrossingPage(j,arma::span(0,(i-1)-1)) == 2); // index of flat slopes on derivative (temporary index)
-						arma::urowvec jj(1); jj = j;
-						if (!indexFlatSlope.is_empty()) movedZeroCrossingPage(jj,indexFlatSlope) = arma::ones<arma::mat>(1,indexFlatSlope.n_elem);// moved zero crossing line has intersection with derivative (based on temporary index of flat slopes)
-
-						int jz = (j == zeroSlopeIndex -1) ? 0 : (j == zeroSlopeIndex ? 1 : (j == zeroSlopeIndex +1 ? 2 : -1));
-						if (jz != -1) {
-							peakCandidates(jz,i-1) = 1; // moved zero crossing line has intersection with derivative (one point of a candidate )
-							arma::urowvec jj(1); jj = jz;
-							if (!indexFlatSlope.is_empty()) peakCandidates(jj,indexFlatSlope) = arma::ones<arma::mat>(1,indexFlatSlope.n_elem); // moved zero crossing line has intersection with derivative (based on temporary index of flat slopes)
-						}
-					}
-					else { //if (signFlag == false)
-						indexFlatSlope.clear();
-						if ((i-1)-1 >= 0) indexFlatSlope = arma::find(movedZeroCrossingPage(j,arma::span(0,(i-1)-1)) == 2); // index of flat slopes on derivative (temporary index)
-						arma::urowvec jj(1); jj = j;
-						if (!indexFlatSlope.is_empty()) movedZeroCrossingPage(jj,indexFlatSlope) = arma::zeros<arma::mat>(1,indexFlatSlope.n_elem); // reset index of flat slopes on derivative (temporary index)
-					}
-				} // end of: if(signDeltaSlopePrevious == 0)
-				else if (signDeltaSlopePrevious == -1) {
-					// do nothing
-				}
-				signFlag = false;
-				indexFlatSlope.clear();
-				if ((i-1)-1 >= 0) indexFlatSlope = arma::find(movedZeroCrossingPage(j,arma::span(0,(i-1)-1)) == 2); // index of flat slopes on derivative (temporary index)
-				arma::urowvec jj(1); jj = j;
-				if (!indexFlatSlope.is_empty()) movedZeroCrossingPage(jj,indexFlatSlope) = arma::zeros<arma::mat>(1,indexFlatSlope.n_elem); // reset index of flat slopes on derivative (temporary index)
-			} // end of: if(signDeltaSlope == -1)
-		} // end of for: i
+/// finds all candidates of several twaves (lanes) based on moving zero crossing line; the signs of each slope are calculated for all lanes at once
+void delineate::candidateFinderLanes(const std::vector<arma::rowvec>& waves, std::vector<arma::rowvec>& movedZeroCrossingAmplitutedMax, std::vector<arma::uvec>& candidatePeaksPosition, double deltaStepSlope, int maxSlopeLevels) {
+	std::size_t nlanes = waves.size();
+	movedZeroCrossingAmplitutedMax.assign(nlanes, arma::rowvec());
+	candidatePeaksPosition.assign(nlanes, arma::uvec());
+	if (nlanes == 0) return;
+
+	// lanes are the columns of a matrix; shorter derivatives are padded by their last value (padded samples are never swept)
+	arma::uword maxLength = 0;
+	for (std::size_t b = 0; b < nlanes; ++b)
+		maxLength = std::max<arma::uword>(maxLength, waves[b].n_elem -1);
+
+	arma::mat derivatives(maxLength, nlanes);
+	arma::rowvec startingSlopes(nlanes);
+	std::vector<int> numberSlopes(nlanes), zeroSlopeIndexes(nlanes), strideSlopes(nlanes);
+	std::vector<arma::rowvec> hits(nlanes), peakHits(nlanes);
+	int maxNumberSlope = 0;
+
+	for (std::size_t b = 0; b < nlanes; ++b) {
+		const arma::rowvec& wave = waves[b];
+		arma::uword n = wave.n_elem -1;
+		arma::rowvec derivative = wave(arma::span(1,n)) - wave(arma::span(0,n-1)); // first derivative of twave
+		derivatives(arma::span(0,n-1), b) = derivative.t();
+		if (n < maxLength) derivatives(arma::span(n,maxLength-1), b).fill(derivative(n-1));
+
+		double startingSlope;
+		delineate::slopeLevels(derivative, deltaStepSlope, startingSlope, numberSlopes[b], zeroSlopeIndexes[b]);
+		startingSlopes(b) = startingSlope;
+		strideSlopes[b] = (maxSlopeLevels > 0 && numberSlopes[b] > maxSlopeLevels) ? (numberSlopes[b] + maxSlopeLevels - 1) / maxSlopeLevels : 1;
+		maxNumberSlope = std::max(maxNumberSlope, numberSlopes[b]);
+		hits[b].zeros(n -1);
+		peakHits[b].zeros(n -1);
+	}
 
-		indexFlatSlope = arma::find(movedZeroCrossingPage(j,arma::span::all) == 2);
-		arma::urowvec jj(1); jj = j;
-		if (!indexFlatSlope.is_empty()) movedZeroCrossingPage(jj,indexFlatSlope) = arma::zeros<arma::mat>(1,indexFlatSlope.n_elem); // reset index of flat slopes on derivative (temporary index)
-	} // end of for: j
+	arma::mat signs(maxLength, nlanes);
+	std::vector<int> pending;
+	for (int j = 0; j < maxNumberSlope; ++j) {
+		// every lane moves its own slope origin; the signs of all lanes are calculated by one element-wise pass
+		arma::rowvec movingOriginZeroSlope = startingSlopes + (j * (-1 / deltaStepSlope));
+		signs = arma::sign(arma::trunc((derivatives.each_row() - movingOriginZeroSlope) * deltaStepSlope));
+
+		for (std::size_t b = 0; b < nlanes; ++b) {
+			if (j >= numberSlopes[b]) continue;
+			if (strideSlopes[b] > 1 && j % strideSlopes[b] != 0 && std::abs(j - zeroSlopeIndexes[b]) > 1) continue;
+			delineate::candidateSweep(signs.colptr(b), waves[b].n_elem -1, std::abs(j - zeroSlopeIndexes[b]) <= 1, hits[b], peakHits[b], pending);
+		}
+	}
 
-	movedZeroCrossingAmplitutedMax = arma::max(movedZeroCrossingPage,0) % wave(arma::span(1, wave.n_elem -2)); // vectore of intersection of moving zero crossing line * amplitude of each point
-	arma::rowvec peakCandidatesMax = arma::max(peakCandidates,0);
-	candidatePeaksPosition = arma::find(peakCandidatesMax > 0); // place of peaks (intersection with slope = 0 ) based on first derivative
+	for (std::size_t b = 0; b < nlanes; ++b) {
+		movedZeroCrossingAmplitutedMax[b] = hits[b] % waves[b](arma::span(1, waves[b].n_elem -2));
+		candidatePeaksPosition[b] = arma::find(peakHits[b] > 0);
+	}
+}
+
+/// calculates the range of moving zero crossing lines of a first derivative
+void delineate::slopeLevels(const arma::rowvec& derivative, double deltaStepSlope, double& startingSlope, int& numberSlope, int& zeroSlopeIndex) {
+	startingSlope = std::trunc(derivative.max() * deltaStepSlope) / deltaStepSlope;
+	double endingSlope = std::trunc(derivative.min() * deltaStepSlope) / deltaStepSlope;
+	numberSlope = ((startingSlope - endingSlope ) * deltaStepSlope) + 1; // number of different slopes when moving the slope origin line
+	zeroSlopeIndex = static_cast<int>(startingSlope * deltaStepSlope); // index slope when it's equal to zero: for sanity check 'zeroSlopeIndex - 1' & 'zeroSlopeIndex + 1' should be checked too
+}
+
+/// finds the intersections of one moving zero crossing line with the first derivative
+void delineate::candidateSweep(const double* signs, int n, bool peakLevel, arma::rowvec& hit, arma::rowvec& peakHit, std::vector<int>& pending) {
+	// flat slopes (sign = 0) are kept as pending points and become part of the candidate only if the derivative goes down afterwards
+	bool signFlag = true;
+	pending.clear();
+
+	for (int i = 1; i < n; ++i) {
+		int signDeltaSlope = static_cast<int>(signs[i]);
+		int signDeltaSlopePrevious = static_cast<int>(signs[i-1]);
+
+		if (signDeltaSlope == 1) {
+			signFlag = true;
+			pending.clear();
+		}
+		else if (signDeltaSlope == 0) {
+			if (signDeltaSlopePrevious == 1 || (signDeltaSlopePrevious == 0 && signFlag))
+				pending.push_back(i-1); // index of flat slope on derivative
+			else if (signDeltaSlopePrevious == -1)
+				signFlag = false;
+		}
+		else { // signDeltaSlope == -1
+			if (signDeltaSlopePrevious == 1 || (signDeltaSlopePrevious == 0 && signFlag)) {
+				hit(i-1) = 1; // moved zero crossing line has intersection with derivative (one point of a candidate)
+				if (peakLevel) peakHit(i-1) = 1; // derivative has intersection with moved zero crossing line = 0 (slope == 0)
+				if (signDeltaSlopePrevious == 0) {
+					for (std::size_t k = 0; k < pending.size(); ++k) {
+						hit(pending[k]) = 1; // based on temporary index of flat slopes
+						if (peakLevel) peakHit(pending[k]) = 1;
+					}
+				}
+			}
+			signFlag = false;
+			pending.clear();
+		}
+	}
+	pending.clear();
 }
 
 /// finds all candidates of twave based on a clean derivative (first/second) vectore
@@ -362,9 +468,8 @@ void delineate::candidateFinder2DerivativeBased(const arma::rowvec& wave, const
 }
 
 /// finds the range of each candidate based on derivative and previous/next candidate info
-void delineate::candidateRangeInfoFinder(const arma::rowvec& derivative, const arma::rowvec& movedZeroCrossingAmplitutedMax, std::vector<candidate>& candids, const int looseWindow) {
+void delineate::candidateRangeInfoFinder(const arma::rowvec& derivative, const arma::rowvec& movedZeroCrossingAmplitutedMax, candidateTable& candids, const int looseWindow) {
 
-	candidate candidTmp; // temporary candidate
     	arma::uvec candidatesPoints = arma::find( movedZeroCrossingAmplitutedMax != 0); // points of signal that have intersection with zero crossing line
 
 	if (candidatesPoints.n_elem == 0)
@@ -372,10 +477,10 @@ void delineate::candidateRangeInfoFinder(const arma::rowvec& derivative, const a
 
     	arma::uvec index = arma::find(derivative(arma::span(0,candidatesPoints(0))) == arma::min(derivative(arma::span(0,candidatesPoints(0)))));
 
-	candidTmp.set_candidateRangeInfo(index(index.n_elem -1), 0);
-	candidTmp.set_candidateRangeInfo(candidatesPoints(0), 1);
-	candidTmp.set_risingRangeInfo(candidatesPoints(0), 0);
-	candids.push_back(candidTmp);
+	std::size_t candid = candids.push_back(); // first candidate
+	candids.set_candidateRangeInfo(candid, index(index.n_elem -1), 0);
+	candids.set_candidateRangeInfo(candid, candidatesPoints(0), 1);
+	candids.set_risingRangeInfo(candid, candidatesPoints(0), 0);
 
 	int i = 1;
 	while (i < static_cast<int>(candidatesPoints.n_elem)) {
@@ -392,31 +497,31 @@ void delineate::candidateRangeInfoFinder(const arma::rowvec& derivative, const a
 
 			i += fraction;
 			arma::uvec indexMinSlope = arma::find(derivative(arma::span(candidatesPoints(i) +1, candidatesPoints(i+1) -1)) == arma::min(derivative(arma::span(candidatesPoints(i) +1, candidatesPoints(i+1) -1))));
-			candids[candids.size()-1].set_candidateRangeInfo(indexMinSlope(indexMinSlope.n_elem-1) + candidatesPoints(i) +1, 1) ;
-			candids[candids.size()-1].set_risingRangeInfo(candidatesPoints(i), 1);
+			candids.set_candidateRangeInfo(candids.size()-1, indexMinSlope(indexMinSlope.n_elem-1) + candidatesPoints(i) +1, 1) ;
+			candids.set_risingRangeInfo(candids.size()-1, candidatesPoints(i), 1);
 
 			{ // new candidate
-				candidTmp.set_candidateRangeInfo(candids[candids.size()-1].get_candidateRangeInfo(1), 0);
-				candidTmp.set_risingRangeInfo(candidatesPoints(i+1), 0);
-				candids.push_back(candidTmp);
+				candid = candids.push_back();
+				candids.set_candidateRangeInfo(candid, candids.get_candidateRangeInfo(candid-1, 1), 0);
+				candids.set_risingRangeInfo(candid, candidatesPoints(i+1), 0);
 			}
 		}
 		++i;
 	}
 
 	index = arma::find(derivative(arma::span(candidatesPoints(i-1), derivative.n_elem-1)) == arma::min(derivative(arma::span(candidatesPoints(i-1), derivative.n_elem-1))));
-	candids[candids.size()-1].set_candidateRangeInfo(index(index.n_elem-1) + candidatesPoints(i-1), 1);
-	candids[candids.size()-1].set_risingRangeInfo(candidatesPoints(i-1), 1);
+	candids.set_candidateRangeInfo(candids.size()-1, index(index.n_elem-1) + candidatesPoints(i-1), 1);
+	candids.set_risingRangeInfo(candids.size()-1, candidatesPoints(i-1), 1);
 }
 
 /// labelling the candidates into: slur/ peak
-void delineate::labellingPeaks(std::vector<candidate> &candids, const arma::uvec& candidatePeaksPosition) {
+void delineate::labellingPeaks(candidateTable &candids, const arma::uvec& candidatePeaksPosition) {
  
 	 int deltaSample = 3;  // tolerance sample point number of each candidate (loose filter calculation)
-	 for (auto& candid : candids) {
+	 for (std::size_t candid = 0; candid < candids.size(); ++candid) {
 		 for(int position: candidatePeaksPosition) {
-			 if ((position >= (candid.get_risingRangeInfo(0) - deltaSample)) && (position <= (candid.get_risingRangeInfo(1) + deltaSample))) {
-				candid.set_label(candidateLabel::peak); // peak
+			 if ((position >= (candids.get_risingRangeInfo(candid, 0) - deltaSample)) && (position <= (candids.get_risingRangeInfo(candid, 1) + deltaSample))) {
+				candids.set_label(candid, candidateLabel::peak); // peak
 				break;
 			 }
 		 }
@@ -424,21 +529,21 @@ void delineate::labellingPeaks(std::vector<candidate> &candids, const arma::uvec
 }
 
 /// re_labelling the slur candidates to: slur/ rising slur/ falling slur
-void delineate::reLabellingSlurs(std::vector<candidate>& candids) {
+void delineate::reLabellingSlurs(candidateTable& candids) {
 	for (int i = 0; i < static_cast<int>(candids.size()); ++i) {
-		if (candids[i].get_label() == 0 && candids[std::max(0,i-1)].get_label() == 2) { // falling slur
-			if (candids[i].get_a0() <= 0 && candids[i].get_a1() <= 0) //  slur after a peak with negative slopes
-			candids[i].set_label(candidateLabel::slurFalling);
+		if (candids.get_label(i) == 0 && candids.get_label(std::max(0,i-1)) == 2) { // falling slur
+			if (candids.get_a0(i) <= 0 && candids.get_a1(i) <= 0) //  slur after a peak with negative slopes
+			candids.set_label(i, candidateLabel::slurFalling);
 		}
-		else if (candids[i].get_label() == 2 && candids[std::max(0,i-1)].get_label() == 0) { // rising slur
-			if (candids[i-1].get_a0() >= 0 && candids[i-1].get_a1() >= 0) // slur before a peak with positive slopes
-				candids[i-1].set_label(candidateLabel::slurRising);
+		else if (candids.get_label(i) == 2 && candids.get_label(std::max(0,i-1)) == 0) { // rising slur
+			if (candids.get_a0(i-1) >= 0 && candids.get_a1(i-1) >= 0) // slur before a peak with positive slopes
+				candids.set_label(i-1, candidateLabel::slurRising);
 			}
 		}
 }
 
 /// re-adjusts the end of Twave based on Tpeak and current Toff
-double delineate::readjustToff(const arma::rowvec wave, annotation &anns, double rr, double rpeak) {
+double delineate::readjustToff(const arma::rowvec wave, annotation &anns, double rr, double rpeak, int toffMethod) {
 	if (anns.peak.size() < 1) return -1;    // no annotation
 	if (anns.peak[0] > anns.off) return -1; // incorrect toff
 	if (anns.peak[0] < rpeak) return -1;    // incorrect tpeak
@@ -463,7 +568,7 @@ double delineate::readjustToff(const arma::rowvec wave, annotation &anns, double
 
 	arma::rowvec lastCandidToff_segment = wave(arma::span(lastCandidate,adjusted_toff));
 
-	double toff_new = delineate::newToffFunc(lastCandidToff_segment, rr, rpeak, lastCandidate);
+	double toff_new = (toffMethod != 2) ? delineate::newToffFunc(lastCandidToff_segment, rr, rpeak, lastCandidate) : 0; // 2: keeps adjusted toff
 
 	return (toff_new > 0) ? toff_new : adjusted_toff;
 }
@@ -620,13 +725,8 @@ void delineate::smoothWaveFunc(arma::rowvec& wave, int windowSize){
 }
 
 /// cleans unwanted candidates
-void delineate::cleanUpCandidates(std::vector<candidate>& candids, std::vector<int>& indexCandidates) {
-	std::size_t i = 0;	
-	while(indexCandidates.size()) {
-		candids.erase(candids.begin() + indexCandidates.at(0) - i);
-		indexCandidates.erase(indexCandidates.begin());
-		++i;
-	}
+void delineate::cleanUpCandidates(candidateTable& candids, std::vector<int>& indexCandidates) {
+	candids.erase(indexCandidates); // removes one after the other (k-th index is shifted by k)
 	eraseList(indexCandidates); // clean up the container
 }
 
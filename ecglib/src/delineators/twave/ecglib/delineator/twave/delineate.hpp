@@ -72,13 +72,33 @@ namespace twaveDelineate {
 				 * @param minAmplitudeFlatness Delta amplitudes of flatness
 				 * @param minValidAmplitudePeak Threshsold of peak candidate that declares small angle
 				 * @param measurableVoltage Min threshsold of peak amplitude as a measurable signal
+				 * @param maxSlopeLevels Max number of moving zero crossing lines (0: no limit), levels are skipped evenly except around slope = 0
+				 * @param mergeCandidates Merges consecutive candidates that shape a flat candidate (step11)
 				 *
 				 * @return annotator Annotations of input twave
 				 */
 			annotation delineator(const arma::rowvec& twave, int pointStart, const std::vector<std::vector<double> >& featursThreshold,
 					int candidateFinderFlag = 1, double deltaStepSlope = 10, int looseWindow = 10, int minPoints = 10, double deltaAmplitude = 5, double minVoltageMainPeak = 150,
 	 				double percentMainePeak = 0.8, double minVoltage = 100, double percentPeak = 0.3, double maxDelatAplitudeNotches  = 50, 
-					double minAmplitudeFlatness = 7, double minValidAmplitudePeak = 7, double measurableVoltage = 100);
+					double minAmplitudeFlatness = 7, double minValidAmplitudePeak = 7, double measurableVoltage = 100, int maxSlopeLevels = 0, bool mergeCandidates = true);
+
+				/**
+				 * @brief Finds the twave delineations of several twaves at once
+				 *
+				 * Step01 (moving zero crossing lines) is calculated for all twaves together, one lane (column) per twave,
+				 * the rest of the steps are data dependent and continue per twave. Results are equal to calling delineator per twave.
+				 *
+			 	 * @param twaves Input filtered twaves
+				 * @param pointStarts Start point of each twave on its ecg signal
+				 *
+				 * The rest of parameters are the same as delineator of a single twave
+				 *
+				 * @return annotator Annotations of input twaves (same order)
+				 */
+			std::vector<annotation> delineator(const std::vector<arma::rowvec>& twaves, const std::vector<int>& pointStarts, const std::vector<std::vector<double> >& featursThreshold,
+					int candidateFinderFlag = 1, double deltaStepSlope = 10, int looseWindow = 10, int minPoints = 10, double deltaAmplitude = 5, double minVoltageMainPeak = 150,
+	 				double percentMainePeak = 0.8, double minVoltage = 100, double percentPeak = 0.3, double maxDelatAplitudeNotches  = 50, 
+					double minAmplitudeFlatness = 7, double minValidAmplitudePeak = 7, double measurableVoltage = 100, int maxSlopeLevels = 0, bool mergeCandidates = true);
 
 				/**
 				 * @brief Re-adjusts the end of twave based on tpeak and current toff
@@ -88,10 +108,11 @@ namespace twaveDelineate {
 			 	 * @param tpeaktoff_segment Input filtered wave (tpeak to toff segment)
 				 * @param rr Value of rr interval
 				 * @param rpeak Place of rpeak in an input wave (vcg)
+				 * @param toffMethod Energy/cost function search of toff (1) or just the adjusted toff of the max slope (2)
 				 *
 				 * @return new toff index or -1 if toff has problem
 				 */
-			double readjustToff(const arma::rowvec wave, annotation &anns, double rr, double rpeak);
+			double readjustToff(const arma::rowvec wave, annotation &anns, double rr, double rpeak, int toffMethod = 1);
 
 		private:
 				/**
@@ -102,8 +123,60 @@ namespace twaveDelineate {
 				 * @param movedZeroCrossingAmplitutedMax (out var)Map of derivative to a vector. this vector shows the amplitude of signal when derivative has intersection with moving zero crossing line
 				 * @param candidatePeaksPosition (out var)Shows the position of real peaks based on intersection of slope = 0 with first derivative
 				 * @param deltaStepSlope Interval value of derivativ steps for calculating the number of moving zero crossing line
+				 * @param maxSlopeLevels Max number of moving zero crossing lines (0: no limit)
+				 */
+			void candidateFinder(const arma::rowvec& wave, const arma::rowvec& derivative, arma::rowvec& movedZeroCrossingAmplitutedMax, arma::uvec& candidatePeaksPosition, double deltaStepSlope, int maxSlopeLevels = 0);
+
+				/**
+				 * @brief Finds twave delineation based on the candidates of twave (steps 02 - 16 of delineator)
+				 *
+			 	 * @param twave Input filtered twave
+			 	 * @param derivative (in/out var)First derivative of twave, cleared after use
+				 * @param pointStart Start point of a twave on a ecg signal
+				 * @param movedZeroCrossingAmplitutedPage (in/out var)Output of step01, cleared after use
+				 * @param candidatePeaksPosition (in/out var)Output of step01, cleared after use
+				 *
+				 * The rest of parameters are the same as delineator
+				 *
+				 * @return annotator Annotations of input twave
+				 */
+			annotation delineateCandidates(const arma::rowvec& twave, arma::rowvec& derivative, int pointStart, arma::rowvec& movedZeroCrossingAmplitutedPage, arma::uvec& candidatePeaksPosition,
+					const std::vector<std::vector<double> >& featursThreshold, int looseWindow, int minPoints, double deltaAmplitude, double minVoltageMainPeak, double percentMainePeak,
+					double minVoltage, double percentPeak, double maxDelatAplitudeNotches, double minAmplitudeFlatness, double minValidAmplitudePeak, double measurableVoltage, bool mergeCandidates);
+
+				/**
+				 * @brief Finds all candidates of several twaves (lanes) based on moving zero crossing line
+				 *
+			 	 * @param waves Input filtered waves
+				 * @param movedZeroCrossingAmplitutedMax (out var)Same as candidateFinder, one per wave
+				 * @param candidatePeaksPosition (out var)Same as candidateFinder, one per wave
+				 * @param deltaStepSlope Interval value of derivativ steps for calculating the number of moving zero crossing line
+				 * @param maxSlopeLevels Max number of moving zero crossing lines (0: no limit)
+				 */
+			void candidateFinderLanes(const std::vector<arma::rowvec>& waves, std::vector<arma::rowvec>& movedZeroCrossingAmplitutedMax, std::vector<arma::uvec>& candidatePeaksPosition, double deltaStepSlope, int maxSlopeLevels = 0);
+
+				/**
+				 * @brief Calculates the range of moving zero crossing lines of a first derivative
+				 *
+			 	 * @param derivative Clean first derivative
+				 * @param deltaStepSlope Interval value of derivativ steps
+				 * @param startingSlope (out var)Slope of the first line
+				 * @param numberSlope (out var)Number of lines
+				 * @param zeroSlopeIndex (out var)Index of the line with slope = 0
+				 */
+			void slopeLevels(const arma::rowvec& derivative, double deltaStepSlope, double& startingSlope, int& numberSlope, int& zeroSlopeIndex);
+
+				/**
+				 * @brief Finds the intersections of one moving zero crossing line with the first derivative
+				 *
+			 	 * @param signs Sign of (derivative - slope of line) for each point of derivative
+				 * @param n Number of points of derivative
+				 * @param peakLevel True if the line is around slope = 0
+				 * @param hit (in/out var)Intersections with derivative
+				 * @param peakHit (in/out var)Intersections with derivative around slope = 0
+				 * @param pending Scratch list of flat slopes
 				 */
-			void candidateFinder(const arma::rowvec& wave, const arma::rowvec& derivative, arma::rowvec& movedZeroCrossingAmplitutedMax, arma::uvec& candidatePeaksPosition, double deltaStepSlope);
+			void candidateSweep(const double* signs, int n, bool peakLevel, arma::rowvec& hit, arma::rowvec& peakHit, std::vector<int>& pending);
 
 				/**
 				 * @brief Finds all candidates of twave based on a clean (first/second) derivative vectore
@@ -120,25 +193,25 @@ namespace twaveDelineate {
 				 *
 			 	 * @param derivative Clean first derivative
 				 * @param movedZeroCrossingAmplitutedMax Intersection derivative with moving zero crossing line.
-				 * @param candids (in/out var)Vector of candidates
+				 * @param candids (in/out var)Table of candidates
 				 * @param looseWindow Defines minimum acceptale points of a candidate
 				 */
-			void candidateRangeInfoFinder(const arma::rowvec& derivative, const arma::rowvec& movedZeroCrossingAmplitutedMax, std::vector<candidate>& candids, const int looseWindow);
+			void candidateRangeInfoFinder(const arma::rowvec& derivative, const arma::rowvec& movedZeroCrossingAmplitutedMax, candidateTable& candids, const int looseWindow);
 
 				/**
 				 * @brief Adds labels (slur & peak) into candidates 
 				 *
-				 * @param candids (in/out var)Vector of candidates
+				 * @param candids (in/out var)Table of candidates
 				 * @param candidatePeaksPosition The position of real peaks on the first derivative
 				 */
-			void labellingPeaks(std::vector<candidate>& candids, const arma::uvec& candidatePeaksPosition);
+			void labellingPeaks(candidateTable& candids, const arma::uvec& candidatePeaksPosition);
 
 				/**
 				 * @brief Relabels slur candidates by slur, rising-slur & falling-slur
 				 *
-				 * @param candids (in/out var)Vector of candidates
+				 * @param candids (in/out var)Table of candidates
 				 */
-			void reLabellingSlurs(std::vector<candidate>& candids);
+			void reLabellingSlurs(candidateTable& candids);
 
 				/**
 				 * @brief Find new Toff based on energy/cost function
@@ -161,10 +234,10 @@ namespace twaveDelineate {
 				/**
 				 * @brief Remove part of candidates' vector
 				 *
-				 * @param candids (in/out var)Vector of candidates
+				 * @param candids (in/out var)Table of candidates
 				 * @param indexCandidates (in/out var)Candidates that should be removed
 				 */
-			void cleanUpCandidates(std::vector<candidate>& candids, std::vector<int>& indexCandidates);
+			void cleanUpCandidates(candidateTable& candids, std::vector<int>& indexCandidates);
 
 				/**
 				 * @brief Cleans a list
@@ -27,13 +27,13 @@
 using namespace ecglib::twaveDelineate;
 
 /// main function for finding delineators of a candidate
-void delineateFinder::delineatorsInfo(const arma::rowvec& wave, const arma::rowvec& derivative, candidate& candid, double deltaAmplitude) {
+void delineateFinder::delineatorsInfo(const arma::rowvec& wave, const arma::rowvec& derivative, candidateTable& candids, std::size_t candid, double deltaAmplitude) {
 
-	int waveStart = candid.get_candidateRangeInfo(0);
-	int waveEnd = candid.get_candidateRangeInfo(1);
+	int waveStart = candids.get_candidateRangeInfo(candid, 0);
+	int waveEnd = candids.get_candidateRangeInfo(candid, 1);
 
-	int risingRangeStart = candid.get_risingRangeInfo(0) - waveStart;
-	int risingRangeEnd = candid.get_risingRangeInfo(1) - waveStart;
+	int risingRangeStart = candids.get_risingRangeInfo(candid, 0) - waveStart;
+	int risingRangeEnd = candids.get_risingRangeInfo(candid, 1) - waveStart;
 	
 	arma::rowvec waveCandidate = wave(arma::span(waveStart, waveEnd));
 	arma::rowvec derivativeCandidate = derivative(arma::span(waveStart, waveEnd-1));
@@ -74,25 +74,25 @@ void delineateFinder::delineatorsInfo(const arma::rowvec& wave, const arma::rowv
 	x += risingRangeStart; // update x based on partial wave
 
 	/* step 04: preparation of candidate delineators*/
-	candid.set_a0(a0);
-	candid.set_b0(b0 - (a0*waveStart)); // recalculated based on waveStart
+	candids.set_a0(candid, a0);
+	candids.set_b0(candid, b0 - (a0*waveStart)); // recalculated based on waveStart
 
-	candid.set_a1(a1);
-	candid.set_b1(b1 - (a1*waveStart)); // recalculated based on waveStart
+	candids.set_a1(candid, a1);
+	candids.set_b1(candid, b1 - (a1*waveStart)); // recalculated based on waveStart
 
-	candid.set_x(x + waveStart); 	    // recalculated based on waveStart
-	candid.set_y(y);
+	candids.set_x(candid, x + waveStart); 	    // recalculated based on waveStart
+	candids.set_y(candid, y);
 
-	candid.set_xOrigin(xIntersect + waveStart); // recalculated based on waveStart
-	candid.set_yOrigin(yIntersect);
+	candids.set_xOrigin(candid, xIntersect + waveStart); // recalculated based on waveStart
+	candids.set_yOrigin(candid, yIntersect);
 
-	candid.set_flatnessSamples(flatness);
+	candids.set_flatnessSamples(candid, flatness);
 
-	candid.set_skewness(angleIntersect);
+	candids.set_skewness(candid, angleIntersect);
 
-	double peakDistX = std::pow(candid.get_x() - candid.get_xOrigin(), 2.);
-	double peakDistY = std::pow(candid.get_y() - candid.get_yOrigin(), 2.);
-	candid.set_distortion(std::sqrt(peakDistX + peakDistY));
+	double peakDistX = std::pow(candids.get_x(candid) - candids.get_xOrigin(candid), 2.);
+	double peakDistY = std::pow(candids.get_y(candid) - candids.get_yOrigin(candid), 2.);
+	candids.set_distortion(candid, std::sqrt(peakDistX + peakDistY));
 }
 
 /// linear regression
@@ -70,10 +70,11 @@ class delineateFinder {
 		 *
 	 	 * @param wave input twave 
 		 * @param derivative first derivative of twave
-		 * @param candid (out var) current candidate for finding delineators
+		 * @param candids (out var) candidate list
+		 * @param candid index of current candidate for finding delineators
 		 * @param deltaAmplitude threshold for finding real peak of candidate
 		 */
-		void delineatorsInfo(const arma::rowvec& wave, const arma::rowvec& derivative, candidate& candid, double deltaAmplitude);
+		void delineatorsInfo(const arma::rowvec& wave, const arma::rowvec& derivative, candidateTable& candids, std::size_t candid, double deltaAmplitude);
 
         /**
 		 * @brief Linear regression [x,y]
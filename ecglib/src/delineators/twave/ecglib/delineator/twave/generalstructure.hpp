@@ -25,7 +25,9 @@
 
 #include <string>
 #include <vector>
-#include <unordered_map>
+#include <array>
+#include <atomic>
+#include <ostream>
 namespace ecglib {
 namespace twaveDelineate {
 
@@ -34,6 +36,74 @@ namespace twaveDelineate {
 	 * @{
 	 */
 
+/**
+ * @brief rules (and flags) of twave delineation that are counted for each twave
+ */
+enum class rule : int {
+	fewPointsCandidates = 0,	/**< candidates removed for having few points */
+	lowAmplitudeMainPeak,		/**< candidates removed for a low amplitude main peak */
+	lowAmplitudePeaks,		/**< peaks removed for a low amplitude */
+	inconsistentPeaks,		/**< peaks removed for being far from the main peak amplitude */
+	unrelatedSlure,			/**< unrelated slurs removed */
+	meargingCandidates,		/**< pairs of candidates merged */
+	slurClassifier,			/**< slurs removed by the classifier */
+	keepJustTwoPeaks,		/**< peaks after the second peak */
+	convertPeakToSlur,		/**< peaks converted to slurs */
+	nonMeasurable,			/**< 1 if the signal is non-measurable */
+	hasDelineators,			/**< 1 if the twave got delineated */
+	count				/**< number of rules */
+};
+
+/**
+ * @brief Name of a rule for reporting
+ *
+ * @param r rule
+ *
+ * @return name of rule
+ */
+inline const char* ruleName(rule r) {
+	static const char* const names[static_cast<int>(rule::count)] = {"fewPointsCandidates", "lowAmplitudeMainPeak", "lowAmplitudePeaks", "inconsistentPeaks", "unrelatedSlure",
+		"meargingCandidates", "slurClassifier", "keepJustTwoPeaks", "convertPeakToSlur", "non-measurable", "hasDelineators"};
+	int i = static_cast<int>(r);
+	return (i >= 0 && i < static_cast<int>(rule::count)) ? names[i] : "";
+}
+
+/**
+ * @brief Number of hits of each rule for one twave, indexed by rule
+ */
+struct ruleCounters {
+	public:
+		/**
+		 * @brief constructor of class (all counters are zero)
+		 */
+		ruleCounters() { clear(); }
+
+		/**
+		 * @brief counter of a rule
+		 */
+		unsigned int& operator[](rule r) { return _hits[static_cast<int>(r)]; }
+
+		/**
+		 * @brief counter of a rule
+		 */
+		unsigned int operator[](rule r) const { return _hits[static_cast<int>(r)]; }
+
+		/**
+		 * @brief number of rules
+		 */
+		static constexpr std::size_t size() { return static_cast<std::size_t>(rule::count); }
+
+		/**
+		 * @brief sets all counters to zero
+		 */
+		void clear() { _hits.fill(0); }
+	private:
+		/**
+		 * @brief counters
+		 */
+		std::array<unsigned int, static_cast<std::size_t>(rule::count)> _hits;
+};
+
 /**
  * @brief annotators' exposure of Twave to out side
  */
@@ -68,23 +138,132 @@ struct annotation {
 		 */
 		std::vector<double> skewness;
 		/**
-		 * @brief map of <rule, number of hit>
+		 * @brief toff based on max slope of last candidate (before re-adjusting toff)
 		 */
-		std::unordered_map<std::string,unsigned int> rulesHit;
+		double toff_maxslope;
+		/**
+		 * @brief number of hit of each rule
+		 */
+		ruleCounters rulesHit;
 	public:
 		/**
 		 * @brief constructor of class
 		 */
-		annotation(): on(-1), off(-1) { clear();}
+		annotation(): on(-1), off(-1), toff_maxslope(-1) { clear();}
 
 		/**
 		 * @brief destructor of class
 		 */
-		~annotation() {peak.clear(); flatness.clear(); distortion.clear(); skewness.clear(); rulesHit.clear();}
+		~annotation() {peak.clear(); flatness.clear(); distortion.clear(); skewness.clear();}
 		/**
 		 * @brief sets all parameters into default value
 		 */
-		void clear() {on = -1; off = -1; peak.clear(); flatness.clear(); distortion.clear(); skewness.clear(); rulesHit.clear();}
+		void clear() {on = -1; off = -1; toff_maxslope = -1; peak.clear(); flatness.clear(); distortion.clear(); skewness.clear(); rulesHit.clear();}
+};
+
+/**
+ * @brief Aggregated rule hits over many twaves (e.g. all beats of a study)
+ *
+ * Counters are atomic, so one instance can be shared by threads delineating different beats without locking.
+ * For each rule it keeps the total number of hits, the number of twaves with at least one hit and a histogram of hits per twave.
+ */
+class ruleStatistics {
+	public:
+		/**
+		 * @brief number of bins of histograms, the last bin counts twaves with (nbins-1) hits or more
+		 */
+		static constexpr std::size_t nbins = 8;
+
+		/**
+		 * @brief constructor of class
+		 */
+		ruleStatistics() { clear(); }
+
+		/**
+		 * @brief adds rule hits of a twave
+		 *
+		 * @param anns annotation of twave
+		 */
+		void add(const annotation& anns) {
+			_ntwaves.fetch_add(1, std::memory_order_relaxed);
+			for (std::size_t r = 0; r < ruleCounters::size(); ++r) {
+				unsigned int hits = anns.rulesHit[static_cast<rule>(r)];
+				if (hits > 0) {
+					_hits[r].fetch_add(hits, std::memory_order_relaxed);
+					_twaves[r].fetch_add(1, std::memory_order_relaxed);
+				}
+				_histogram[r][hits < nbins ? hits : nbins-1].fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		/**
+		 * @brief resets all counters (should not run concurrently with add)
+		 */
+		void clear() {
+			_ntwaves.store(0, std::memory_order_relaxed);
+			for (std::size_t r = 0; r < ruleCounters::size(); ++r) {
+				_hits[r].store(0, std::memory_order_relaxed);
+				_twaves[r].store(0, std::memory_order_relaxed);
+				for (std::size_t b = 0; b < nbins; ++b) _histogram[r][b].store(0, std::memory_order_relaxed);
+			}
+		}
+
+		/**
+		 * @brief number of added twaves
+		 */
+		unsigned long ntwaves() const { return _ntwaves.load(std::memory_order_relaxed); }
+
+		/**
+		 * @brief total number of hits of a rule
+		 */
+		unsigned long hits(rule r) const { return _hits[static_cast<int>(r)].load(std::memory_order_relaxed); }
+
+		/**
+		 * @brief number of twaves with at least one hit of a rule
+		 */
+		unsigned long twaves(rule r) const { return _twaves[static_cast<int>(r)].load(std::memory_order_relaxed); }
+
+		/**
+		 * @brief number of twaves with a given number of hits of a rule
+		 *
+		 * @param r rule
+		 * @param bin number of hits (bins >= nbins-1 are merged into the last bin)
+		 */
+		unsigned long histogram(rule r, std::size_t bin) const { return _histogram[static_cast<int>(r)][bin < nbins ? bin : nbins-1].load(std::memory_order_relaxed); }
+
+		/**
+		 * @brief writes a csv report: RULE,TWAVES,HITS,H0,...,H(nbins-1)
+		 *
+		 * @param os output stream
+		 */
+		void report(std::ostream& os) const {
+			os << "RULE,TWAVES,HITS";
+			for (std::size_t b = 0; b < nbins; ++b) os << ",H" << b;
+			os << std::endl;
+			for (std::size_t r = 0; r < ruleCounters::size(); ++r) {
+				os << ruleName(static_cast<rule>(r)) << "," << twaves(static_cast<rule>(r)) << "," << hits(static_cast<rule>(r));
+				for (std::size_t b = 0; b < nbins; ++b) os << "," << histogram(static_cast<rule>(r), b);
+				os << std::endl;
+			}
+		}
+
+	private:
+		/**
+		 * @brief number of added twaves
+		 */
+		std::atomic<unsigned long> _ntwaves;
+		/**
+		 * @brief total hits per rule
+		 */
+		std::array<std::atomic<unsigned long>, static_cast<std::size_t>(rule::count)> _hits;
+		/**
+		 * @brief twaves with hits per rule
+		 */
+		std::array<std::atomic<unsigned long>, static_cast<std::size_t>(rule::count)> _twaves;
+		/**
+		 * @brief histogram of hits per twave for each rule
+		 */
+		std::array<std::array<std::atomic<unsigned long>, nbins>, static_cast<std::size_t>(rule::count)> _histogram;
 };
 
 /**
@@ -93,117 +272,219 @@ struct annotation {
 enum candidateLabel {slurUnrelated = 0, slurRising = 1, slurFalling = -1, peak = 2, peakUnrelated = -2, sluredPeak = 3, sluredPeakUnrelated = -3}; // different label value of a candidate
 
 /**
- * @brief details information of a candidate
+ * @brief details information of all candidates of a twave, stored column-wise (one contiguous array per field, one row per candidate)
  */
-struct candidate {
+struct candidateTable {
 	private:
 		/**
-		 * @brief lable of candidate contains: (0) unrelated slur(default val), (1) rising slur, (-1) falling slur, (2) peak, (-2) unrelated peak
+		 * @brief lable of candidates contains: (0) unrelated slur(default val), (1) rising slur, (-1) falling slur, (2) peak, (-2) unrelated peak
 		 */
-		candidateLabel _label;
+		std::vector<int> _label;
 
 		// Y = aX + b: is a line that can be fitted to the candidate based on a pre-defined criteria of 'max slope'
 		/**
-		 * @brief rising slope
+		 * @brief rising slopes
 		 */
-		double _a0;
+		std::vector<double> _a0;
 		/**
-		 * @brief rising intercept
+		 * @brief rising intercepts
 		 */
-		double _b0;
+		std::vector<double> _b0;
 		/**
 		 * @brief falling slopes
 		 */
-		double _a1;
+		std::vector<double> _a1;
 		/**
-		 * @brief falling intercept
+		 * @brief falling intercepts
 		 */
-		double _b1;
+		std::vector<double> _b1;
 
 		/**
-		 * @brief max amplitude of candidate
+		 * @brief max amplitude of candidates
 		 */
-		double _y;
+		std::vector<double> _y;
 		/**
-		 * @brief index (time) of max amplitude of candidate
+		 * @brief index (time) of max amplitude of candidates
 		 */
-		int _x;
+		std::vector<int> _x;
 		/**
-		 * @brief max amplitude of imaginary candidate based on fitted line
+		 * @brief max amplitude of imaginary candidates based on fitted line
 		 */
-		double _yOrigin;
+		std::vector<double> _yOrigin;
 		/**
-		 * @brief index (time) of max amplitude of imaginary candidate based on fitted line
+		 * @brief index (time) of max amplitude of imaginary candidates based on fitted line
 		 */
-		int _xOrigin;
+		std::vector<int> _xOrigin;
 		/**
 		 * @brief number of samples which shape '_y'
 		 */
-		double _flatnessSamples;
+		std::vector<double> _flatnessSamples;
 		/**
-		 * @brief skewness of candidate; rotation of fitted lines from vertical line
+		 * @brief skewness of candidates; rotation of fitted lines from vertical line
 		 */
-		double _skewness;
+		std::vector<double> _skewness;
 		/**
-		 * @brief distortion of candidate; euclidean distance of candidate from candidate's origin
+		 * @brief distortion of candidates; euclidean distance of candidate from candidate's origin
 		 */
-		double _distortion;
+		std::vector<double> _distortion;
 		/**
-		 * @brief start point and end point of a candidate
+		 * @brief start point and end point of candidates
 		 */
-		int _risingRangeInfo[2];// [0]: start point of rising slope of candidate based on first derivative && [1]: end point of rising slope of candidate based on derivative
+		std::vector<int> _risingRangeInfo[2];// [0]: start point of rising slope of candidate based on first derivative && [1]: end point of rising slope of candidate based on derivative
 					//	It shows the start point of rising edge of candidate till peak of the candidate 		
 		/**
-		 * @brief start poin and end point of a candidate based on respective candidates
+		 * @brief start poin and end point of candidates based on respective candidates
 		 */
-		int _candidateRangeInfo[2];// [0]: start point of candidate range based on previous candidate on a real signal && [1]: end point of candidate range based on next candidate on a real signal 
+		std::vector<int> _candidateRangeInfo[2];// [0]: start point of candidate range based on previous candidate on a real signal && [1]: end point of candidate range based on next candidate on a real signal 
 					   // 	It covers _risingRangeInfo containing rising edge/peak/falling edge. The start points gets started from last sample of end point of previous candidate
+
+		/**
+		 * @brief columns of real values
+		 */
+		std::array<std::vector<double>*, 9> doubleColumns() {
+			return {{&_a0, &_b0, &_a1, &_b1, &_y, &_yOrigin, &_flatnessSamples, &_skewness, &_distortion}};
+		}
+
+		/**
+		 * @brief columns of integer values
+		 */
+		std::array<std::vector<int>*, 7> intColumns() {
+			return {{&_label, &_x, &_xOrigin, &_risingRangeInfo[0], &_risingRangeInfo[1], &_candidateRangeInfo[0], &_candidateRangeInfo[1]}};
+		}
+
 		/**
-		 * @brief feature set of candidate for classifier
+		 * @brief keeps the rows of a column given by keep (increasing order)
 		 */
-		std::vector<double> _featureSet;
+		template<class T>
+		static void gather(std::vector<T> &c, const std::vector<std::size_t> &keep) {
+			for (std::size_t i = 0; i < keep.size(); ++i) c[i] = c[keep[i]];
+			c.resize(keep.size());
+		}
 
 	public:
 		/**
 		 * @brief constructor of class
+		 *
+		 * @param n number of candidates to reserve room for
+		 */
+		explicit candidateTable(std::size_t n = 32) { reserve(n); }
+
+		/**
+		 * @brief number of candidates
+		 */
+		std::size_t size() const { return _label.size(); }
+
+		/**
+		 * @brief true if there is not any candidate
+		 */
+		bool empty() const { return _label.empty(); }
+
+		/**
+		 * @brief removes all candidates (keeps the reserved room)
+		 */
+		void clear() {
+			for (std::vector<double> *c : doubleColumns()) c->clear();
+			for (std::vector<int> *c : intColumns()) c->clear();
+		}
+
+		/**
+		 * @brief reserves room for n candidates in every column
+		 *
+		 * @param n number of candidates
 		 */
-		candidate(): _label(candidateLabel::slurUnrelated), _a0(0), _b0(0), _a1(0), _b1(0), _y(0), _x(0), _yOrigin(0), _xOrigin(0), _flatnessSamples(0), _skewness(0), _distortion(0) {} 
+		void reserve(std::size_t n) {
+			for (std::vector<double> *c : doubleColumns()) c->reserve(n);
+			for (std::vector<int> *c : intColumns()) c->reserve(n);
+		}
+
+		/**
+		 * @brief appends a candidate with default values
+		 *
+		 * @return index of the new candidate
+		 */
+		std::size_t push_back() { return insert(size()); }
+
+		/**
+		 * @brief inserts a candidate with default values before pos
+		 *
+		 * @param pos index of the new candidate
+		 *
+		 * @return index of the new candidate
+		 */
+		std::size_t insert(std::size_t pos) {
+			for (std::vector<double> *c : doubleColumns()) c->insert(c->begin() + pos, 0.);
+			for (std::vector<int> *c : intColumns()) c->insert(c->begin() + pos, 0); // label 0: slurUnrelated
+			return pos;
+		}
+
+		/**
+		 * @brief removes candidates one after the other, i.e. the k-th index refers to the table in which the k previous candidates are already removed and is shifted by k
+		 *
+		 * @param indexCandidates index of candidates
+		 */
+		void erase(const std::vector<int>& indexCandidates) {
+			if (indexCandidates.empty()) return;
+
+			// rows that survive the removals (in increasing order)
+			std::vector<std::size_t> keep(size());
+			for (std::size_t i = 0; i < keep.size(); ++i) keep[i] = i;
+			for (std::size_t k = 0; k < indexCandidates.size(); ++k) {
+				keep.erase(keep.begin() + indexCandidates[k] - k);
+			}
+
+			// gathers the surviving rows in place
+			for (std::vector<double> *c : doubleColumns()) gather(*c, keep);
+			for (std::vector<int> *c : intColumns()) gather(*c, keep);
+		}
 
 		// set functions
-		void set_label(candidateLabel val) { _label = val;}
-		void set_a0(double val) { _a0 = val;}
-		void set_b0(double val) { _b0 = val;}
-		void set_a1(double val) { _a1 = val;}
-		void set_b1(double val) { _b1 = val;}
-		void set_y(double val)  { _y = val;}
-		void set_x(int val)     { _x = val;}
-		void set_yOrigin(double val) { _yOrigin = val;}
-		void set_xOrigin(int val)    { _xOrigin = val;}
-		void set_flatnessSamples(int val) { _flatnessSamples = val;}
-		void set_skewness(double val)     { _skewness = val;}
-		void set_distortion(double val)   { _distortion = val;}
-		void set_risingRangeInfo(int val, int index)    {index = (index >= 1) ? 1 : 0; _risingRangeInfo[index] = val;}
-		void set_candidateRangeInfo(int val, int index) {index = (index >= 1) ? 1 : 0; _candidateRangeInfo[index] = val;}
-		void set_featureSet(std::vector<double> val)	{_featureSet = val;}
+		void set_label(std::size_t i, candidateLabel val) { _label[i] = val;}
+		void set_a0(std::size_t i, double val) { _a0[i] = val;}
+		void set_b0(std::size_t i, double val) { _b0[i] = val;}
+		void set_a1(std::size_t i, double val) { _a1[i] = val;}
+		void set_b1(std::size_t i, double val) { _b1[i] = val;}
+		void set_y(std::size_t i, double val)  { _y[i] = val;}
+		void set_x(std::size_t i, int val)     { _x[i] = val;}
+		void set_yOrigin(std::size_t i, double val) { _yOrigin[i] = val;}
+		void set_xOrigin(std::size_t i, int val)    { _xOrigin[i] = val;}
+		void set_flatnessSamples(std::size_t i, int val) { _flatnessSamples[i] = val;}
+		void set_skewness(std::size_t i, double val)     { _skewness[i] = val;}
+		void set_distortion(std::size_t i, double val)   { _distortion[i] = val;}
+		void set_risingRangeInfo(std::size_t i, int val, int index)    {index = (index >= 1) ? 1 : 0; _risingRangeInfo[index][i] = val;}
+		void set_candidateRangeInfo(std::size_t i, int val, int index) {index = (index >= 1) ? 1 : 0; _candidateRangeInfo[index][i] = val;}
 
 		// get functions
-		candidateLabel    get_label() const	{ return _label;}
-		double get_a0() const		{ return _a0;}
-		double get_b0() const		{ return _b0;}
-		double get_a1() const		{ return _a1;}
-		double get_b1()	const		{ return _b1;}
-		double get_y()	const		{ return _y;}
-		int    get_x()  const		{ return _x;}
-		double get_yOrigin() const	{ return _yOrigin;}
-		int    get_xOrigin() const	{ return _xOrigin;}
-		double get_flatnessSamples() const { return _flatnessSamples;}
-		double get_skewness()	const	{ return _skewness;}
-		double get_distortion()	const	{ return _distortion;}
-		int		get_risingRangeInfo(const int index) const {return _risingRangeInfo[(index >= 1) ? 1 : 0];}
-		int		get_candidateRangeInfo(const int index)	const {return _candidateRangeInfo[(index >= 1) ? 1 : 0];}
-		std::vector<double> get_featureSet()	const {return _featureSet;}
-	};
+		candidateLabel    get_label(std::size_t i) const	{ return static_cast<candidateLabel>(_label[i]);}
+		double get_a0(std::size_t i) const		{ return _a0[i];}
+		double get_b0(std::size_t i) const		{ return _b0[i];}
+		double get_a1(std::size_t i) const		{ return _a1[i];}
+		double get_b1(std::size_t i) const		{ return _b1[i];}
+		double get_y(std::size_t i) const		{ return _y[i];}
+		int    get_x(std::size_t i) const		{ return _x[i];}
+		double get_yOrigin(std::size_t i) const	{ return _yOrigin[i];}
+		int    get_xOrigin(std::size_t i) const	{ return _xOrigin[i];}
+		double get_flatnessSamples(std::size_t i) const { return _flatnessSamples[i];}
+		double get_skewness(std::size_t i) const	{ return _skewness[i];}
+		double get_distortion(std::size_t i) const	{ return _distortion[i];}
+		int		get_risingRangeInfo(std::size_t i, const int index) const {return _risingRangeInfo[(index >= 1) ? 1 : 0][i];}
+		int		get_candidateRangeInfo(std::size_t i, const int index) const {return _candidateRangeInfo[(index >= 1) ? 1 : 0][i];}
 
+		// column functions
+		const std::vector<int>& labels() const	{ return _label;}
+		const std::vector<double>& a0() const	{ return _a0;}
+		const std::vector<double>& b0() const	{ return _b0;}
+		const std::vector<double>& a1() const	{ return _a1;}
+		const std::vector<double>& b1() const	{ return _b1;}
+		const std::vector<double>& y() const	{ return _y;}
+		const std::vector<int>& x() const	{ return _x;}
+		const std::vector<double>& yOrigin() const	{ return _yOrigin;}
+		const std::vector<int>& xOrigin() const	{ return _xOrigin;}
+		const std::vector<double>& flatnessSamples() const { return _flatnessSamples;}
+		const std::vector<double>& skewness() const	{ return _skewness;}
+		const std::vector<double>& distortion() const	{ return _distortion;}
+		const std::vector<int>& risingRangeInfo(const int index) const {return _risingRangeInfo[(index >= 1) ? 1 : 0];}
+		const std::vector<int>& candidateRangeInfo(const int index) const {return _candidateRangeInfo[(index >= 1) ? 1 : 0];}
+	};
 }
 
 /*!
@@ -33,11 +33,13 @@ using namespace ecglib::twaveDelineate;
 /*                          */
 
 /// finds candidates with few number of points in X axes (time)
-std::vector<int> preProcessingRules::fewPointsCandidates(const std::vector<candidate>& candids, double minPoints) {
+std::vector<int> preProcessingRules::fewPointsCandidates(const candidateTable& candids, double minPoints) {
 
 	std::vector<int> indexCandidates;
+	const std::vector<int>& risingStart = candids.risingRangeInfo(0);
+	const std::vector<int>& risingEnd = candids.risingRangeInfo(1);
 	for(std::size_t i = 0; i < candids.size(); ++i) {
-		if ((candids[i].get_risingRangeInfo(1) - candids[i].get_risingRangeInfo(0)) < minPoints) {
+		if ((risingEnd[i] - risingStart[i]) < minPoints) {
 			indexCandidates.push_back(i);
 		}
 	}
@@ -50,7 +52,7 @@ std::vector<int> preProcessingRules::fewPointsCandidates(const std::vector<candi
 /*                          */
 
 ///  finds candidates in a certain percentage lower than main peak, if its amplitued is too low
-std::vector<int> postProcessingRules::lowAmplitudeMainPeak(const std::vector<candidate>& candids, double minValidAmplitudeMainPeak, double percentMainePeak) {
+std::vector<int> postProcessingRules::lowAmplitudeMainPeak(const candidateTable& candids, double minValidAmplitudeMainPeak, double percentMainePeak) {
 
 	std::vector<int> allCandidates; // index of candidates
 
@@ -61,8 +63,9 @@ std::vector<int> postProcessingRules::lowAmplitudeMainPeak(const std::vector<can
 	postProcessingRules::mainPeak(candids, indexPeakCandidates, mainPeakIndex, mainPeakAmplitude); // main peak
 
 	if (mainPeakAmplitude < minValidAmplitudeMainPeak) {
-		for (std::size_t i = 0; i < candids.size(); ++i) {
-			if (candids[i].get_y() < mainPeakAmplitude*percentMainePeak) {
+		const std::vector<double>& y = candids.y();
+		for (std::size_t i = 0; i < y.size(); ++i) {
+			if (y[i] < mainPeakAmplitude*percentMainePeak) {
 				allCandidates.push_back(i);
 			}
 		}
@@ -72,7 +75,7 @@ std::vector<int> postProcessingRules::lowAmplitudeMainPeak(const std::vector<can
 }
 
 /// finds peak candidates with lower amplitude in compare with a percentage of highest peak and minimum valid amplitude
-std::vector<int> postProcessingRules::lowAmplitudePeaks(const std::vector<candidate>& candids, double minValidAmplitude, double percentPeak) {
+std::vector<int> postProcessingRules::lowAmplitudePeaks(const candidateTable& candids, double minValidAmplitude, double percentPeak) {
 
 	std::vector<int> indexPeakCandidates = postProcessingRules::peakCandidates(candids); // index of peak candidates
 
@@ -82,7 +85,7 @@ std::vector<int> postProcessingRules::lowAmplitudePeaks(const std::vector<candid
 
 	std::vector<int> indexLowAmplitude; // index of peak candidates	with low amplitude
 	for(std::size_t i = 0; i < indexPeakCandidates.size(); ++i) {
-		double peakMostlySlur = (mainPeakAmplitude > minValidAmplitude) ? (mainPeakAmplitude - minValidAmplitude) * percentPeak - (candids[indexPeakCandidates[i]].get_y() - minValidAmplitude) : mainPeakAmplitude * (1-percentPeak) - candids[indexPeakCandidates[i]].get_y();
+		double peakMostlySlur = (mainPeakAmplitude > minValidAmplitude) ? (mainPeakAmplitude - minValidAmplitude) * percentPeak - (candids.get_y(indexPeakCandidates[i]) - minValidAmplitude) : mainPeakAmplitude * (1-percentPeak) - candids.get_y(indexPeakCandidates[i]);
 		if (peakMostlySlur > 5e-3) { // 5e-3 == 0.004 just for sanity check
 			indexLowAmplitude.push_back(indexPeakCandidates[i]);
 		}
@@ -92,7 +95,7 @@ std::vector<int> postProcessingRules::lowAmplitudePeaks(const std::vector<candid
 }
 
 /// finds peaks are not close to main peak in terms of amplitude
-std::vector<int> postProcessingRules::inconsistentPeaks(const std::vector<candidate>& candids, double maxDelatAplitudeNotches) {
+std::vector<int> postProcessingRules::inconsistentPeaks(const candidateTable& candids, double maxDelatAplitudeNotches) {
 
 	std::vector<int> indexInconsistentPeaks;
 	std::vector<int> indexPeakCandidates = postProcessingRules::peakCandidates(candids); // index of peak candidates
@@ -102,7 +105,7 @@ std::vector<int> postProcessingRules::inconsistentPeaks(const std::vector<candid
 	postProcessingRules::mainPeak(candids, indexPeakCandidates, mainPeakIndex, mainPeakAmplitude); // main peak
 
 	for  (std::size_t i = 0; i < indexPeakCandidates.size(); ++i) {
-		double deltaAmplitudePeaks = mainPeakAmplitude - candids[indexPeakCandidates[i]].get_y();
+		double deltaAmplitudePeaks = mainPeakAmplitude - candids.get_y(indexPeakCandidates[i]);
 		if (deltaAmplitudePeaks > maxDelatAplitudeNotches) {
 			indexInconsistentPeaks.push_back(indexPeakCandidates[i]);
 		}
@@ -111,68 +114,68 @@ std::vector<int> postProcessingRules::inconsistentPeaks(const std::vector<candid
 }
 
 /// finds slur candidates
-std::vector<int> postProcessingRules::unrelatedSlure(const std::vector<candidate>& candids) {
+std::vector<int> postProcessingRules::unrelatedSlure(const candidateTable& candids) {
 	std::vector<int> slurIndex = postProcessingRules::slurCandidates(candids); // index of slur candidates
 	return slurIndex;
 }
 
 /// merges two consequent condidates if they are close in terms of amplitude
-std::vector<int> postProcessingRules::meargingCandidates(const arma::rowvec& wave, std::vector<candidate>& candids, double minAmplitudeFlatness){
+std::vector<int> postProcessingRules::meargingCandidates(const arma::rowvec& wave, candidateTable& candids, double minAmplitudeFlatness){
 
 	std::vector<int> indexMargedCandidates;
 	std::size_t i = 1;
 	while(i < candids.size()) {
-		if (candids[i].get_label() != 0 && candids[i-1].get_label() != 0) {
-			if (abs(candids[i].get_label()) != 1 || abs(candids[i-1].get_label()) != 1) {
+		if (candids.get_label(i) != 0 && candids.get_label(i-1) != 0) {
+			if (abs(candids.get_label(i)) != 1 || abs(candids.get_label(i-1)) != 1) {
 				int xIntersect = 0;
-				postProcessingRules::intersectionTwoCandidates(candids[i-1], candids[i], xIntersect);
+				postProcessingRules::intersectionTwoCandidates(candids, i-1, i, xIntersect);
 
-                		if ((std::max(candids[i-1].get_y(), candids[i].get_y()) - wave[xIntersect] < minAmplitudeFlatness) && (std::abs(candids[i-1].get_y() - candids[i].get_y()) < minAmplitudeFlatness)) {
+                		if ((std::max(candids.get_y(i-1), candids.get_y(i)) - wave[xIntersect] < minAmplitudeFlatness) && (std::abs(candids.get_y(i-1) - candids.get_y(i)) < minAmplitudeFlatness)) {
 
-					candidate mergedCandidate;
-					mergedCandidate.set_a0(candids[i-1].get_a0());
-					mergedCandidate.set_b0(candids[i-1].get_b0());
+					// the new merged candidate is added to rest of candidates (after the two merged ones)
+					std::size_t m = candids.insert(i+1);
+					candids.set_a0(m, candids.get_a0(i-1));
+					candids.set_b0(m, candids.get_b0(i-1));
 
-					mergedCandidate.set_a1(candids[i].get_a1());
-					mergedCandidate.set_b1(candids[i].get_b1());
+					candids.set_a1(m, candids.get_a1(i));
+					candids.set_b1(m, candids.get_b1(i));
 
-					mergedCandidate.set_x(std::trunc((candids[i-1].get_x() + candids[i].get_x())/2));
-					mergedCandidate.set_y(wave[mergedCandidate.get_x()]);
+					candids.set_x(m, std::trunc((candids.get_x(i-1) + candids.get_x(i))/2));
+					candids.set_y(m, wave[candids.get_x(m)]);
 
-					mergedCandidate.set_flatnessSamples(candids[i].get_x() - candids[i-1].get_x() +1 + std::round((candids[i].get_flatnessSamples() + candids[i-1].get_flatnessSamples())/2));
+					candids.set_flatnessSamples(m, candids.get_x(i) - candids.get_x(i-1) +1 + std::round((candids.get_flatnessSamples(i) + candids.get_flatnessSamples(i-1))/2));
 
-					mergedCandidate.set_candidateRangeInfo(candids[i-1].get_candidateRangeInfo(0), 0);
-					mergedCandidate.set_candidateRangeInfo(candids[i].get_candidateRangeInfo(1), 1);
+					candids.set_candidateRangeInfo(m, candids.get_candidateRangeInfo(i-1, 0), 0);
+					candids.set_candidateRangeInfo(m, candids.get_candidateRangeInfo(i, 1), 1);
 
-					mergedCandidate.set_risingRangeInfo(candids[i-1].get_risingRangeInfo(0), 0);
-					mergedCandidate.set_risingRangeInfo(candids[i].get_risingRangeInfo(1), 1);
+					candids.set_risingRangeInfo(m, candids.get_risingRangeInfo(i-1, 0), 0);
+					candids.set_risingRangeInfo(m, candids.get_risingRangeInfo(i, 1), 1);
 
 					// re-calculates of peak origin based on new merged slopes line
 					int xIntersect(0);
 					double yIntersect(0), angleIntersect(0);
 					delineateFinder delineat;
-					delineat.peakOriginFinder(wave(arma::span(mergedCandidate.get_candidateRangeInfo(0),mergedCandidate.get_candidateRangeInfo(1))),
-									mergedCandidate.get_candidateRangeInfo(0), mergedCandidate.get_a0(), mergedCandidate.get_b0(), mergedCandidate.get_a1(), 
-									mergedCandidate.get_b1(), xIntersect, yIntersect, angleIntersect);			
+					delineat.peakOriginFinder(wave(arma::span(candids.get_candidateRangeInfo(m, 0),candids.get_candidateRangeInfo(m, 1))),
+									candids.get_candidateRangeInfo(m, 0), candids.get_a0(m), candids.get_b0(m), candids.get_a1(m), 
+									candids.get_b1(m), xIntersect, yIntersect, angleIntersect);			
 
-					mergedCandidate.set_xOrigin(xIntersect);
-					mergedCandidate.set_yOrigin(yIntersect);
+					candids.set_xOrigin(m, xIntersect);
+					candids.set_yOrigin(m, yIntersect);
 
-					mergedCandidate.set_skewness(angleIntersect);
+					candids.set_skewness(m, angleIntersect);
 
-					double peakDistX = std::pow(mergedCandidate.get_x() - mergedCandidate.get_xOrigin(), 2.);
-					double peakDistY = std::pow(mergedCandidate.get_y() - mergedCandidate.get_yOrigin(), 2.);
-					mergedCandidate.set_distortion(std::sqrt(peakDistX + peakDistY));
+					double peakDistX = std::pow(candids.get_x(m) - candids.get_xOrigin(m), 2.);
+					double peakDistY = std::pow(candids.get_y(m) - candids.get_yOrigin(m), 2.);
+					candids.set_distortion(m, std::sqrt(peakDistX + peakDistY));
 
-					mergedCandidate.set_label(candidateLabel::peak);
+					candids.set_label(m, candidateLabel::peak);
 
 					// these two indexes should be removed
 					indexMargedCandidates.push_back(i-1);
 					indexMargedCandidates.push_back(i);
 
-					// the new merged candidate should be added to rest of candidates
-					candids.insert(candids.begin() + i+1, mergedCandidate);
-					++i;
+					++i; // skips the new merged candidate
+
 				}
 			}
 		}
@@ -182,7 +185,7 @@ std::vector<int> postProcessingRules::meargingCandidates(const arma::rowvec& wav
 }
 
 /// distinguishes between good slur and bad slur based on classification rules
-std::vector<int> postProcessingRules::slurClassifier(const std::vector<candidate>& candids, const std::vector<std::vector<double> >& featursThreshold) {		
+std::vector<int> postProcessingRules::slurClassifier(const candidateTable& candids, const std::vector<std::vector<double> >& featursThreshold) {		
 
 	// making feature set for classifying slur_peak to distinguish between slur and non-slur (bad slur)
 	// if the output of classifier is 1: slur should be removed.
@@ -207,31 +210,31 @@ std::vector<int> postProcessingRules::slurClassifier(const std::vector<candidate
 
 		int s = slurIndex[i]; // s: slur index
 		int p = s; 	      // p: peak index
-		if (candids[s].get_label() == 1)
+		if (candids.get_label(s) == 1)
 			p = p + 1;
-		else if (candids[s].get_label() == -1)
+		else if (candids.get_label(s) == -1)
 		    	p = p - 1;
 
-		double at2_1 = std::atan(candids[s].get_a0())*dpi;   // slur
-		double at2_2 = std::atan(candids[s].get_a1())*dpi;   // slur
+		double at2_1 = std::atan(candids.get_a0(s))*dpi;   // slur
+		double at2_2 = std::atan(candids.get_a1(s))*dpi;   // slur
 
-		double at1_1 = std::atan(candids[p].get_a0())*dpi;   // peak
-		double at1_2 = std::atan(candids[p].get_a1())*dpi;   // peak
+		double at1_1 = std::atan(candids.get_a0(p))*dpi;   // peak
+		double at1_2 = std::atan(candids.get_a1(p))*dpi;   // peak
 
 		featureSet.push_back(std::abs(at2_1 - at2_2));				   // F0: angle between two slopes of slur 
 
-		if (candids[s].get_label() == 1)					   // F1: angle between slopes of slur and peak
+		if (candids.get_label(s) == 1)					   // F1: angle between slopes of slur and peak
 		    featureSet.push_back(std::abs(at1_1 - at2_1));
-		else if (candids[s].get_label() == -1)
+		else if (candids.get_label(s) == -1)
 		    featureSet.push_back(std::abs(at1_2 - at2_2));
 
-		featureSet.push_back(candids[p].get_y()/candids[s].get_yOrigin());	   // F2: ratio between amplitude of peak and slur
+		featureSet.push_back(candids.get_y(p)/candids.get_yOrigin(s));	   // F2: ratio between amplitude of peak and slur
 		/*
-		featureSet.push_back(candids[s].get_yOrigin());				   // F3: amplitude of slur
+		featureSet.push_back(candids.get_yOrigin(s));				   // F3: amplitude of slur
 
 		int xIntersect = 0;
 		postProcessingRules::intersectionTwoCandidates(candids(p), candids(s), xIntersect);
-		featureSet.push_back(std::abs(candids[s].get_xOrigin() - xIntersect));  // F4: distance between slur and interconnection
+		featureSet.push_back(std::abs(candids.get_xOrigin(s) - xIntersect));  // F4: distance between slur and interconnection
 
 		// classifier
 		int newLable = predict(MLmodel, featureSet);
@@ -256,23 +259,17 @@ std::vector<int> postProcessingRules::slurClassifier(const std::vector<candidate
 
 
 /// keeps main and second peaks
-std::vector<int> postProcessingRules::keepJustTwoPeaks(const std::vector<candidate>& candids) {
+std::vector<int> postProcessingRules::keepJustTwoPeaks(const candidateTable& candids) {
 
 	std::vector<int> indexPeakCandidates = postProcessingRules::peakCandidates(candids);
 
-	std::vector<candidate> candidsTMP;
-	for (std::size_t i = 0; i < indexPeakCandidates.size(); ++i) {
-		candidsTMP.push_back(candids[indexPeakCandidates[i]]);
-	}
-
 	int mainPeakIndex = -1;
 	double mainPeakAmplitude = 0;
-	postProcessingRules:: candidateMax(candidsTMP, mainPeakAmplitude, mainPeakIndex);
+	postProcessingRules:: candidateMax(candids, indexPeakCandidates, mainPeakAmplitude, mainPeakIndex);
 
 	int secondPeakIndex = -1;
 	double secondPeakAmplitude = 0;
-	postProcessingRules:: candidateSecondMax(candidsTMP, secondPeakAmplitude, secondPeakIndex);
-	candidsTMP.clear();
+	postProcessingRules:: candidateSecondMax(candids, indexPeakCandidates, secondPeakAmplitude, secondPeakIndex);
 
 
     	indexPeakCandidates.erase(indexPeakCandidates.begin() + mainPeakIndex); // remove mainPeakIndex
@@ -288,7 +285,7 @@ std::vector<int> postProcessingRules::keepJustTwoPeaks(const std::vector<candida
 }
 
 ///  finds all peaks that have one flat side and converts them to slur
-std::vector<int> postProcessingRules::convertPeakToSlur(const arma::rowvec& wave, const std::vector<candidate>& candids, double minValidAmplitudePeak) {
+std::vector<int> postProcessingRules::convertPeakToSlur(const arma::rowvec& wave, const candidateTable& candids, double minValidAmplitudePeak) {
 
 	std::vector<int> newSlurCondidates;
 	std::vector<int> indexPeakCandidates = postProcessingRules::peakCandidates(candids);
@@ -302,16 +299,16 @@ std::vector<int> postProcessingRules::convertPeakToSlur(const arma::rowvec& wave
 	for(std::size_t i = 0; i < indexPeakCandidates.size() && indexPeakCandidates.size() > 0; ++i) {
 		if(indexPeakCandidates[i] > 0)  { // there is a local minima before peak
 			int xIntersect = 0;
-			postProcessingRules::intersectionTwoCandidates(candids[indexPeakCandidates[i]-1], candids[indexPeakCandidates[i]], xIntersect);
-			if ((candids[indexPeakCandidates[i]].get_y() - wave(xIntersect)) < minValidAmplitudePeak) {
+			postProcessingRules::intersectionTwoCandidates(candids, indexPeakCandidates[i]-1, indexPeakCandidates[i], xIntersect);
+			if ((candids.get_y(indexPeakCandidates[i]) - wave(xIntersect)) < minValidAmplitudePeak) {
 				newSlurCondidates.push_back(indexPeakCandidates[i]);
 				continue; // dont look at the other side of peak
 		    	}
 		}
 		 if(indexPeakCandidates[i] < static_cast<int>(candids.size()) -1)  { // there is a local minima after peak
 			int xIntersect = 0;
-			postProcessingRules::intersectionTwoCandidates(candids[indexPeakCandidates[i]], candids[indexPeakCandidates[i]+1], xIntersect);
-			if((candids[indexPeakCandidates[i]].get_y() - wave(xIntersect)) < minValidAmplitudePeak) {
+			postProcessingRules::intersectionTwoCandidates(candids, indexPeakCandidates[i], indexPeakCandidates[i]+1, xIntersect);
+			if((candids.get_y(indexPeakCandidates[i]) - wave(xIntersect)) < minValidAmplitudePeak) {
 				newSlurCondidates.push_back(indexPeakCandidates[i]);
 		 	}
 		}
@@ -321,7 +318,7 @@ std::vector<int> postProcessingRules::convertPeakToSlur(const arma::rowvec& wave
 }
 
 ///  labels a non-measurable signal
-bool postProcessingRules::nonMeasurableSignal(std::vector<candidate>& candids, double nonMeasurableVoltage) {
+bool postProcessingRules::nonMeasurableSignal(candidateTable& candids, double nonMeasurableVoltage) {
 	std::vector<int> indexPeakCandidates = postProcessingRules::peakCandidates(candids);
 
 	int mainPeakIndex = -1;
@@ -331,55 +328,56 @@ bool postProcessingRules::nonMeasurableSignal(std::vector<candidate>& candids, d
 }
 
 /// finds an intersection between slops of two candidates
-void postProcessingRules::intersectionTwoCandidates(const candidate& candids1, const candidate& candids2, int& xIntersect) {
+void postProcessingRules::intersectionTwoCandidates(const candidateTable& candids, int candids1, int candids2, int& xIntersect) {
 
 	// y = ax + b
 	// y = cx + d
 	// => ax + b = cx + d => x = (d-b)/(a-c)
 	double db(0), ac(0);
-	if (candids2.get_x() > candids1.get_x()) {
-		db = candids1.get_b1() - candids2.get_b0();
-		ac = candids2.get_a0() - candids1.get_a1();
+	if (candids.get_x(candids2) > candids.get_x(candids1)) {
+		db = candids.get_b1(candids1) - candids.get_b0(candids2);
+		ac = candids.get_a0(candids2) - candids.get_a1(candids1);
 	}
 	else {
-		db = candids2.get_b1() - candids1.get_b0();
-		ac = candids1.get_a0() - candids2.get_a1();
+		db = candids.get_b1(candids2) - candids.get_b0(candids1);
+		ac = candids.get_a0(candids1) - candids.get_a1(candids2);
 	}
 	if (ac > 1e-10) // checks for dividing by zero
 		xIntersect = std::ceil(std::abs(db/ac));
 	else
 		xIntersect = -1;
-	if (xIntersect < candids1.get_risingRangeInfo(2) || xIntersect > candids2.get_risingRangeInfo(1)) { // two candidates have a same slope
-		xIntersect = std::ceil((candids1.get_risingRangeInfo(2) + xIntersect > candids2.get_risingRangeInfo(1))/2);
+	if (xIntersect < candids.get_risingRangeInfo(candids1, 2) || xIntersect > candids.get_risingRangeInfo(candids2, 1)) { // two candidates have a same slope
+		xIntersect = std::ceil((candids.get_risingRangeInfo(candids1, 2) + xIntersect > candids.get_risingRangeInfo(candids2, 1))/2);
 	}
 }
 
-std::vector<int> postProcessingRules::typeCandidates(const std::vector<candidate>& candids, int type) { // index of candidates specified by type
+std::vector<int> postProcessingRules::typeCandidates(const candidateTable& candids, int type) { // index of candidates specified by type
 	std::vector<int> indexCandidates;
-	for(std::size_t i = 0; i < candids.size(); ++i) {
-		if (candids[i].get_label() == type)
+	const std::vector<int>& labels = candids.labels();
+	for(std::size_t i = 0; i < labels.size(); ++i) {
+		if (labels[i] == type)
 			indexCandidates.push_back(i);
 	}
 	return indexCandidates;
 }
 
-std::vector<int> postProcessingRules::peakCandidates(const std::vector<candidate>& candids) { // index of peak candidates
+std::vector<int> postProcessingRules::peakCandidates(const candidateTable& candids) { // index of peak candidates
 	return postProcessingRules::typeCandidates(candids, 2);
 }
 
-std::vector<int> postProcessingRules::risingSlurCandidates(const std::vector<candidate>& candids) { // index of rising slur candidates
+std::vector<int> postProcessingRules::risingSlurCandidates(const candidateTable& candids) { // index of rising slur candidates
 	return postProcessingRules::typeCandidates(candids, 1);
 }
 
-std::vector<int> postProcessingRules::fallingSlurCandidates(const std::vector<candidate>& candids) { // index of falling slur candidates
+std::vector<int> postProcessingRules::fallingSlurCandidates(const candidateTable& candids) { // index of falling slur candidates
 	return postProcessingRules::typeCandidates(candids, -1);
 }
 
-std::vector<int> postProcessingRules::slurCandidates(const std::vector<candidate>& candids) { // index of slur candidates
+std::vector<int> postProcessingRules::slurCandidates(const candidateTable& candids) { // index of slur candidates
 	return postProcessingRules::typeCandidates(candids, 0);
 }
 
-std::vector<int> postProcessingRules::risingFallingslurCandidates(const std::vector<candidate>& candids) { // index of rising & falling slur candidates
+std::vector<int> postProcessingRules::risingFallingslurCandidates(const candidateTable& candids) { // index of rising & falling slur candidates
 	std::vector<int> slurIndex = postProcessingRules::risingSlurCandidates(candids);
 	std::vector<int> fslurIndex = postProcessingRules::fallingSlurCandidates(candids);
 	slurIndex.insert(slurIndex.end(), fslurIndex.begin(), fslurIndex.end());
@@ -387,46 +385,47 @@ std::vector<int> postProcessingRules::risingFallingslurCandidates(const std::vec
 }
 
 /// returns index and amplitude of main peak
-void postProcessingRules::mainPeak(const std::vector<candidate>& candids, const std::vector<int>& indexPeakCandidates, int& maxPeakIndex, double& maxPeakAmplitude) {
+void postProcessingRules::mainPeak(const candidateTable& candids, const std::vector<int>& indexPeakCandidates, int& maxPeakIndex, double& maxPeakAmplitude) {
 
-	std::vector<candidate> candidsTMP;
-	for (std::size_t i = 0; i < indexPeakCandidates.size(); ++i) {
-		candidsTMP.push_back(candids[indexPeakCandidates[i]]);
-	}
-
-	postProcessingRules::candidateMax(candidsTMP, maxPeakAmplitude, maxPeakIndex);
-	candidsTMP.clear();
+	postProcessingRules::candidateMax(candids, indexPeakCandidates, maxPeakAmplitude, maxPeakIndex);
 
 	return;
 }
 
-/// internal comparision function
-bool cmp(const candidate& lhs, const candidate& rhs) {
-  return lhs.get_y() < rhs.get_y();
-}
-
 /// returns index and amplitude of main peak in a peak candidats' list
-void postProcessingRules::candidateMax(const std::vector<candidate>& candids, double& amp, int& index) {
-	if (candids.size() > 0) {
-		auto max_it = std::max_element(candids.begin(), candids.end(), cmp);
-		amp = max_it->get_y();
-		index = std::distance(candids.begin(), max_it);
+void postProcessingRules::candidateMax(const candidateTable& candids, const std::vector<int>& indexCandidates, double& amp, int& index) {
+	if (indexCandidates.size() > 0) {
+		const std::vector<double>& y = candids.y();
+		int max_index = 0;
+		for (std::size_t i = 1; i < indexCandidates.size(); ++i) { // first max, as std::max_element
+			if (y[indexCandidates[max_index]] < y[indexCandidates[i]]) max_index = i;
+		}
+		amp = y[indexCandidates[max_index]];
+		index = max_index;
 	}
 }
 
 /// returns index and amplitude of second peak
-void postProcessingRules::candidateSecondMax(const std::vector<candidate>& candids, double& amp, int& index) {
-
-	if (candids.size() > 0) {
-		auto max_it = std::max_element(candids.begin(), candids.end(), cmp);
-		int max_index = std::distance(candids.begin(), max_it);
-		auto max_it_part1 = std::max_element(candids.begin(), candids.begin() + max_index, cmp);
-		int max_index_part1 = std::distance(candids.begin(), max_it_part1);
-		auto max_it_part2 = std::max_element(candids.begin() + max_index + 1, candids.end(), cmp);
-		int max_index_part2 = std::distance(candids.begin(), max_it_part2);
-
-		index = max_index != 0 ? (max_index < static_cast<int>(candids.size()) -1 ? (max_it_part1->get_y() > max_it_part2->get_y() ? max_index_part1: max_index_part2) : max_index_part1) : (max_index < static_cast<int>(candids.size()) -1 ? max_index_part2 : -1);
-		amp = index != -1 ? (index != max_index_part1 ? max_it_part2->get_y() : max_it_part1->get_y()) : 0;
+void postProcessingRules::candidateSecondMax(const candidateTable& candids, const std::vector<int>& indexCandidates, double& amp, int& index) {
+
+	if (indexCandidates.size() > 0) {
+		const std::vector<double>& y = candids.y();
+		const int n = indexCandidates.size();
+		int max_index = 0;
+		double tmp = 0;
+		postProcessingRules::candidateMax(candids, indexCandidates, tmp, max_index);
+
+		// max before and after the main peak (first max of each part)
+		int max_index_part1 = 0;
+		for (int i = 1; i < max_index; ++i) {
+			if (y[indexCandidates[max_index_part1]] < y[indexCandidates[i]]) max_index_part1 = i;
+		}
+		int max_index_part2 = max_index + 1;
+		for (int i = max_index + 2; i < n; ++i) {
+			if (y[indexCandidates[max_index_part2]] < y[indexCandidates[i]]) max_index_part2 = i;
+		}
+
+		index = max_index != 0 ? (max_index < n -1 ? (y[indexCandidates[max_index_part1]] > y[indexCandidates[max_index_part2]] ? max_index_part1: max_index_part2) : max_index_part1) : (max_index < n -1 ? max_index_part2 : -1);
+		amp = index != -1 ? (index != max_index_part1 ? y[indexCandidates[max_index_part2]] : y[indexCandidates[max_index_part1]]) : 0;
 	}
 }
-
@@ -36,8 +36,6 @@ namespace ecglib {
 
 namespace twaveDelineate {
 
-struct candidate; // forward declaration
-
 /**
  * @brief pre-processing rules of twave delineation
  */
@@ -62,7 +60,7 @@ class preProcessingRules {
 		 *
 		 * @return index of candidates that should be removed based on this rule
 		 */
-		std::vector<int> fewPointsCandidates(const std::vector<candidate>& candids, double minPoints);
+		std::vector<int> fewPointsCandidates(const candidateTable& candids, double minPoints);
 };
 
 /**
@@ -95,7 +93,7 @@ class postProcessingRules {
 		 *
 		 * @return index of candidates that should be removed based on this rule
 		 */
-		std::vector<int> lowAmplitudeMainPeak(const std::vector<candidate>& candids, double minValidAmplitudeMainPeak, double percentMainePeak);
+		std::vector<int> lowAmplitudeMainPeak(const candidateTable& candids, double minValidAmplitudeMainPeak, double percentMainePeak);
 
 		/**
 		 * @brief finds peak candidates with lower amplitude in compare with a percentage of highest peak and minimum valid amplitude
@@ -106,7 +104,7 @@ class postProcessingRules {
 		 *
 		 * @return index of candidates that should be removed based on this rule
 		 */
-		std::vector<int> lowAmplitudePeaks(const std::vector<candidate>& candids, double minValidAmplitude, double percentPeak);
+		std::vector<int> lowAmplitudePeaks(const candidateTable& candids, double minValidAmplitude, double percentPeak);
 
 		/**
 		 * @brief Finds peaks which are not close to the main peak in term of amplitude
@@ -116,7 +114,7 @@ class postProcessingRules {
 		 *
 		 * @return index of candidates that should be removed based on this rule
 		 */
-		std::vector<int> inconsistentPeaks(const std::vector<candidate>& candids, double maxDelatAplitudeNotches);
+		std::vector<int> inconsistentPeaks(const candidateTable& candids, double maxDelatAplitudeNotches);
 
 		/**
 		 * @brief Finds slur candidates
@@ -125,7 +123,7 @@ class postProcessingRules {
 		 *
 		 * @return index of candidates that should be removed based on this rule
 		 */
-		std::vector<int> unrelatedSlure(const std::vector<candidate>& candids);
+		std::vector<int> unrelatedSlure(const candidateTable& candids);
 
 		/**
 		 * @brief Merges two consequent condidates if they are close in terms of amplitude
@@ -136,7 +134,7 @@ class postProcessingRules {
 		 *
 		 * @return index of candidates that should be removed based on this rule
 		 */
-		std::vector<int> meargingCandidates(const arma::rowvec& wave, std::vector<candidate>& candids, double minAmplitudeFlatness);
+		std::vector<int> meargingCandidates(const arma::rowvec& wave, candidateTable& candids, double minAmplitudeFlatness);
 
 		/**
 		 * @brief Distinguishes good slur from bad slur based on classification rules (bad slur will be removed)
@@ -146,7 +144,7 @@ class postProcessingRules {
 		 *
 		 * @return index of candidates that should be removed based on this rule
 		 */
-		std::vector<int> slurClassifier(const std::vector<candidate>& candids, const std::vector<std::vector<double> >& featursThreshold);
+		std::vector<int> slurClassifier(const candidateTable& candids, const std::vector<std::vector<double> >& featursThreshold);
 
 		/**
 		 * @brief Keeps main and second peaks
@@ -155,7 +153,7 @@ class postProcessingRules {
 		 *
 		 * @return index of candidates that should be removed based on this rule
 		 */
-		std::vector<int> keepJustTwoPeaks(const std::vector<candidate>& candids);
+		std::vector<int> keepJustTwoPeaks(const candidateTable& candids);
 
 		/**
 		 * @brief Finds all peaks that have one flat side and converts them to slur
@@ -166,7 +164,7 @@ class postProcessingRules {
 		 *
 		 * @return index of candidates that should be removed based on this rule
 		 */
-		std::vector<int> convertPeakToSlur(const arma::rowvec& wave, const std::vector<candidate>& candids, double minValidAmplitudePeak);
+		std::vector<int> convertPeakToSlur(const arma::rowvec& wave, const candidateTable& candids, double minValidAmplitudePeak);
 
 		/**
 		 * @brief Just an informative falg to label a non-measurable signal (low main peak amplitude)
@@ -176,7 +174,7 @@ class postProcessingRules {
 		 *
 		 * @return true if signal is non-measurable 
 		 */
-		bool nonMeasurableSignal(std::vector<candidate>& candids, double nonMeasurableVoltage);
+		bool nonMeasurableSignal(candidateTable& candids, double nonMeasurableVoltage);
 
         /*                          */
 	 	/* 		end of rules		*/
@@ -191,7 +189,7 @@ class postProcessingRules {
 		 *
 		 * @return index of candidates
 		 */
-		std::vector<int> typeCandidates(const std::vector<candidate>& candids, int type);
+		std::vector<int> typeCandidates(const candidateTable& candids, int type);
 
 		/**
 		 * @brief Finds peak candidates in a candidate list
@@ -200,7 +198,7 @@ class postProcessingRules {
 		 *
 		 * @return index of candidates
 		 */
-		std::vector<int> peakCandidates(const std::vector<candidate>& candids);
+		std::vector<int> peakCandidates(const candidateTable& candids);
 
 		/**
 		 * @brief Finds slur candidates in a candidate list
@@ -209,7 +207,7 @@ class postProcessingRules {
 		 *
 		 * @return index of candidates
 		 */
-		std::vector<int> slurCandidates(const std::vector<candidate>& candids);
+		std::vector<int> slurCandidates(const candidateTable& candids);
 
 		/**
 		 * @brief Finds rising slur candidates in a candidate list
@@ -218,7 +216,7 @@ class postProcessingRules {
 		 *
 		 * @return index of candidates
 		 */
-		std::vector<int> risingSlurCandidates(const std::vector<candidate>& candids);
+		std::vector<int> risingSlurCandidates(const candidateTable& candids);
 
 		/**
 		 * @brief Finds falling slur candidates in a candidate list
@@ -227,7 +225,7 @@ class postProcessingRules {
 		 *
 		 * @return index of candidates
 		 */
-		std::vector<int> fallingSlurCandidates(const std::vector<candidate>& candids);
+		std::vector<int> fallingSlurCandidates(const candidateTable& candids);
 
 		/**
 		 * @brief Finds rising and falling slur candidates in a candidate list
@@ -236,7 +234,7 @@ class postProcessingRules {
 		 *
 		 * @return index of candidates
 		 */
-		std::vector<int> risingFallingslurCandidates(const std::vector<candidate>& candids);
+		std::vector<int> risingFallingslurCandidates(const candidateTable& candids);
 
 		/**
 		 * @brief Finds main peak between all candidates
@@ -246,34 +244,37 @@ class postProcessingRules {
 		 * @param maxPeakIndex (out var) index of main peak
 		 * @param maxPeakAmplitude (out var) amplitude of main peak
 		 */
-		void mainPeak(const std::vector<candidate>& candids, const std::vector<int>& indexPeakCandidates, int& maxPeakIndex, double& maxPeakAmplitude);
+		void mainPeak(const candidateTable& candids, const std::vector<int>& indexPeakCandidates, int& maxPeakIndex, double& maxPeakAmplitude);
 
 		/**
 		 * @brief Finds main peak in a peak list
 		 *
-		 * @param candids candidate list of all peaks
+		 * @param candids candidate list
+		 * @param indexCandidates index of all peaks in candidate list
 		 * @param amp (out var) amplitude of main peak
-		 * @param index (out var) index of main peak
+		 * @param index (out var) index of main peak in indexCandidates
 		 */
-		void candidateMax(const std::vector<candidate>& candids, double& amp, int& index);
+		void candidateMax(const candidateTable& candids, const std::vector<int>& indexCandidates, double& amp, int& index);
 
 		/**
 		 * @brief Finds second peak in a peak list
 		 *
-		 * @param candids candidate list of all peaks
+		 * @param candids candidate list
+		 * @param indexCandidates index of all peaks in candidate list
 		 * @param amp (out var) amplitude of second peak
-		 * @param index (out var) index of second peak
+		 * @param index (out var) index of second peak in indexCandidates
 		 */
-		void candidateSecondMax(const std::vector<candidate>& candids, double& amp, int& index);
+		void candidateSecondMax(const candidateTable& candids, const std::vector<int>& indexCandidates, double& amp, int& index);
 
 		/**
 		 * @brief Finds intersection between two candidates based on intersection of their slopes line
 		 *
-		 * @param candids1 first candidate
-		 * @param candids2 second candidate
+		 * @param candids candidate list
+		 * @param candids1 index of first candidate
+		 * @param candids2 index of second candidate
 		 * @param xIntersect (out var) index of intersection
 		 */
-		void intersectionTwoCandidates(const candidate& candids1, const candidate& candids2, int& xIntersect);
+		void intersectionTwoCandidates(const candidateTable& candids, int candids1, int candids2, int& xIntersect);
 };
 }
 /*!
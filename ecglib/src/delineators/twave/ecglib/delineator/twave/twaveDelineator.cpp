@@ -37,8 +37,30 @@ namespace ecglib {
 	// Input is an '_' separated string of thresholds and output is vector of thresholds
 	std::vector<std::vector<double> > featursThresholdPreparation(std::string thresholds); // function prototype
 
+	// finds the qoff seed of a twave: global qoff, else average of qoff across leads (-1 if there is no qoff)
+	int seedQoff(const ecglib::pointmap &pmin); // function prototype
+
+	// determines the rpeak and rr of a (median) beat of nsamples for re-adjusting toff (step 02/03 of twaveDelineators)
+	void twaveSeeds(const ecglib::propertystore *props, std::size_t nsamples, const ecglib::pointmap &pmin, int &rpeak, double &rr); // function prototype
+
+	// delineates the twave of an already filtered (median) beat, steps 02 - 06 of twaveDelineators
+	std::tuple<pointmap, ecglib::twaveDelineate::annotation> twaveDelineatorsFiltered(const ecglib::const_ecgview &e, const ecglib::pointmap &pmin, const ecglib::twaveDelineator_config &cfg); // function prototype
+
+	// delineates the twave of the vcg lead (column vcgIndex) of an already filtered (median) beat, steps 02 - 06 of twaveDelineators
+	std::tuple<pointmap, ecglib::twaveDelineate::annotation> twaveDelineateVcg(const arma::rowvec &wave, int vcgIndex, const ecglib::propertystore *props, const ecglib::pointmap &pmin, const ecglib::twaveDelineator_config &cfg); // function prototype
+
+	// cuts the twave range [Qoff+a	Qoff+b] out of a lead, pointStart is the position of the first sample of the twave inside the lead
+	arma::rowvec twaveSegment(const arma::rowvec &lead, int seedoff, double rr, const ecglib::twaveDelineator_config &cfg, int &pointStart); // function prototype
+
+	// delineates the twave inside a lead, seedoff/rpeak and the output annotations are positions relative to the first sample of the lead
+	ecglib::twaveDelineate::annotation twaveDelineateLead(const arma::rowvec &lead, int seedoff, int rpeak, double rr, const ecglib::twaveDelineator_config &cfg, const std::vector<std::vector<double> > &featursThreshold, int &pointStart, double &toff_new); // function prototype
+
+	// writes the twave annotations into the pointmap of the vcg lead (replacing the old ones)
+	void twavePropagate(ecglib::pointmap &pm, const ecglib::pointmap &pmin, int vcgIndex, ecglib::twaveDelineate::annotation &anns, double toff_new, int pointStart, double rr, const ecglib::twaveDelineator_config &cfg); // function prototype
+
 	// main entrance into twaveDelineator for calculating twave annotations
 	std::tuple<pointmap, ecglib::twaveDelineate::annotation> twaveDelineators(const ecglib::ecgdata &e, const ecglib::pointmap &pmin, const ecglib::twaveDelineator_config &cfg) {
+#ifdef ECGLIB_PREPROCESSORS
 		if(e.fs() != 1000){ // check the valid frequency
 			std::string line = std::string("frequency should be 1000Hz");
 			std::cerr << line;
@@ -46,94 +68,307 @@ namespace ecglib {
 		}
 
 		ecglib::ecgdata ecg(e);		// internal ecg variable
-		ecglib::pointmap pm(pmin);	// internal annotation variable
-
-		int vcgIndex (0);		// index of VCG inside ecgdata
 		arma::vec filt = zeros<vec>(1);	// filter instantiation
 
-
-		vcgIndex = ecg.leadnum(ecglead::VCGMAG); // index of VCG
-
 		/* step 01: filter input ecg */
 		filt(0) = cfg.get<double>("filterHighCutoff"); // high cutoff 25 Hz
-#ifdef ECGLIB_PREPROCESSORS
         // Preprocessing and filtering methods are not released in version 1.0.0 of ecglib, but ecg should be filter as follows
 		ecglib::filter filterData(cfg.get<int>("filterOrder"), filt, false); // 5th order, with cutoff 25 HZ and not a stop filter, i.e. a lowpass filter
 		filterData(ecg);
+
+		return twaveDelineatorsFiltered(ecg.view(), pmin, cfg);
+#else
+		if(e.fs() != 1000){ // check the valid frequency
+			std::string line = std::string("frequency should be 1000Hz");
+			std::cerr << line;
+			throw std::logic_error(line);
+		}
+
+		// only the vcg lead is read, a virtual vcg lead is computed without laying out the other leads
+		int vcgIndex = e.leadnum(ecglead::VCGMAG); // index of VCG
+		return twaveDelineateVcg(e.lead(vcgIndex).t(), vcgIndex, &e.properties(), pmin, cfg);
+#endif
+	}
+
+	// main entrance into twaveDelineator for samples that are not owned by an ecgdata
+	std::tuple<pointmap, ecglib::twaveDelineate::annotation> twaveDelineators(const ecglib::const_ecgview &e, const ecglib::pointmap &pmin, const ecglib::twaveDelineator_config &cfg) {
+#ifdef ECGLIB_PREPROCESSORS
+		// the filter works in place on an ecgdata, so the view is copied once
+		return twaveDelineators(ecglib::ecgdata(e), pmin, cfg);
+#else
+		return twaveDelineatorsFiltered(e, pmin, cfg);
 #endif
-		/* step 02: preparation of Twave range */
-			// Determine seed points:
-			// Strategy 1: Grab globals
-			int seedoff = -1;
-			std::vector<annotation> locs;
-			get_annotations(pmin, GLOBAL_LEAD, annotation_type::QOFF, locs);
-
-			if(locs.size() == 1) {	
-				seedoff = locs[0].location();
+	}
+
+	// delineates the twave of an already filtered (median) beat
+	std::tuple<pointmap, ecglib::twaveDelineate::annotation> twaveDelineatorsFiltered(const ecglib::const_ecgview &e, const ecglib::pointmap &pmin, const ecglib::twaveDelineator_config &cfg) {
+		if(e.fs() != 1000){ // check the valid frequency
+			std::string line = std::string("frequency should be 1000Hz");
+			std::cerr << line;
+			throw std::logic_error(line);
+		}
+
+		int vcgIndex = e.leadnum(ecglead::VCGMAG); // index of VCG
+		return twaveDelineateVcg(e.lead(vcgIndex).t(), vcgIndex, e.properties(), pmin, cfg);
+	}
+
+	// delineates the twave of the vcg lead of an already filtered (median) beat
+	std::tuple<pointmap, ecglib::twaveDelineate::annotation> twaveDelineateVcg(const arma::rowvec &wave, int vcgIndex, const ecglib::propertystore *props, const ecglib::pointmap &pmin, const ecglib::twaveDelineator_config &cfg) {
+		ecglib::pointmap pm(pmin);	// internal annotation variable
+
+		/* step 02 & 03: preparation of Twave range */
+		// Determine seed points: global qoff, else average across leads
+		int seedoff = seedQoff(pmin);
+		int rpeak = -1;
+		double rr = 0;
+		twaveSeeds(props, wave.n_elem, pmin, rpeak, rr);
+
+		/* step 04 & 05: call twave annotators functions and re-adjusts toff place */
+		std::vector<std::vector<double> > featursThreshold = featursThresholdPreparation(cfg.get<std::string>("featursThreshold")); // threshoulds of classification rules based on decision tree
+		int pointStart = 0;
+		double toff_new = -1;
+		ecglib::twaveDelineate::annotation anns = twaveDelineateLead(wave, seedoff, rpeak, rr, cfg, featursThreshold, pointStart, toff_new);
+
+		/* step 06: propagate the output delineators */
+		twavePropagate(pm, pmin, vcgIndex, anns, toff_new, pointStart, rr, cfg);
+
+		return std::make_tuple(std::move(pm),anns);
+	}
+
+	// beat-by-beat entrance into twaveDelineator for long recordings
+	std::size_t twaveDelineatorsBeats(const ecglib::ecgdata &e, const std::vector<ecglib::beat> &beats, const ecglib::twaveDelineator_config &cfg, const twaveBeatCallback &callback) {
+		return twaveDelineatorsBeats(e.view(), beats, cfg, callback);
+	}
+
+	// beat-by-beat entrance into twaveDelineator for samples that are not owned by an ecgdata
+	std::size_t twaveDelineatorsBeats(const ecglib::const_ecgview &e, const std::vector<ecglib::beat> &beats, const ecglib::twaveDelineator_config &cfg, const twaveBeatCallback &callback) {
+		if(e.fs() != 1000){ // check the valid frequency
+			std::string line = std::string("frequency should be 1000Hz");
+			std::cerr << line;
+			throw std::logic_error(line);
+		}
+
+		const int vcgIndex = e.leadnum(ecglead::VCGMAG); // index of VCG
+		const std::size_t nsamples = e.nsamples();
+
+		// thresholds are parsed once for the whole recording
+		std::vector<std::vector<double> > featursThreshold = featursThresholdPreparation(cfg.get<std::string>("featursThreshold"));
+
+		std::size_t ndelineated = 0;
+		for(std::size_t i = 0; i < beats.size(); ++i) {
+			const ecglib::beat &b = beats[i];
+
+			ecglib::beat out = b;
+			ecglib::twaveDelineate::annotation anns;
+
+			// the beat window is [start, stop) and can not exceed the recording
+			const std::size_t start = b.start;
+			const std::size_t stop = std::min(b.stop, nsamples);
+			const int seedoff = seedQoff(b.points);
+
+			// local rr: rr of the beat, else the distance to the next rpeak, else the remaining part of the beat
+			double rr = b.rr;
+			if(rr <= 0) {
+				rr = (i+1 < beats.size()) ? static_cast<double>(beats[i+1].rpeak) - b.rpeak : static_cast<double>(stop) - b.rpeak;
 			}
-			locs.clear();
-			// Strategy 2: Average across leads
-			if(seedoff == -1) {
-				get_annotations(pmin, annotation_type::QOFF, locs);
-				vec offs = zeros<vec>(locs.size());
-				std::copy(locs.begin(),locs.end(),offs.begin());
-				seedoff = mean(offs);
-				locs.clear();
+
+			if(seedoff < 0 || stop <= start + 1 || rr <= 0 || static_cast<std::size_t>(seedoff) < start || static_cast<std::size_t>(seedoff) + 25 >= stop) { // no qoff or window too short for a twave
+				anns.rulesHit[ecglib::twaveDelineate::rule::hasDelineators] = 0;
+				callback(out, anns);
+				continue;
 			}
 
-			// Determine rpeak for re-adjusting toff
-			// Strategy 1: Grab globals
-			int rpeak = -1;
-			get_annotations(pmin, GLOBAL_LEAD, annotation_type::RPEAK, locs);
+			// delineates on the beat window, all positions inside are relative to the start of the beat
+			arma::rowvec wave = beat_view(e, b).lead(vcgIndex).t();
+			int pointStart = 0;
+			double toff_new = -1;
+			anns = twaveDelineateLead(wave, seedoff - start, static_cast<int>(b.rpeak) - static_cast<int>(start), rr, cfg, featursThreshold, pointStart, toff_new);
 
-			if(locs.size() == 1) {	
-				rpeak = locs[0].location();
+			// back to positions of the recording
+			anns.on += start;
+			anns.off += start;
+			anns.lastCandidate += start;
+			for(std::size_t j = 0; j < anns.peak.size(); ++j) {
+				anns.peak[j] += start;
 			}
-			locs.clear();
-			// Strategy 2: Average across leads
-			if(rpeak == -1) {
-				get_annotations(pmin, annotation_type::RPEAK, locs);
-				vec peaks = zeros<vec>(locs.size());
-				std::copy(locs.begin(),locs.end(),peaks.begin());
-				rpeak = mean(peaks);
-				locs.clear();
-				if(e.hasproperty("precut")) { // if there is not a rpeak, the rpeak will be precut
-					rpeak = ecg.nsamples() - boost::any_cast<double>((e.getproperty("precut")).value);
-				}else{ // if there is not a rpeak or precut, the rpeak will be 250 which is just an arbitary value
-					rpeak = 250;
+			if(toff_new != -1) toff_new += start;
+			pointStart += start;
+
+			twavePropagate(out.points, b.points, vcgIndex, anns, toff_new, pointStart, rr, cfg);
+			if(anns.peak.size() > 0) ++ndelineated;
+
+			callback(out, anns);
+		}
+
+		return ndelineated;
+	}
+
+	// batched entrance into twaveDelineator: twaves of several records are delineated together in lanes
+	std::vector<std::tuple<pointmap, ecglib::twaveDelineate::annotation> > twaveDelineators(const std::vector<ecglib::ecgdata> &es, const std::vector<ecglib::pointmap> &pmins, const ecglib::twaveDelineator_config &cfg, std::size_t lanes) {
+		if(es.size() != pmins.size()) {
+			std::string line = std::string("number of ecgs and pointmaps differ");
+			std::cerr << line;
+			throw std::logic_error(line);
+		}
+		if(lanes == 0) lanes = 1;
+
+		std::vector<std::tuple<pointmap, ecglib::twaveDelineate::annotation> > out;
+		out.reserve(es.size());
+
+		std::vector<std::vector<double> > featursThreshold = featursThresholdPreparation(cfg.get<std::string>("featursThreshold")); // threshoulds of classification rules based on decision tree
+		ecglib::twaveDelineate::delineate deli;
+
+		for(std::size_t first = 0; first < es.size(); first += lanes) {
+			const std::size_t last = std::min(first + lanes, es.size());
+
+			std::vector<arma::rowvec> leads, twaves;
+			std::vector<int> vcgIndexes, rpeaks, pointStarts;
+			std::vector<double> rrs;
+
+			/* step 01 - 03: filter, seeds and twave boundries of each record */
+			for(std::size_t r = first; r < last; ++r) {
+				const ecglib::ecgdata &e = es[r];
+				if(e.fs() != 1000){ // check the valid frequency
+					std::string line = std::string("frequency should be 1000Hz");
+					std::cerr << line;
+					throw std::logic_error(line);
 				}
+
+				int vcgIndex = e.leadnum(ecglead::VCGMAG); // index of VCG
+#ifdef ECGLIB_PREPROCESSORS
+				ecglib::ecgdata ecg(e);		// internal ecg variable, the filter works in place
+				arma::vec filt = zeros<vec>(1);	// filter instantiation
+				filt(0) = cfg.get<double>("filterHighCutoff");
+				ecglib::filter filterData(cfg.get<int>("filterOrder"), filt, false);
+				filterData(ecg);
+				leads.push_back(static_cast<const ecglib::ecgdata&>(ecg).lead(vcgIndex).t());
+#else
+				leads.push_back(e.lead(vcgIndex).t()); // read only, the samples shared with the caller are not copied
+#endif
+				int seedoff = seedQoff(pmins[r]);
+				int rpeak = -1;
+				double rr = 0;
+				twaveSeeds(&e.properties(), e.nsamples(), pmins[r], rpeak, rr);
+
+				int pointStart = 0;
+				twaves.push_back(twaveSegment(leads.back(), seedoff, rr, cfg, pointStart));
+				vcgIndexes.push_back(vcgIndex);
+				rpeaks.push_back(rpeak);
+				rrs.push_back(rr);
+				pointStarts.push_back(pointStart);
 			}
 
-		/* step 03: calculates twave boundries [Qoff+a	Qoff+b] */
-		double rr = 0;
-		if(e.hasproperty("meanrr")) {
-			rr = boost::any_cast<double>((e.getproperty("meanrr")).value); // mean value of rr based on property
-		}else if(e.hasproperty("precut")) { // if there is not meanrr, the length of rr will be length of ecg - precut
-			rr = ecg.nsamples() - boost::any_cast<double>((e.getproperty("precut")).value);
+			/* step 04: call twave annotators functions for all lanes */
+			std::vector<ecglib::twaveDelineate::annotation> anns = deli.delineator(twaves, pointStarts, featursThreshold, cfg.get<int>("candidateFinder") , cfg.get<double>("deltaStepSlope"), cfg.get<int>("looseWindow"), cfg.get<int>("minPoints"), cfg.get<double>("deltaAmplitude"), cfg.get<double>("minVoltageMainPeak"), cfg.get<double>("percentMainePeak"), cfg.get<double>("minVoltage"), cfg.get<double>("percentPeak"), cfg.get<double>("maxDelatAplitudeNotches"), cfg.get<double>("minAmplitudeFlatness"), cfg.get<double>("minValidAmplitudePeak"), cfg.get<double>("measurable"), cfg.get<int>("maxSlopeLevels"), cfg.get<int>("mergeCandidates") != 0);
+			twaves.clear();
+
+			/* step 05 & 06: re-adjusts toff place and propagates the output delineators of each record */
+			for(std::size_t k = 0; k < anns.size(); ++k) {
+				const std::size_t r = first + k;
+				double toff_new = deli.readjustToff(leads[k], anns[k], rrs[k], rpeaks[k], cfg.get<int>("toffMethod"));
+				ecglib::pointmap pm(pmins[r]);
+				twavePropagate(pm, pmins[r], vcgIndexes[k], anns[k], toff_new, pointStarts[k], rrs[k], cfg);
+				out.push_back(std::make_tuple(std::move(pm), anns[k]));
+			}
+		}
+
+		return out;
+	}
+
+	// determines the rpeak and rr of a (median) beat for re-adjusting toff
+	void twaveSeeds(const ecglib::propertystore *props, std::size_t nsamples, const ecglib::pointmap &pmin, int &rpeak, double &rr) {
+		static const ecglib::propertykey meanrrkey("meanrr");
+		static const ecglib::propertykey precutkey("precut");
+
+		// int and unsigned properties count as well, a string throws as the untyped lookup did
+		double meanrr = 0, precut = 0;
+		const bool hasmeanrr = props != nullptr && props->number(meanrrkey, meanrr);
+		const bool hasprecut = props != nullptr && props->number(precutkey, precut);
+		std::vector<annotation> locs;
+
+		// Determine rpeak for re-adjusting toff
+		// Strategy 1: Grab globals
+		rpeak = -1;
+		get_annotations(pmin, GLOBAL_LEAD, annotation_type::RPEAK, locs);
+
+		if(locs.size() == 1) {	
+			rpeak = locs[0].location();
+		}
+		locs.clear();
+		// Strategy 2: Average across leads
+		if(rpeak == -1) {
+			get_annotations(pmin, annotation_type::RPEAK, locs);
+			vec peaks = zeros<vec>(locs.size());
+			std::copy(locs.begin(),locs.end(),peaks.begin());
+			rpeak = mean(peaks);
+			locs.clear();
+			if(hasprecut) { // if there is not a rpeak, the rpeak will be precut
+				rpeak = nsamples - precut;
+			}else{ // if there is not a rpeak or precut, the rpeak will be 250 which is just an arbitary value
+				rpeak = 250;
+			}
+		}
+
+		rr = 0;
+		if(hasmeanrr) {
+			rr = meanrr; // mean value of rr based on property
+		}else if(hasprecut) { // if there is not meanrr, the length of rr will be length of ecg - precut
+			rr = nsamples - precut;
 		}else{ // if there is not meanrr or precut, the approximate length of rr will be 80/100 of length of ecg
-			rr = (80./100.*ecg.nsamples());
+			rr = (80./100.*nsamples);
 		}
+	}
 
-		int pointStart = seedoff + 25; // 25 uses for avoiding j-point in calculations
+	// cuts the twave range [Qoff+a	Qoff+b] out of a lead
+	arma::rowvec twaveSegment(const arma::rowvec &lead, int seedoff, double rr, const ecglib::twaveDelineator_config &cfg, int &pointStart) {
+		pointStart = seedoff + 25; // 25 uses for avoiding j-point in calculations
 		int pointEnd  = pointStart + (rr*cfg.get<double>("approximateRangeOfTsegment")); // for testing purpose 'pointEnd = pointStart + 300' got used
-		if (pointEnd >= static_cast<int>(ecg.nsamples())) pointEnd = ecg.nsamples()-1;
-		arma::vec twave = ecg.lead(vcgIndex, pointStart, pointEnd);
+		if (pointEnd >= static_cast<int>(lead.n_elem)) pointEnd = lead.n_elem-1;
+		return lead(arma::span(pointStart, pointEnd));
+	}
+
+	// finds the qoff seed of a twave: global qoff, else average of qoff across leads
+	int seedQoff(const ecglib::pointmap &pmin) {
+		// Strategy 1: Grab globals
+		int seedoff = -1;
+		std::vector<annotation> locs;
+		get_annotations(pmin, GLOBAL_LEAD, annotation_type::QOFF, locs);
+
+		if(locs.size() == 1) {
+			seedoff = locs[0].location();
+		}
+		locs.clear();
+		// Strategy 2: Average across leads
+		if(seedoff == -1) {
+			get_annotations(pmin, annotation_type::QOFF, locs);
+			if(locs.size() == 0) return -1;
+			vec offs = zeros<vec>(locs.size());
+			std::copy(locs.begin(),locs.end(),offs.begin());
+			seedoff = mean(offs);
+		}
+		return seedoff;
+	}
+
+	// delineates the twave inside a lead, seedoff/rpeak and the output annotations are positions relative to the first sample of the lead
+	ecglib::twaveDelineate::annotation twaveDelineateLead(const arma::rowvec &lead, int seedoff, int rpeak, double rr, const ecglib::twaveDelineator_config &cfg, const std::vector<std::vector<double> > &featursThreshold, int &pointStart, double &toff_new) {
+		/* step 03: calculates twave boundries [Qoff+a	Qoff+b] */
+		arma::rowvec twave = twaveSegment(lead, seedoff, rr, cfg, pointStart);
 
 		/* step 04: call twave annotators functions*/
 		ecglib::twaveDelineate::delineate deli;
-		std::vector<std::vector<double> > featursThreshold = featursThresholdPreparation(cfg.get<std::string>("featursThreshold")); // threshoulds of classification rules based on decision tree
-		ecglib::twaveDelineate::annotation anns = deli.delineator(twave.t(), pointStart, featursThreshold, cfg.get<int>("candidateFinder") , cfg.get<double>("deltaStepSlope"), cfg.get<int>("looseWindow"), cfg.get<int>("minPoints"), cfg.get<double>("deltaAmplitude"), cfg.get<double>("minVoltageMainPeak"), cfg.get<double>("percentMainePeak"), cfg.get<double>("minVoltage"), cfg.get<double>("percentPeak"), cfg.get<double>("maxDelatAplitudeNotches"), cfg.get<double>("minAmplitudeFlatness"), cfg.get<double>("minValidAmplitudePeak"), cfg.get<double>("measurable"));
+		ecglib::twaveDelineate::annotation anns = deli.delineator(twave, pointStart, featursThreshold, cfg.get<int>("candidateFinder") , cfg.get<double>("deltaStepSlope"), cfg.get<int>("looseWindow"), cfg.get<int>("minPoints"), cfg.get<double>("deltaAmplitude"), cfg.get<double>("minVoltageMainPeak"), cfg.get<double>("percentMainePeak"), cfg.get<double>("minVoltage"), cfg.get<double>("percentPeak"), cfg.get<double>("maxDelatAplitudeNotches"), cfg.get<double>("minAmplitudeFlatness"), cfg.get<double>("minValidAmplitudePeak"), cfg.get<double>("measurable"), cfg.get<int>("maxSlopeLevels"), cfg.get<int>("mergeCandidates") != 0);
 		twave.clear(); // parameters of twave annotators
 
 		/* step 05: re-adjusts toff place */
-		arma::vec orignwave = ecg.lead(vcgIndex, 0, ecg.nsamples()-1);
-		double toff_new = deli.readjustToff(orignwave.t(), anns, rr, rpeak);
-		orignwave.clear();
+		toff_new = deli.readjustToff(lead, anns, rr, rpeak, cfg.get<int>("toffMethod"));
 
-		/* step 06: propagate the output delineators */
+		return anns;
+	}
 
+	// writes the twave annotations into the pointmap of the vcg lead (replacing the old ones)
+	void twavePropagate(ecglib::pointmap &pm, const ecglib::pointmap &pmin, int vcgIndex, ecglib::twaveDelineate::annotation &anns, double toff_new, int pointStart, double rr, const ecglib::twaveDelineator_config &cfg) {
 		// clear old annotations of twave
-		locs.clear();
+		std::vector<annotation> locs;
 		get_annotations(pmin, vcgIndex, annotation_type::TON, locs);
 		get_annotations(pmin, vcgIndex, annotation_type::TOFF, locs);
 		get_annotations(pmin, vcgIndex, annotation_type::TPEAK, locs);
@@ -145,7 +380,7 @@ namespace ecglib {
 		if (anns.peak.size() > 0) {
 			// new toff
 			double toff = anns.off;
-			anns.rulesHit["toff_maxslope"] = toff;
+			anns.toff_maxslope = toff;
 
 			// re-assign toff based on value of re-adjused toff
 			if (toff_new == -1) toff = 0; // calculation of toff had problem
@@ -171,13 +406,11 @@ namespace ecglib {
 			if (anns.peak.size() > 1) {
 				pm[vcgIndex][anns.peak[1]] = annotation(anns.peak[1], annotation_type::TPPEAK, vcgIndex);
 			}
-			anns.rulesHit["hasDelineators"] = 1; // twaveDelineator has anns
+			anns.rulesHit[ecglib::twaveDelineate::rule::hasDelineators] = 1; // twaveDelineator has anns
 		}
 		else {
-			anns.rulesHit["hasDelineators"] = 0; // twaveDelineator has not any anns
+			anns.rulesHit[ecglib::twaveDelineate::rule::hasDelineators] = 0; // twaveDelineator has not any anns
 		}
-
-		return std::make_tuple(pm,anns);
 	}
 
 	// Default config value of twaveDelineator's parameters
@@ -200,6 +433,16 @@ namespace ecglib {
 		add("approximateRangeOfTsegment",property(Type::Double,40./100.,"aproximate range of Tsegment based on RR percentage"));
 		add("approximateBoundaryOfToff",property(Type::Double,75./100.,"aproximate boundry of Toff based on RR percentage"));
 		add("measurable",property(Type::Double,100.,"min threshsold of Tpeak amplitude as a measurable ecg"));
+		add("maxSlopeLevels",property(Type::Int,0,"max number of moving zero crossing lines, 0 for no limit"));
+		add("mergeCandidates",property(Type::Int,1,"merges consecutive candidates that shape a flat candidate (1) or not (0)"));
+		add("toffMethod",property(Type::Int,1,"re-adjusts toff based on energy/cost function (1) or keeps the toff of the max slope (2)"));
+	}
+
+	// Fast profile of twaveDelineator's parameters: less slope levels, no merging of candidates and no energy search of toff
+	void twaveDelineator_config::fast() {
+		set("maxSlopeLevels", Type::Int, 50);
+		set("mergeCandidates", Type::Int, 0);
+		set("toffMethod", Type::Int, 2);
 	}
 
     // prepartion of thresholds of classification rules based on decision tree
@@ -24,10 +24,13 @@
 #define ECGLIB_DELINEATORS_TWAVE_TWAVEDELINEATOR_MH_2015_12_09 1
 
 #include <tuple>
+#include <functional>
 #include <ecglib/delineator/twave/delineate.hpp>
 #include <ecglib/ecglib.hpp>
 #include <ecglib/ecgdata.hpp>
+#include <ecglib/ecgview.hpp>
 #include <ecglib/annotation.hpp>
+#include <ecglib/beat.hpp>
 #include <ecglib/util/config.hpp>
 
 namespace ecglib {
@@ -48,11 +51,32 @@ namespace ecglib {
 				defaults();
 			}
 
+			/**
+			 * @brief Construction of twaveDelineator_config from a named profile
+			 *
+			 * @param profile "exact" (defaults) or "fast" (capped slope levels, no merging of candidates and toff of the max slope, for triage)
+			 */
+			explicit twaveDelineator_config(const std::string &profile): config() {
+				defaults();
+				if(profile == "fast") {
+					fast();
+				} else if(profile != "exact") {
+					std::string line = std::string("Unknown twaveDelineator profile: ") + profile;
+					std::cerr << line;
+					throw std::logic_error(line);
+				}
+			}
+
 		protected:
 			/**
 			 * @brief Default configuration of twaveDelineator
 			 */
 			void defaults();
+
+			/**
+			 * @brief Fast configuration of twaveDelineator (applied on top of defaults)
+			 */
+			void fast();
 	};
 
 	/**
@@ -66,6 +90,68 @@ namespace ecglib {
 	 */
 	std::tuple<pointmap, ecglib::twaveDelineate::annotation> twaveDelineators(const ecglib::ecgdata &e, const ecglib::pointmap &pmin, const ecglib::twaveDelineator_config &cfg);
 
+	/**
+	 * @brief Main entrance into twaveDelineator for samples that are not owned by an ecgdata (acquisition buffers, mapped files, slices)
+	 *
+	 * The samples are read in place, nothing is copied unless the preprocessing filter is compiled in (ECGLIB_PREPROCESSORS).
+	 * Properties (meanrr, precut) are read from the properties of the view if it has any.
+	 *
+ 	 * @param e Input ecg view
+ 	 * @param pmin Pointmap to use as source
+	 * @param cfg
+	 *
+	 * @return tuple<pointmap, annotation>: pointmap as output and annotation contains twaveDelineator
+	 */
+	std::tuple<pointmap, ecglib::twaveDelineate::annotation> twaveDelineators(const ecglib::const_ecgview &e, const ecglib::pointmap &pmin, const ecglib::twaveDelineator_config &cfg);
+
+	/**
+	 * @brief Batched entrance into twaveDelineator for many records (e.g. median beats of a study)
+	 *
+	 * Records are processed in groups of lanes: the moving zero crossing lines of the twaves of a group are calculated together,
+	 * the rest of the delineation is done per record. Results are the same as calling twaveDelineators per record.
+	 *
+ 	 * @param es Input ecg data
+ 	 * @param pmins Pointmaps to use as source (one per ecg)
+	 * @param cfg Configuration
+	 * @param lanes Number of records delineated together
+	 *
+	 * @return tuple<pointmap, annotation> per input ecg (same order)
+	 */
+	std::vector<std::tuple<pointmap, ecglib::twaveDelineate::annotation> > twaveDelineators(const std::vector<ecglib::ecgdata> &es, const std::vector<ecglib::pointmap> &pmins, const ecglib::twaveDelineator_config &cfg, std::size_t lanes = 8);
+
+	/**
+	 * @brief Callback receiving the delineation of one beat: the beat (with the twave annotations in the VCGMAG lead) and the twave annotation
+	 */
+	typedef std::function<void(const ecglib::beat&, const ecglib::twaveDelineate::annotation&)> twaveBeatCallback;
+
+	/**
+	 * @brief Beat-by-beat entrance into twaveDelineator for long recordings
+	 *
+	 * Each beat is delineated on its own window of the VCGMAG lead using the QOFF of the beat (global or averaged across leads) as seed, the rpeak of the beat and the local RR.
+	 * Only one beat window is kept in memory at a time and results are passed to the callback in beat order, so that no ecgdata is copied.
+	 * The ecg should already be filtered.
+	 *
+ 	 * @param e Input ecg data (complete recording)
+ 	 * @param beats Beats of the recording, e.g. from create_all_beats
+	 * @param cfg Configuration
+	 * @param callback Called once per beat, beats without QOFF are passed with hasDelineators set to 0
+	 *
+	 * @return Number of beats that got a twave
+	 */
+	std::size_t twaveDelineatorsBeats(const ecglib::ecgdata &e, const std::vector<ecglib::beat> &beats, const ecglib::twaveDelineator_config &cfg, const twaveBeatCallback &callback);
+
+	/**
+	 * @brief Beat-by-beat entrance into twaveDelineator for samples that are not owned by an ecgdata
+	 *
+ 	 * @param e Input ecg view (complete recording)
+ 	 * @param beats Beats of the recording, e.g. from create_all_beats
+	 * @param cfg Configuration
+	 * @param callback Called once per beat, beats without QOFF are passed with hasDelineators set to 0
+	 *
+	 * @return Number of beats that got a twave
+	 */
+	std::size_t twaveDelineatorsBeats(const ecglib::const_ecgview &e, const std::vector<ecglib::beat> &beats, const ecglib::twaveDelineator_config &cfg, const twaveBeatCallback &callback);
+
 	/*! 
 	 * @}
 	 */
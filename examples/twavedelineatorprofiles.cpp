@@ -0,0 +1,352 @@
+/**
+ * @file twavedelineatorprofiles.cpp
+ * @author Jose Vicente <jose.vicenteruiz@fda.hhs.gov>
+ * @author Meisam Hosseini <meisam.hosseini@fda.hhs.gov>
+ * @author Lars Johannesen <lars.johannesen@fda.hhs.gov>
+ *
+ * @version 1.0.0
+ *
+ * @section LICENSE
+ * twavedelineatorprofiles example code is in the public domain within the United States, and copyright and related rights in the work worldwide are waived through the CC0 1.0 Universal Public Domain Dedication. This example is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See DISCLAIMER section below, https://github.com/FDA/ecglib/, https://creativecommons.org/publicdomain/zero/1.0/ and https://www.gnu.org/licenses/gpl-faq.html for more details.
+ *
+ * @section DISCLAIMER
+ * This software and documentation were developed by the authors in their capacities as  Oak Ridge Institute for Science and Education (ORISE) research fellows at the U.S. Food and Drug Administration (FDA).
+ * FDA assumes no responsibility whatsoever for use by other parties of the Software, its source code, documentation or compiled executables, and makes no guarantees, expressed or implied, about its quality, reliability, or any other characteristic.  Further, FDA makes no representations that the use of the Software will not infringe any patent or proprietary rights of third parties.   The use of this code in no way implies endorsement by the FDA or confers any advantage in regulatory decisions.
+ *
+ * @section DESCRIPTION
+ * Compares the "exact" (default) and "fast" profiles of ecglib's T-wave delineator.
+ * This Program delineates every record listed in a validation file (e.g. validation.csv) with both profiles and reports
+ * the speedup of the fast profile and the distribution of the TPEAK/TEND deviations (fast - exact) in ms.
+ * Requirements:
+ *      - Validation file with header RECORD,ERROR,FILTER,RR,QON,RPEAK,QOFF,TPEAK,TPPEAK,TEND (rows with an ERROR are skipped).
+ *      - Physionet records (.hea, .dat) listed in the validation file (median beats sampled at 1000 Hz including vector magnitude lead).
+ * Arguments:
+ *      - validation	: validation file
+ *      - repeat	: number of times each record is delineated by each profile (timing)
+ *	- details	: If true then print one row per record with the annotations of both profiles before the summary
+ *
+ */
+
+//Prevent armadillo to print errors in standard output
+#define ARMA_DONT_PRINT_ERRORS
+
+#include <ecglib.hpp>
+#include <ecglib/delineator/twave.hpp>
+
+//Include filtering library
+#include "filters/butterworth/filter.hpp"
+
+//Include WFDB Library
+#include <wfdb/wfdb.h>
+#include <wfdb/ecgcodes.h>
+
+#include <stdexcept>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <tuple>
+#include <chrono>
+#include <algorithm>
+
+#include <cmath>
+#include <cstdlib>
+
+//Include Boost
+#include <boost/algorithm/string.hpp>
+#include <boost/program_options.hpp>
+
+
+using namespace ecglib;
+using namespace arma;
+using namespace std;
+
+
+/**
+ * @brief leadmap for WFDB library
+ *
+ * @param siarray array of WFDB signal info
+ * @param nsig number of signals
+ */
+ecgdata::leadmap getleadnames(WFDB_Siginfo *siarray, const int nsig);
+
+/**
+ * @brief Load physionet
+ *
+ * @param e ECGdata record
+ * @param rec Record
+ */
+void load_physionet(ecgdata &e, const char *rec);
+
+/**
+ * @brief Delineates the T-wave of a median beat
+ *
+ * @param ecg ECG (filtered if needed) with meanrr property
+ * @param pm Pointmap with global QON, RPEAK and QOFF
+ * @param tcfg T-wave delineator configuration
+ * @param repeat Number of delineations (timing)
+ * @param tpeak (out var) Tpeak in ms or -1
+ * @param tend (out var) Tend in ms or -1
+ *
+ * @return Average time of one delineation in microseconds
+ */
+double delineate(const ecgdata &ecg, const pointmap &pm, const twaveDelineator_config &tcfg, int repeat, int &tpeak, int &tend);
+
+/**
+ * @brief Prints the distribution of deviations
+ *
+ * @param name Name of annotation
+ * @param dev Deviations in ms
+ * @param missing Number of records with the annotation in only one of the profiles
+ */
+void summary(const std::string &name, std::vector<double> dev, std::size_t missing);
+
+int main(int argc, char **argv) {
+    try{
+	// Program options
+        boost::program_options::options_description generic("T-wave delineator profiles command line options");
+        generic.add_options()
+                ("help,h", "print this help")
+                ("validation",boost::program_options::value<std::string>()->default_value("validation.csv"),"Validation file listing the records and their QON, RPEAK, QOFF and RR")
+                ("repeat",boost::program_options::value<int>()->default_value(1),"Number of times each record is delineated by each profile")
+		("details",boost::program_options::value<bool>()->default_value(false),"Print one row per record with the annotations of both profiles");
+
+        boost::program_options::variables_map vm;
+        boost::program_options::store(boost::program_options::parse_command_line(argc, argv, generic), vm);
+        boost::program_options::notify(vm);
+
+        if(vm.count("help")) {
+            std::cout << std::endl << "Usage: twavedelineatorprofiles [options]" << std::endl;
+            std::cout << std::endl << generic << std::endl;
+            return EXIT_SUCCESS;
+        }
+
+        std::string validation = vm["validation"].as<std::string>();
+        int repeat = std::max(1, vm["repeat"].as<int>());
+        bool details = vm["details"].as<bool>();
+
+        std::ifstream in(validation.c_str());
+        if(!in) {
+            std::string line = std::string("Could not open file at ") + validation;
+            std::cerr << line << std::endl;
+            throw std::logic_error(line);
+        }
+
+        twaveDelineator_config exactcfg("exact");
+        twaveDelineator_config fastcfg("fast");
+
+        double timeexact = 0, timefast = 0;
+        std::size_t nrecords = 0, nfailed = 0, missingtpeak = 0, missingtend = 0;
+        std::vector<double> devtpeak, devtend;
+
+        if (details){
+            std::cout << "RECORD,FILTER,TPEAK_EXACT,TPEAK_FAST,TEND_EXACT,TEND_FAST,TIME_EXACT_US,TIME_FAST_US" << std::endl;
+        }
+
+        std::string line;
+        std::getline(in, line); // header
+        while(std::getline(in, line)) {
+            std::vector<std::string> cols;
+            boost::split(cols, line, boost::is_any_of(","));
+            if(cols.size() < 10 || !cols[1].empty()) continue; // skip rows with errors
+
+            std::string record = cols[0];
+            bool filterecg = std::stoi(cols[2]) != 0;
+            double rr = std::stod(cols[3]);
+            int qon = std::stoi(cols[4]);
+            int rpeak = std::stoi(cols[5]);
+            int qoff = std::stoi(cols[6]);
+
+            try{
+                ecgdata ecg;
+                load_physionet(ecg, record.c_str());
+
+                // Rescale the ECG signal from mV to uV
+                arma::mat data = ecg.data()*1000.0;
+                ecg.data() = data;
+
+                if (filterecg) {
+                    ecglibfilter::filter filterData;
+                    filterData(ecg);
+                }
+
+                if(ecg.fs() != 1000) {
+                    std::cerr << "** ERROR: " << "Sampling frequency for " << record << " is at " << ecg.fs() << " but 1000 Hz is required." << std::endl;
+                    ++nfailed;
+                    continue;
+                }
+
+                pointmap pm = ecg.pointsmap();
+                pm[GLOBAL_LEAD][qon] = annotation(qon, annotation_type::QON, GLOBAL_LEAD);
+                pm[GLOBAL_LEAD][rpeak] = annotation(rpeak, annotation_type::RPEAK, GLOBAL_LEAD);
+                pm[GLOBAL_LEAD][qoff] = annotation(qoff, annotation_type::QOFF, GLOBAL_LEAD);
+                ecg.setproperty("meanrr", ecglib::property(ecglib::Type::Double, rr));
+
+                int tpeakexact = -1, tendexact = -1, tpeakfast = -1, tendfast = -1;
+                double texact = delineate(ecg, pm, exactcfg, repeat, tpeakexact, tendexact);
+                double tfast = delineate(ecg, pm, fastcfg, repeat, tpeakfast, tendfast);
+
+                timeexact += texact;
+                timefast += tfast;
+                ++nrecords;
+
+                if(tpeakexact != -1 && tpeakfast != -1) devtpeak.push_back(tpeakfast - tpeakexact);
+                else if(tpeakexact != tpeakfast) ++missingtpeak;
+                if(tendexact != -1 && tendfast != -1) devtend.push_back(tendfast - tendexact);
+                else if(tendexact != tendfast) ++missingtend;
+
+                if (details){
+                    std::cout << record << "," << filterecg << "," << tpeakexact << "," << tpeakfast << "," << tendexact << "," << tendfast << "," << texact << "," << tfast << std::endl;
+                }
+            }catch(const std::exception &e){
+                std::cerr << std::endl << "Exception caught for " << record << ": " << e.what() << std::endl;
+                ++nfailed;
+            }
+        }
+
+        std::cout << "RECORDS," << nrecords << std::endl;
+        std::cout << "FAILED," << nfailed << std::endl;
+        std::cout << "TIME_EXACT_US," << timeexact << std::endl;
+        std::cout << "TIME_FAST_US," << timefast << std::endl;
+        std::cout << "SPEEDUP," << (timefast > 0 ? timeexact / timefast : 0) << std::endl;
+        std::cout << "ANNOTATION,N,MISSING,MEAN,SD,MEDIAN,P95ABS,MAXABS,EQUAL,WITHIN2MS,WITHIN5MS,WITHIN10MS" << std::endl;
+        summary("TPEAK", devtpeak, missingtpeak);
+        summary("TEND", devtend, missingtend);
+
+        return EXIT_SUCCESS;
+
+    }catch(const std::exception &e){
+        std::string line = std::string("Exception caught: ") + e.what();
+        std::cerr << std::endl << line << std::endl;
+    }catch(const char* e){
+        std::string line = std::string("Exception caught: ") + e;
+        std::cerr << std::endl << line << std::endl;
+    }catch(...){
+        std::string line = std::string("Unknown exception caught");
+        std::cerr << std::endl << line << std::endl;
+    }
+    return EXIT_FAILURE;
+}
+
+// ----------------------------
+// Functions implementations
+// ----------------------------
+
+ecgdata::leadmap getleadnames(WFDB_Siginfo *siarray, const int nsig) {
+        long nsamp = siarray[0].nsamp;
+        ecgdata::leadmap lm;
+        std::string nam2;
+
+        for(int i = 0; i < nsig; ++i) {
+                if(nsamp != siarray[i].nsamp){
+                        std::string line = std::string("Mismatch nsamp");
+                        std::cerr << line;
+                        throw std::runtime_error(line);
+                }
+
+                std::string nam(siarray[i].desc);
+                if(nam != std::string("ECG")) {
+                        nam2 = nam;
+                        std::transform(nam2.begin(), nam2.end(), nam2.begin(), ::tolower);
+                        if(nam2 == std::string("vx") || nam2 == std::string("vy") || nam2 == std::string("vz")){
+                                nam.erase(0,1);
+                        }
+                        boost::optional<ecglead> ll = ecglead::get_by_name(nam.c_str());
+                        if(ll) {
+                                ecgdata::leadmap::value_type lval(i,*ll);
+                                lm.insert(lval);
+                        }
+                }
+        }
+
+        return lm;
+}
+
+void load_physionet(ecgdata &e, const char *rec) {
+        char *rec2 = const_cast<char*>(rec);
+
+        double fs = sampfreq(rec2);
+
+        WFDB_Siginfo *siarray;
+
+        int nsig = isigopen(rec2,NULL,0);
+
+        siarray = (WFDB_Siginfo*)malloc(nsig*sizeof(WFDB_Siginfo));
+        nsig = isigopen(rec2,siarray,nsig);
+
+        if(nsig == -1) {
+                std::string line = std::string("Could not open file at ") + std::string(rec);
+                std::cerr << line << std::endl;
+                throw std::logic_error(line);
+        }
+        long nsamp = siarray[0].nsamp;
+        ecgdata::leadmap leadnames = getleadnames(siarray, nsig);
+        ecglib::ecgdata er(nsamp, nsig);
+        er.leadnames(leadnames);
+
+        WFDB_Sample *vin;
+        vin = (WFDB_Sample*)malloc(nsig*sizeof(WFDB_Sample));
+        for (int i = 0; i < nsamp; i++) {
+                getvec(vin);
+
+                for(int j = 0; j < nsig; ++j) er(j,i) = aduphys(j,vin[j]);
+        }
+
+        er.fs(fs);
+
+        free(siarray);
+
+        e = er;
+}
+
+double delineate(const ecgdata &ecg, const pointmap &pm, const twaveDelineator_config &tcfg, int repeat, int &tpeak, int &tend) {
+        int vcgidx = ecg.leadnum(ecglead::VCGMAG);
+        std::tuple<pointmap, ecglib::twaveDelineate::annotation> res;
+
+        auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < repeat; ++i) {
+                res = twaveDelineators(ecg, pm, tcfg);
+        }
+        auto stop = std::chrono::steady_clock::now();
+
+        vector<annotation> locs;
+        pointmap pmout = get<0>(res);
+        get_annotations(pmout, vcgidx, annotation_type::TPEAK, locs);
+        tpeak = (locs.size() == 1) ? static_cast<int>(locs[0].location()) : -1;
+        locs.clear();
+        get_annotations(pmout, vcgidx, annotation_type::TOFF, locs);
+        tend = (locs.size() == 1) ? static_cast<int>(locs[0].location()) : -1;
+
+        return std::chrono::duration<double, std::micro>(stop - start).count() / repeat;
+}
+
+void summary(const std::string &name, std::vector<double> dev, std::size_t missing) {
+        std::size_t n = dev.size();
+        double mean = 0, sd = 0, median = 0, p95 = 0, maxabs = 0;
+        std::size_t equal = 0, within2 = 0, within5 = 0, within10 = 0;
+
+        if(n > 0) {
+                for(double d : dev) mean += d;
+                mean /= n;
+                for(double d : dev) sd += (d - mean)*(d - mean);
+                sd = (n > 1) ? std::sqrt(sd / (n - 1)) : 0;
+
+                std::sort(dev.begin(), dev.end());
+                median = (n % 2) ? dev[n/2] : (dev[n/2 - 1] + dev[n/2]) / 2;
+
+                std::vector<double> absdev(n);
+                std::transform(dev.begin(), dev.end(), absdev.begin(), [](double d) { return std::abs(d); });
+                std::sort(absdev.begin(), absdev.end());
+                p95 = absdev[std::min(n - 1, static_cast<std::size_t>(std::ceil(0.95 * n)) - 1)];
+                maxabs = absdev[n - 1];
+
+                for(double d : absdev) {
+                        if(d == 0) ++equal;
+                        if(d <= 2) ++within2;
+                        if(d <= 5) ++within5;
+                        if(d <= 10) ++within10;
+                }
+        }
+
+        std::cout << name << "," << n << "," << missing << "," << mean << "," << sd << "," << median << "," << p95 << "," << maxabs << "," << equal << "," << within2 << "," << within5 << "," << within10 << std::endl;
+}